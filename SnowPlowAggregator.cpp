@@ -0,0 +1,198 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <string.h>
+#include "SnowPlowAggregator.h"
+
+/**
+ * Constructor for the SnowPlowAggregator
+ * class.
+ *
+ * @param aWindow How long in ms to
+ *        aggregate each event for
+ *        before its summary is sent
+ */
+SnowPlowAggregator::SnowPlowAggregator(const unsigned long aWindow) {
+  this->window = aWindow;
+  for (size_t i = 0; i < SNOWPLOW_AGGREGATE_SLOTS; i++) {
+    this->slots[i].statistics.count = 0;
+  }
+}
+
+/**
+ * Adds a value to the statistics for
+ * its event, starting a new window if
+ * there isn't one yet.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel The event's label, or NULL
+ * @param aProperty The event's property,
+ *        or NULL
+ * @param aValue The value to add
+ * @param aPrecision How many digits to
+ *        keep after the decimal sign
+ *        when the summary is sent
+ * @return true if the value was added,
+ *         false if every slot is in use
+ *         by other events
+ */
+bool SnowPlowAggregator::add(
+  const char *aCategory,
+  const char *aAction,
+  const char *aLabel,
+  const char *aProperty,
+  const double aValue,
+  const int aPrecision) {
+
+  Summary *slot = this->find(aCategory, aAction, aLabel, aProperty);
+  if (slot == NULL) {
+    // Start a new window in a free slot
+    slot = this->find(NULL, NULL, NULL, NULL);
+    if (slot == NULL) {
+      return false;
+    }
+    slot->category = aCategory;
+    slot->action = aAction;
+    slot->label = aLabel;
+    slot->property = aProperty;
+    slot->statistics.min = aValue;
+    slot->statistics.max = aValue;
+    slot->statistics.sum = 0;
+    slot->started = millis();
+  }
+
+  slot->statistics.count++;
+  slot->statistics.sum += aValue;
+  slot->statistics.last = aValue;
+  slot->statistics.precision = (byte)aPrecision;
+  if (aValue < slot->statistics.min) {
+    slot->statistics.min = aValue;
+  }
+  if (aValue > slot->statistics.max) {
+    slot->statistics.max = aValue;
+  }
+  return true;
+}
+
+/**
+ * Takes the statistics for an event
+ * whose window is over, freeing its
+ * slot.
+ *
+ * @param aSummary Where to copy the
+ *        statistics to
+ * @param aForce Whether to take the
+ *        oldest event even if its
+ *        window isn't over yet
+ * @return true if there was an event
+ *         to take
+ */
+bool SnowPlowAggregator::take(Summary &aSummary, const bool aForce) {
+  const unsigned long now = millis();
+  Summary *oldest = NULL;
+
+  for (size_t i = 0; i < SNOWPLOW_AGGREGATE_SLOTS; i++) {
+    Summary *slot = &this->slots[i];
+    if (slot->statistics.count == 0) {
+      continue;
+    }
+    if ((oldest == NULL) || (now - slot->started > now - oldest->started)) {
+      oldest = slot;
+    }
+  }
+
+  if ((oldest == NULL) || (!aForce && (now - oldest->started < this->window))) {
+    return false;
+  }
+
+  aSummary = *oldest;
+  oldest->statistics.count = 0;
+  return true;
+}
+
+/**
+ * @return true if no events are being
+ *         aggregated
+ */
+bool SnowPlowAggregator::isEmpty() const {
+  for (size_t i = 0; i < SNOWPLOW_AGGREGATE_SLOTS; i++) {
+    if (this->slots[i].statistics.count > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Finds the slot aggregating the given
+ * event. Pass all NULLs to find a free
+ * slot.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel The event's label
+ * @param aProperty The event's property
+ * @return the slot, or NULL if there
+ *         isn't one
+ */
+SnowPlowAggregator::Summary *SnowPlowAggregator::find(
+  const char *aCategory,
+  const char *aAction,
+  const char *aLabel,
+  const char *aProperty) {
+
+  const bool free = (aCategory == NULL);
+  for (size_t i = 0; i < SNOWPLOW_AGGREGATE_SLOTS; i++) {
+    Summary *slot = &this->slots[i];
+    if (free) {
+      if (slot->statistics.count == 0) {
+        return slot;
+      }
+    } else if ((slot->statistics.count > 0) &&
+               sameString(slot->category, aCategory) &&
+               sameString(slot->action, aAction) &&
+               sameString(slot->label, aLabel) &&
+               sameString(slot->property, aProperty)) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Compares two strings, either of which
+ * may be NULL. Usually they're the same
+ * literal, so we check the pointers first.
+ *
+ * @param aFirst The first string
+ * @param aSecond The second string
+ * @return true if they're the same
+ */
+bool SnowPlowAggregator::sameString(const char *aFirst, const char *aSecond) {
+  if (aFirst == aSecond) {
+    return true;
+  }
+  if ((aFirst == NULL) || (aSecond == NULL)) {
+    return false;
+  }
+  return (strcmp(aFirst, aSecond) == 0);
+}
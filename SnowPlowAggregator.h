@@ -0,0 +1,91 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowAggregator_h
+#define SnowPlowAggregator_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+// How many different events (by category,
+// action, label and property) we can
+// aggregate at once. It sizes the slots
+// array, so like SNOWPLOW_MAX_EVENT_LENGTH
+// it's a build flag for the whole library
+#ifndef SNOWPLOW_AGGREGATE_SLOTS
+#define SNOWPLOW_AGGREGATE_SLOTS 4
+#endif
+
+/**
+ * SnowPlowAggregator sums up events with
+ * numeric values over a time window, so
+ * that SnowPlowTracker can send one
+ * summary event per window (carrying the
+ * count, min, max, sum and last value)
+ * instead of one event per reading.
+ *
+ * Events are told apart by their category,
+ * action, label and property. Those strings
+ * are kept by pointer until the summary is
+ * sent, so they must stay put until then:
+ * string literals are ideal.
+ */
+class SnowPlowAggregator
+{
+ public:
+  // The running statistics for one event. A summary
+  // event's record keeps these in binary
+  typedef struct
+  {
+    unsigned long count; // Or 0 if the slot is free
+    double min;
+    double max;
+    double sum;
+    double last;
+    byte precision;
+  } Statistics;
+
+  // The event they're for, and when its window started
+  typedef struct
+  {
+    const char *category;
+    const char *action;
+    const char *label;
+    const char *property;
+    Statistics statistics;
+    unsigned long started; // millis() at the first value
+  } Summary;
+
+  SnowPlowAggregator(const unsigned long aWindow);
+
+  bool add(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const double aValue, const int aPrecision);
+  bool take(Summary &aSummary, const bool aForce);
+  bool isEmpty() const;
+
+ private:
+  Summary slots[SNOWPLOW_AGGREGATE_SLOTS];
+  unsigned long window;
+
+  Summary *find(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty);
+  static bool sameString(const char *aFirst, const char *aSecond);
+};
+
+#endif
@@ -0,0 +1,297 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <ctype.h>
+#include "SnowPlowClock.h"
+
+// Month names, as in a Date header but lower case
+static const char kMonthNames[] PROGMEM = "janfebmaraprmayjunjulaugsepoctnovdec";
+
+// The parts of a Date header, in order (after the day of the week)
+static const byte kDateDay = 1;
+static const byte kDateMonth = 2;
+static const byte kDateYear = 3;
+static const byte kDateHour = 4;
+static const byte kDateMinute = 5;
+static const byte kDateSecond = 6;
+
+/**
+ * Constructor for the SnowPlowClock
+ * class. Until it's set, times count
+ * from boot.
+ */
+SnowPlowClock::SnowPlowClock() {
+  this->unixTime = 0;
+  this->syncedAt = 0;
+  this->source = eUnset;
+  this->startDate();
+}
+
+/**
+ * Sets the clock exactly, e.g. from
+ * NTP, an RTC or GPS. Date headers are
+ * ignored from now on, so call it
+ * again every so often to keep it
+ * from drifting.
+ *
+ * @param aUnixTime The time in seconds
+ *        since 1970-01-01 UTC
+ * @param aAt The millis() it was that
+ *        time at
+ */
+void SnowPlowClock::set(const unsigned long aUnixTime, const unsigned long aAt) {
+  this->unixTime = aUnixTime;
+  this->syncedAt = aAt;
+  this->source = eExact;
+}
+
+/**
+ * @return true once we know the time,
+ *         from set() or a Date header
+ */
+bool SnowPlowClock::isSet() const {
+  return (this->source != eUnset);
+}
+
+/**
+ * @return true unless set() has been
+ *         called, so Date headers are
+ *         worth parsing
+ */
+bool SnowPlowClock::wantsDate() const {
+  return (this->source != eExact);
+}
+
+/**
+ * Works out the Unix time at a given
+ * millis().
+ *
+ * @param aMillis The millis() to
+ *        convert
+ * @param aNow millis() now, which
+ *        must be no earlier
+ * @return the time in seconds since
+ *         1970-01-01 UTC, or 0 if the
+ *         clock isn't set
+ */
+unsigned long SnowPlowClock::getUnixTime(const unsigned long aMillis, const unsigned long aNow) const {
+  if (!this->isSet()) {
+    return 0;
+  }
+  unsigned long seconds;
+  unsigned int millisPart;
+  this->getTime(aMillis, aNow, seconds, millisPart);
+  return seconds;
+}
+
+/**
+ * Writes out the time at a given
+ * millis() as ms since 1970-01-01 UTC
+ * (or since boot, if the clock isn't
+ * set), as the collector wants it.
+ *
+ * @param aOut Where to write to
+ * @param aMillis The millis() to
+ *        convert
+ * @param aNow millis() now, which
+ *        must be no earlier
+ */
+void SnowPlowClock::printTime(Print &aOut, const unsigned long aMillis, const unsigned long aNow) const {
+  unsigned long seconds;
+  unsigned int millisPart;
+  this->getTime(aMillis, aNow, seconds, millisPart);
+
+  // Printed as seconds then ms, to save on 64-bit arithmetic
+  if (seconds > 0) {
+    aOut.print(seconds);
+    if (millisPart < 100) {
+      aOut.print('0');
+    }
+    if (millisPart < 10) {
+      aOut.print('0');
+    }
+  }
+  aOut.print(millisPart);
+}
+
+/**
+ * Works out the time at a given
+ * millis(), by going back from now
+ * rather than forward from when we
+ * were set, so that millis() rolling
+ * over in between doesn't matter.
+ *
+ * @param aMillis The millis() to
+ *        convert
+ * @param aNow millis() now, which
+ *        must be no earlier
+ * @param aSeconds Set to the seconds
+ *        since 1970-01-01 UTC (or boot)
+ * @param aMillisPart Set to the ms
+ *        past aSeconds
+ */
+void SnowPlowClock::getTime(const unsigned long aMillis, const unsigned long aNow, unsigned long &aSeconds, unsigned int &aMillisPart) const {
+  const unsigned long elapsed = aNow - this->syncedAt;
+  const unsigned long age = aNow - aMillis;
+
+  aSeconds = this->unixTime + elapsed / 1000 - age / 1000;
+  int millisPart = (int)(elapsed % 1000) - (int)(age % 1000);
+  if (millisPart < 0) {
+    millisPart += 1000;
+    aSeconds--;
+  }
+  aMillisPart = millisPart;
+}
+
+/**
+ * Gets ready to parse a Date header's
+ * value.
+ */
+void SnowPlowClock::startDate() {
+  this->dateToken = 0;
+  this->inDateToken = false;
+  this->dateValue = 0;
+  this->dateDay = 0;
+  this->dateMonth = 0;
+  this->dateYear = 0;
+  this->dateHour = 0;
+  this->dateMinute = 0;
+  this->dateSecond = 0;
+}
+
+/**
+ * Parses the next char of a Date
+ * header's value. Only the format
+ * servers have to send (RFC 7231's
+ * IMF-fixdate) is understood.
+ *
+ * @param aChar The next char
+ */
+void SnowPlowClock::parseDate(const char aChar) {
+  if (isdigit(aChar)) {
+    if (this->dateValue < 10000) {
+      this->dateValue = this->dateValue * 10 + (aChar - '0');
+    }
+    this->inDateToken = true;
+  } else if (isalpha(aChar)) {
+    // Only the last 3 letters are kept, which is all a month name has
+    this->dateValue = (this->dateValue << 5) | (tolower(aChar) - 'a' + 1);
+    this->inDateToken = true;
+  } else if (this->inDateToken) {
+    // A space, comma or colon ends each part
+    this->endDateToken();
+  }
+}
+
+/**
+ * Finishes parsing a Date header and,
+ * if it made sense, sets the clock
+ * from it (unless set() has been
+ * called).
+ *
+ * @param aAt The millis() the header
+ *        was read at
+ * @return true if the Date made sense
+ */
+bool SnowPlowClock::endDate(const unsigned long aAt) {
+  if (this->inDateToken) {
+    this->endDateToken();
+  }
+  if ((this->dateToken <= kDateSecond) || (this->dateMonth == 0) ||
+      (this->dateDay < 1) || (this->dateDay > 31) || (this->dateYear < 1970) ||
+      (this->dateHour > 23) || (this->dateMinute > 59) || (this->dateSecond > 60)) {
+    return false;
+  }
+
+  if (this->source != eExact) {
+    this->unixTime = daysFromCivil(this->dateYear, this->dateMonth, this->dateDay) * 86400UL +
+                     this->dateHour * 3600UL + this->dateMinute * 60UL + this->dateSecond;
+    // The Date is cut down to the second: on average we're half way through it
+    this->syncedAt = aAt - 500;
+    this->source = eFromDate;
+  }
+  return true;
+}
+
+/**
+ * Stores the part of a Date header
+ * just read, and moves on to the
+ * next.
+ */
+void SnowPlowClock::endDateToken() {
+  switch (this->dateToken) {
+  case kDateDay:
+    this->dateDay = this->dateValue;
+    break;
+  case kDateMonth:
+    this->dateMonth = 0;
+    for (byte i = 0; i < 12; i++) {
+      unsigned int name = 0;
+      for (byte j = 0; j < 3; j++) {
+        name = (name << 5) | (pgm_read_byte(kMonthNames + i * 3 + j) - 'a' + 1);
+      }
+      if (name == this->dateValue) {
+        this->dateMonth = i + 1;
+        break;
+      }
+    }
+    break;
+  case kDateYear:
+    this->dateYear = this->dateValue;
+    break;
+  case kDateHour:
+    this->dateHour = this->dateValue;
+    break;
+  case kDateMinute:
+    this->dateMinute = this->dateValue;
+    break;
+  case kDateSecond:
+    this->dateSecond = this->dateValue;
+    break;
+  default:
+    break;
+  }
+
+  if (this->dateToken < 255) {
+    this->dateToken++;
+  }
+  this->inDateToken = false;
+  this->dateValue = 0;
+}
+
+/**
+ * Counts the days from 1970-01-01 to
+ * a date, using Howard Hinnant's
+ * days_from_civil() algorithm.
+ *
+ * @param aYear The year, from 1970
+ * @param aMonth The month, 1-12
+ * @param aDay The day of the month
+ * @return the number of days
+ */
+unsigned long SnowPlowClock::daysFromCivil(const unsigned int aYear, const byte aMonth, const byte aDay) {
+  const unsigned long year = aYear - (aMonth <= 2);
+  const unsigned long era = year / 400;
+  const unsigned long yearOfEra = year - era * 400;
+  const unsigned long dayOfYear = (153 * ((aMonth + 9) % 12) + 2) / 5 + aDay - 1;
+  const unsigned long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097UL + dayOfEra - 719468UL;
+}
@@ -0,0 +1,100 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowClock_h
+#define SnowPlowClock_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+/**
+ * SnowPlowClock turns millis() readings
+ * into wall-clock time, so that events
+ * can carry the time they happened
+ * however long they wait to be sent.
+ *
+ * It is set from the Date header of
+ * the collector's responses (parsed a
+ * char at a time, so no buffer is
+ * needed), which is good to about half
+ * a second, or exactly by set(), from
+ * NTP, an RTC or GPS, say. Once set
+ * exactly, Date headers are ignored.
+ *
+ * Until it's set, times count from
+ * boot. The collector can still work
+ * out when events happened from those,
+ * as it only needs the difference
+ * between when each was created and
+ * when it was sent.
+ *
+ * Times are worked out from millis()
+ * by unsigned subtraction, so they
+ * come out right across its rollover,
+ * as long as the clock was set, and
+ * the event happened, less than 49
+ * days before.
+ */
+class SnowPlowClock
+{
+ public:
+  SnowPlowClock();
+
+  void set(const unsigned long aUnixTime, const unsigned long aAt);
+  bool isSet() const;
+  bool wantsDate() const;
+  unsigned long getUnixTime(const unsigned long aMillis, const unsigned long aNow) const;
+  void printTime(Print &aOut, const unsigned long aMillis, const unsigned long aNow) const;
+
+  // Parsing an HTTP Date header's value, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+  void startDate();
+  void parseDate(const char aChar);
+  bool endDate(const unsigned long aAt);
+
+ private:
+  // Where a time came from, best last
+  typedef enum {
+    eUnset,
+    eFromDate,
+    eExact
+  } Source;
+
+  unsigned long unixTime; // Seconds at syncedAt
+  unsigned long syncedAt; // millis() when it was unixTime
+  byte source;
+
+  // Progress through a Date header
+  byte dateToken; // Which part we're reading
+  bool inDateToken;
+  unsigned int dateValue; // Digits, or letters 5 bits each
+  byte dateDay;
+  byte dateMonth;
+  unsigned int dateYear;
+  byte dateHour;
+  byte dateMinute;
+  byte dateSecond;
+
+  void getTime(const unsigned long aMillis, const unsigned long aNow, unsigned long &aSeconds, unsigned int &aMillisPart) const;
+  void endDateToken();
+  static unsigned long daysFromCivil(const unsigned int aYear, const byte aMonth, const byte aDay);
+};
+
+#endif
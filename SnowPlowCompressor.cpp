@@ -0,0 +1,259 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <string.h>
+#include "SnowPlowCompressor.h"
+
+// The gzip header: deflate, no name or timestamp, unknown OS
+static const byte kGzipHeader[] PROGMEM = { 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF };
+
+// Deflate's match lengths (codes 257-285) and distances (codes 0-29):
+// the smallest each code stands for, and its number of extra bits
+static const uint16_t kLengthBase[] PROGMEM = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const byte kLengthExtra[] PROGMEM = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t kDistanceBase[] PROGMEM = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+// CRC-32 a nibble at a time
+static const uint32_t kCrcTable[] PROGMEM = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * Constructor for the SnowPlowCompressor
+ * class.
+ */
+SnowPlowCompressor::SnowPlowCompressor() {
+  this->out = NULL;
+}
+
+/**
+ * Starts a new gzip stream.
+ *
+ * @param aOut Where to write the
+ *        compressed stream to
+ */
+void SnowPlowCompressor::begin(Print &aOut) {
+  this->out = &aOut;
+  memset(this->head, 0, sizeof(this->head));
+  this->next = 0;
+  this->length = 0;
+  this->crc = 0xFFFFFFFFUL;
+  this->bits = 0;
+  this->bitCount = 0;
+
+  for (size_t i = 0; i < sizeof(kGzipHeader); i++) {
+    this->out->write(pgm_read_byte(&kGzipHeader[i]));
+  }
+  // One final block, with fixed Huffman codes
+  this->writeBits(1, 1);
+  this->writeBits(1, 2);
+}
+
+/**
+ * Adds a byte to the stream, first
+ * encoding what we can if the
+ * lookahead is full.
+ *
+ * @param aChar The byte to write
+ * @return 1, the number of bytes
+ *         written
+ */
+size_t SnowPlowCompressor::write(uint8_t aChar) {
+  while (this->length - this->next >= kMaxMatch) {
+    this->encodeNext();
+  }
+  this->window[this->length & kWindowMask] = aChar;
+  this->length++;
+
+  this->crc ^= aChar;
+  this->crc = (this->crc >> 4) ^ pgm_read_dword(&kCrcTable[this->crc & 0x0F]);
+  this->crc = (this->crc >> 4) ^ pgm_read_dword(&kCrcTable[this->crc & 0x0F]);
+  return 1;
+}
+
+/**
+ * Encodes the rest of the stream and
+ * ends it with the gzip trailer.
+ */
+void SnowPlowCompressor::end() {
+  while (this->next < this->length) {
+    this->encodeNext();
+  }
+  this->writeLiteral(256); // End of block
+  this->writeBits(0, (8 - this->bitCount) & 7);
+
+  const unsigned long crc = ~this->crc;
+  for (byte i = 0; i < 4; i++) {
+    this->out->write((byte)(crc >> (8 * i)));
+  }
+  for (byte i = 0; i < 4; i++) {
+    this->out->write((byte)(this->length >> (8 * i)));
+  }
+}
+
+/**
+ * @param aPosition A position in the
+ *        stream, within the window
+ * @return the byte there
+ */
+byte SnowPlowCompressor::at(const unsigned long aPosition) const {
+  return this->window[aPosition & kWindowMask];
+}
+
+/**
+ * @param aPosition A position in the
+ *        stream, with at least
+ *        kMinMatch bytes from there on
+ * @return the hash of those bytes
+ */
+byte SnowPlowCompressor::hash(const unsigned long aPosition) const {
+  return ((this->at(aPosition) << 4) ^ (this->at(aPosition + 1) << 2) ^ this->at(aPosition + 2)) & ((1 << kHashBits) - 1);
+}
+
+/**
+ * Encodes the byte at next: as part
+ * of a match with earlier bytes if
+ * there's one long enough, else as a
+ * literal.
+ */
+void SnowPlowCompressor::encodeNext() {
+  const unsigned long available = this->length - this->next;
+  unsigned int matchLength = 0;
+  unsigned int distance = 0;
+
+  if (available >= kMinMatch) {
+    const byte h = this->hash(this->next);
+    distance = (Position)((Position)this->next - this->head[h]);
+    this->head[h] = (Position)this->next;
+
+    if ((distance > 0) && (distance <= kMaxDistance) && (distance <= this->next)) {
+      const unsigned int limit = (available < kMaxMatch) ? available : kMaxMatch;
+      while ((matchLength < limit) && (this->at(this->next - distance + matchLength) == this->at(this->next + matchLength))) {
+        matchLength++;
+      }
+    }
+  }
+
+  if (matchLength < kMinMatch) {
+    this->writeLiteral(this->at(this->next));
+    this->next++;
+    return;
+  }
+
+  this->writeMatch(matchLength, distance);
+  // Remember where the matched bytes were, for later matches
+  for (unsigned int i = 1; i < matchLength; i++) {
+    if (this->length - (this->next + i) >= kMinMatch) {
+      this->head[this->hash(this->next + i)] = (Position)(this->next + i);
+    }
+  }
+  this->next += matchLength;
+}
+
+/**
+ * Writes a literal/length symbol with
+ * its fixed Huffman code.
+ *
+ * @param aSymbol A byte, 256 for the
+ *        end of the block, or a
+ *        length code (257-285)
+ */
+void SnowPlowCompressor::writeLiteral(const unsigned int aSymbol) {
+  if (aSymbol < 144) {
+    this->writeCode(0x30 + aSymbol, 8);
+  } else if (aSymbol < 256) {
+    this->writeCode(0x190 + (aSymbol - 144), 9);
+  } else if (aSymbol < 280) {
+    this->writeCode(aSymbol - 256, 7);
+  } else {
+    this->writeCode(0xC0 + (aSymbol - 280), 8);
+  }
+}
+
+/**
+ * Writes a match: its length code and
+ * extra bits, then its distance code
+ * and extra bits.
+ *
+ * @param aLength The match's length
+ * @param aDistance How far back the
+ *        matching bytes are
+ */
+void SnowPlowCompressor::writeMatch(const unsigned int aLength, const unsigned int aDistance) {
+  byte code = 0;
+  while ((code < 28) && (pgm_read_word(&kLengthBase[code + 1]) <= aLength)) {
+    code++;
+  }
+  this->writeLiteral(257 + code);
+  this->writeBits(aLength - pgm_read_word(&kLengthBase[code]), pgm_read_byte(&kLengthExtra[code]));
+
+  code = 0;
+  while ((code < 29) && (pgm_read_word(&kDistanceBase[code + 1]) <= aDistance)) {
+    code++;
+  }
+  this->writeCode(code, 5);
+  this->writeBits(aDistance - pgm_read_word(&kDistanceBase[code]), (code < 4) ? 0 : (code / 2 - 1));
+}
+
+/**
+ * Writes a Huffman code, which goes
+ * most significant bit first.
+ *
+ * @param aCode The code
+ * @param aLength Its length in bits
+ */
+void SnowPlowCompressor::writeCode(unsigned int aCode, const byte aLength) {
+  unsigned int reversed = 0;
+  for (byte i = 0; i < aLength; i++) {
+    reversed = (reversed << 1) | (aCode & 1);
+    aCode >>= 1;
+  }
+  this->writeBits(reversed, aLength);
+}
+
+/**
+ * Writes bits to the stream, least
+ * significant first, passing on each
+ * byte once it's full.
+ *
+ * @param aValue The bits
+ * @param aCount How many of them (at
+ *        most 16)
+ */
+void SnowPlowCompressor::writeBits(const unsigned long aValue, const byte aCount) {
+  this->bits |= aValue << this->bitCount;
+  this->bitCount += aCount;
+  while (this->bitCount >= 8) {
+    this->out->write((byte)(this->bits & 0xFF));
+    this->bits >>= 8;
+    this->bitCount -= 8;
+  }
+}
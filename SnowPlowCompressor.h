@@ -0,0 +1,111 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowCompressor_h
+#define SnowPlowCompressor_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <Arduino.h>
+
+// Bytes of recent input the compressor can refer
+// back to, less its 64-byte lookahead. A power of 2.
+// The compressor takes the window and a hash table
+// of as many bytes again from the heap (10 more for
+// its state, plus malloc's overhead): about 535
+// bytes at 256, 1050 at 512. Events only compress
+// well against the one before if they fit in the
+// window: batched events take about 300 characters
+// of JSON each, so at 256 batches come out about
+// 3/4 of their size, and at 512 about 1/3. 512 is
+// too much for a 2 KB board like the Uno, so boards
+// with RAM to spare must opt in. Set it as a build
+// flag for the whole library (e.g. build_flags in
+// PlatformIO), not with a #define in the sketch
+#ifndef SNOWPLOW_COMPRESS_WINDOW
+#define SNOWPLOW_COMPRESS_WINDOW 256
+#endif
+
+/**
+ * SnowPlowCompressor gzips whatever is
+ * written to it, a byte at a time, and
+ * writes the result on to another Print.
+ * SnowPlowTracker uses it to compress
+ * batch POST bodies, whose keys and
+ * context repeat for every event.
+ *
+ * It's built to fit in about 535 bytes
+ * of RAM (see SNOWPLOW_COMPRESS_WINDOW):
+ * matches are looked for in a small
+ * window, through a hash of their
+ * first three bytes (with one candidate
+ * per hash, as in LZF), and are coded
+ * with deflate's fixed Huffman codes,
+ * so there are no tables to build or
+ * send.
+ */
+class SnowPlowCompressor : public Print
+{
+ public:
+  SnowPlowCompressor();
+
+  void begin(Print &aOut);
+  virtual size_t write(uint8_t aChar);
+  using Print::write;
+  void end();
+
+ private:
+  static const size_t kWindowMask = SNOWPLOW_COMPRESS_WINDOW - 1;
+  static const unsigned int kMinMatch = 3;
+  static const unsigned int kMaxMatch = 64; // Also the lookahead
+  static const unsigned int kMaxDistance = SNOWPLOW_COMPRESS_WINDOW - kMaxMatch;
+  static const byte kHashBits = 8;
+  static_assert((SNOWPLOW_COMPRESS_WINDOW & kWindowMask) == 0, "SNOWPLOW_COMPRESS_WINDOW must be a power of 2");
+  static_assert(SNOWPLOW_COMPRESS_WINDOW > kMaxMatch, "SNOWPLOW_COMPRESS_WINDOW must be bigger than the lookahead");
+
+  // Positions in the stream, modulo the window or more. Any
+  // older position this confuses with a newer one is a false
+  // match, which we throw out when its bytes don't match
+#if SNOWPLOW_COMPRESS_WINDOW > 256
+  typedef uint16_t Position;
+#else
+  typedef uint8_t Position;
+#endif
+
+  Print *out;
+  byte window[SNOWPLOW_COMPRESS_WINDOW];
+  Position head[1 << kHashBits]; // Latest position with each hash
+  unsigned long next; // Position of the next byte to encode
+  unsigned long length; // Bytes written to us
+  unsigned long crc;
+  unsigned long bits; // Waiting to be written, least significant first
+  byte bitCount;
+
+  byte at(const unsigned long aPosition) const;
+  byte hash(const unsigned long aPosition) const;
+  void encodeNext();
+  void writeLiteral(const unsigned int aSymbol);
+  void writeMatch(const unsigned int aLength, const unsigned int aDistance);
+  void writeCode(unsigned int aCode, const byte aLength);
+  void writeBits(const unsigned long aValue, const byte aCount);
+};
+
+#endif
@@ -0,0 +1,80 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowEepromStore_h
+#define SnowPlowEepromStore_h
+
+#include <EEPROM.h>
+#include "SnowPlowStore.h"
+
+/**
+ * SnowPlowEepromStore keeps the outbox in
+ * (part of) the Arduino's built-in EEPROM.
+ *
+ * Header-only, so sketches that don't use
+ * it don't need the EEPROM library. Remember
+ * to #include <EEPROM.h> in your sketch.
+ *
+ * ESP8266 and ESP32 cores emulate EEPROM
+ * in flash: call EEPROM.begin() with at
+ * least aStart + aSize bytes in setup()
+ * first. Writes only reach flash on
+ * commit(), which the outbox calls after
+ * each change.
+ */
+class SnowPlowEepromStore : public SnowPlowStore
+{
+ public:
+  /**
+   * @param aStart The first EEPROM address
+   *        to use
+   * @param aSize How many bytes to use
+   */
+  SnowPlowEepromStore(const size_t aStart, const size_t aSize) : start(aStart), length(aSize) {}
+
+  size_t size() const {
+    return this->length;
+  }
+
+  byte read(const size_t aAddress) {
+    return EEPROM.read(this->start + aAddress);
+  }
+
+  void write(const size_t aAddress, const byte aValue) {
+    // Each EEPROM cell is only good for ~100,000 writes
+    if (EEPROM.read(this->start + aAddress) != aValue) {
+      EEPROM.write(this->start + aAddress, aValue);
+    }
+  }
+
+#if defined(ESP8266) || defined(ESP32)
+  void commit() {
+    // Writes so far are only in the RAM copy
+    EEPROM.commit();
+  }
+#endif
+
+ private:
+  size_t start;
+  size_t length;
+};
+
+#endif
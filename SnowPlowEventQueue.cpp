@@ -0,0 +1,183 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "SnowPlowEventQueue.h"
+
+/**
+ * Constructor for the SnowPlowEventQueue
+ * class.
+ *
+ * @param aBuffer The storage to hold
+ *        queued events in. Must live as
+ *        long as the queue. NULL (with
+ *        a size of 0) for a queue that
+ *        never has room
+ * @param aSize The size of aBuffer
+ *        in bytes
+ */
+SnowPlowEventQueue::SnowPlowEventQueue(byte *aBuffer, const size_t aSize) {
+  this->buffer = aBuffer;
+  this->size = aSize;
+  this->clear();
+}
+
+/**
+ * Adds an event to the back of
+ * the queue.
+ *
+ * @param aData The encoded event
+ * @param aLength The length of aData
+ * @return true if the event was added,
+ *         false if there wasn't room
+ */
+bool SnowPlowEventQueue::push(const byte *aData, const size_t aLength) {
+  if (!this->hasRoomFor(aLength)) {
+    return false;
+  }
+
+  size_t tail = (this->head + this->used) % this->size;
+  this->buffer[tail] = (byte)aLength;
+  for (size_t i = 0; i < aLength; i++) {
+    tail = (tail + 1) % this->size;
+    this->buffer[tail] = aData[i];
+  }
+
+  this->used += aLength + 1;
+  this->entries++;
+  return true;
+}
+
+/**
+ * Copies a queued event, leaving it
+ * queued.
+ *
+ * @param aBuffer Where to copy the
+ *        event to
+ * @param aLength The size of aBuffer
+ * @param aPosition Which event to copy,
+ *        counting from 0 at the front
+ *        of the queue
+ * @return the length of the event, or
+ *         0 if there's no such event or
+ *         it doesn't fit
+ */
+size_t SnowPlowEventQueue::peek(byte *aBuffer, const size_t aLength, size_t aPosition) const {
+  if (aPosition >= this->entries) {
+    return 0;
+  }
+
+  size_t index = this->head;
+  while (aPosition-- > 0) {
+    index = (index + this->buffer[index] + 1) % this->size;
+  }
+
+  const size_t length = this->buffer[index];
+  if (length > aLength) {
+    return 0;
+  }
+  this->copyOut((index + 1) % this->size, aBuffer, length);
+  return length;
+}
+
+/**
+ * Drops the event at the front of
+ * the queue.
+ *
+ * @return true if an event was
+ *         dropped, false if the queue
+ *         was already empty
+ */
+bool SnowPlowEventQueue::pop() {
+  if (this->entries == 0) {
+    return false;
+  }
+
+  const size_t entryLength = this->buffer[this->head] + 1;
+  this->head = (this->head + entryLength) % this->size;
+  this->used -= entryLength;
+  this->entries--;
+  return true;
+}
+
+/**
+ * Drops every queued event.
+ */
+void SnowPlowEventQueue::clear() {
+  this->head = 0;
+  this->used = 0;
+  this->entries = 0;
+}
+
+/**
+ * Whether an event of the given
+ * length would fit in the queue
+ * right now.
+ *
+ * @param aLength The length of the
+ *        encoded event
+ * @return true if push() would
+ *         succeed
+ */
+bool SnowPlowEventQueue::hasRoomFor(const size_t aLength) const {
+  return (aLength <= kMaxEntryLength) && (this->used + aLength + 1 <= this->size);
+}
+
+/**
+ * @return true if no events are queued
+ */
+bool SnowPlowEventQueue::isEmpty() const {
+  return (this->entries == 0);
+}
+
+/**
+ * @return the number of queued events
+ */
+size_t SnowPlowEventQueue::count() const {
+  return this->entries;
+}
+
+/**
+ * @return the size of the buffer in
+ *         bytes, length bytes included
+ *         (so an event of up to
+ *         capacity() - 1 bytes fits
+ *         once the queue is empty)
+ */
+size_t SnowPlowEventQueue::capacity() const {
+  return this->size;
+}
+
+/**
+ * Copies bytes out of the ring,
+ * wrapping around its end.
+ *
+ * @param aIndex Where in the ring
+ *        to start copying from
+ * @param aBuffer Where to copy to
+ * @param aLength How many bytes
+ *        to copy
+ */
+void SnowPlowEventQueue::copyOut(size_t aIndex, byte *aBuffer, const size_t aLength) const {
+  for (size_t i = 0; i < aLength; i++) {
+    aBuffer[i] = this->buffer[aIndex];
+    aIndex = (aIndex + 1) % this->size;
+  }
+}
@@ -0,0 +1,66 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowEventQueue_h
+#define SnowPlowEventQueue_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+/**
+ * SnowPlowEventQueue is a fixed-capacity
+ * ring buffer of encoded events. Each
+ * event is stored as a length byte
+ * followed by its data, so short events
+ * take up less room than long ones.
+ *
+ * The queue never allocates: it works
+ * on a buffer owned by the caller.
+ */
+class SnowPlowEventQueue
+{
+ public:
+  // Longest event we can hold (its length must fit in one byte)
+  static const size_t kMaxEntryLength = 255;
+
+  SnowPlowEventQueue(byte *aBuffer, const size_t aSize);
+
+  bool push(const byte *aData, const size_t aLength);
+  size_t peek(byte *aBuffer, const size_t aLength, size_t aPosition = 0) const;
+  bool pop();
+  void clear();
+
+  bool hasRoomFor(const size_t aLength) const;
+  bool isEmpty() const;
+  size_t count() const;
+  size_t capacity() const;
+
+ private:
+  byte *buffer;
+  size_t size;
+  size_t head;  // Index of the oldest entry's length byte
+  size_t used;  // Bytes in use, including length bytes
+  size_t entries;
+
+  void copyOut(size_t aIndex, byte *aBuffer, const size_t aLength) const;
+};
+
+#endif
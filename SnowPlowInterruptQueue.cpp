@@ -0,0 +1,220 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "SnowPlowInterruptQueue.h"
+
+// Each index is stored with release and loaded with acquire
+// ordering, so an entry is always filled in before the index
+// that publishes it, and read before the index that frees it.
+// GCC and Clang's __atomic builtins order the hardware too, on
+// multi-core and weakly ordered boards (ESP32, RP2040, ARM); a
+// single-core AVR only needs the compiler kept in order
+#if !defined(__ATOMIC_ACQUIRE) && !defined(__AVR__)
+#error "SnowPlowInterruptQueue needs the __atomic builtins (GCC or Clang), or a single-core AVR"
+#endif
+
+static inline byte loadAcquire(const volatile byte &aIndex) {
+#if defined(__ATOMIC_ACQUIRE)
+  return __atomic_load_n(&aIndex, __ATOMIC_ACQUIRE);
+#else
+  const byte index = aIndex;
+  __asm__ __volatile__ ("" ::: "memory");
+  return index;
+#endif
+}
+
+static inline void storeRelease(volatile byte &aIndex, const byte aValue) {
+#if defined(__ATOMIC_ACQUIRE)
+  __atomic_store_n(&aIndex, aValue, __ATOMIC_RELEASE);
+#else
+  __asm__ __volatile__ ("" ::: "memory");
+  aIndex = aValue;
+#endif
+}
+
+/**
+ * Constructor for the SnowPlowInterruptQueue
+ * class.
+ */
+SnowPlowInterruptQueue::SnowPlowInterruptQueue() {
+  this->head = 0;
+  this->tail = 0;
+  this->dropped = 0;
+}
+
+/**
+ * Queues a structured event with no
+ * value. Safe to call from an
+ * interrupt handler.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel An optional label
+ * @param aProperty An optional property
+ * @return true if the event was queued,
+ *         false if the queue was full
+ */
+bool SnowPlowInterruptQueue::push(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty) {
+  Entry *entry = this->claim(aCategory, aAction, aLabel, aProperty);
+  if (entry == NULL) {
+    return false;
+  }
+  entry->valueType = eNoValue;
+  this->publish();
+  return true;
+}
+
+/**
+ * Queues a structured event with an
+ * int value. Safe to call from an
+ * interrupt handler.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel An optional label
+ * @param aProperty An optional property
+ * @param aValue The event's value
+ * @return true if the event was queued,
+ *         false if the queue was full
+ */
+bool SnowPlowInterruptQueue::push(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const int aValue) {
+  Entry *entry = this->claim(aCategory, aAction, aLabel, aProperty);
+  if (entry == NULL) {
+    return false;
+  }
+  entry->intValue = aValue;
+  entry->valueType = eIntValue;
+  this->publish();
+  return true;
+}
+
+/**
+ * Queues a structured event with a
+ * double (or float) value. Safe to
+ * call from an interrupt handler.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel An optional label
+ * @param aProperty An optional property
+ * @param aValue The event's value
+ * @param aValuePrecision How many digits
+ *        to keep after the decimal sign
+ * @return true if the event was queued,
+ *         false if the queue was full
+ */
+bool SnowPlowInterruptQueue::push(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const double aValue, const int aValuePrecision) {
+  Entry *entry = this->claim(aCategory, aAction, aLabel, aProperty);
+  if (entry == NULL) {
+    return false;
+  }
+  entry->doubleValue = aValue;
+  entry->valuePrecision = (byte)aValuePrecision;
+  entry->valueType = eDoubleValue;
+  this->publish();
+  return true;
+}
+
+/**
+ * Takes the oldest event off the
+ * queue. Call from loop() only.
+ *
+ * @param aEntry Where to copy the
+ *        event to
+ * @return true if there was an event
+ */
+bool SnowPlowInterruptQueue::pop(Entry &aEntry) {
+  const byte tail = this->tail; // Only we move it
+  const byte head = loadAcquire(this->head);
+  if (tail == head) {
+    return false;
+  }
+
+  aEntry = this->entries[tail];
+  storeRelease(this->tail, next(tail));
+  return true;
+}
+
+/**
+ * @return true if no events are
+ *         waiting
+ */
+bool SnowPlowInterruptQueue::isEmpty() const {
+  return (this->head == this->tail);
+}
+
+/**
+ * @return the number of events dropped
+ *         because the queue was full
+ */
+unsigned int SnowPlowInterruptQueue::getDroppedEvents() const {
+  // Too big to read atomically on AVR: read until it's steady
+  unsigned int dropped;
+  do {
+    dropped = this->dropped;
+  } while (dropped != this->dropped);
+  return dropped;
+}
+
+/**
+ * Finds the entry to write the next
+ * event to and fills in its strings.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel An optional label
+ * @param aProperty An optional property
+ * @return the entry, or NULL if the
+ *         queue is full
+ */
+SnowPlowInterruptQueue::Entry *SnowPlowInterruptQueue::claim(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty) {
+  const byte head = this->head; // Only we move it
+  const byte tail = loadAcquire(this->tail);
+  if (next(head) == tail) {
+    this->dropped++;
+    return NULL;
+  }
+
+  Entry *entry = &this->entries[head];
+  entry->category = aCategory;
+  entry->action = aAction;
+  entry->label = aLabel;
+  entry->property = aProperty;
+  entry->created = millis(); // Safe here: it doesn't wait on interrupts
+  return entry;
+}
+
+/**
+ * Makes the entry just claim()ed
+ * visible to pop().
+ */
+void SnowPlowInterruptQueue::publish() {
+  storeRelease(this->head, next(this->head));
+}
+
+/**
+ * @param aIndex An index into entries
+ * @return the index after it, wrapping
+ *         round at the end
+ */
+byte SnowPlowInterruptQueue::next(const byte aIndex) {
+  return (aIndex + 1 == SNOWPLOW_INTERRUPT_QUEUE_SIZE) ? 0 : aIndex + 1;
+}
@@ -0,0 +1,113 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowInterruptQueue_h
+#define SnowPlowInterruptQueue_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+// Events interrupt handlers can have
+// waiting to be picked up (one less
+// than this, in fact). At most 255. The
+// tracker holds one, so set it with the
+// library's other build flags
+#ifndef SNOWPLOW_INTERRUPT_QUEUE_SIZE
+#define SNOWPLOW_INTERRUPT_QUEUE_SIZE 8
+#endif
+
+/**
+ * SnowPlowInterruptQueue lets interrupt
+ * handlers track events. push() just
+ * copies the event's pointers and value
+ * into a ring, then SnowPlowTracker picks
+ * them up in update() and encodes and
+ * sends them as normal.
+ *
+ * There's one producer (interrupt
+ * handlers, which don't interrupt each
+ * other on AVR) and one consumer (loop()),
+ * each of which only ever moves its own
+ * index, so no locking is needed. The
+ * indices are single bytes, read with
+ * acquire and written with release
+ * ordering, so this holds on multi-core
+ * boards too, as long as the handlers
+ * that push() never run at the same
+ * time as each other (on an ESP32, say,
+ * attach them all on the same core).
+ * Without GCC or Clang's __atomic
+ * builtins it only compiles for AVR.
+ *
+ * The strings passed to push() must
+ * still be there when the event is
+ * picked up: string literals are ideal.
+ */
+class SnowPlowInterruptQueue
+{
+ public:
+  // The types of value an event can have
+  typedef enum {
+    eNoValue,
+    eIntValue,
+    eDoubleValue
+  } ValueType;
+
+  // An event waiting to be picked up
+  typedef struct
+  {
+    const char *category;
+    const char *action;
+    const char *label;
+    const char *property;
+    union {
+      int intValue;
+      double doubleValue;
+    };
+    byte valueType;
+    byte valuePrecision;
+    unsigned long created; // millis() when it was pushed
+  } Entry;
+
+  SnowPlowInterruptQueue();
+
+  // Safe to call from an interrupt handler
+  bool push(const char *aCategory, const char *aAction, const char *aLabel = NULL, const char *aProperty = NULL);
+  bool push(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const int aValue);
+  bool push(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const double aValue, const int aValuePrecision = 2);
+
+  // Call from loop() only
+  bool pop(Entry &aEntry);
+  bool isEmpty() const;
+  unsigned int getDroppedEvents() const;
+
+ private:
+  Entry entries[SNOWPLOW_INTERRUPT_QUEUE_SIZE];
+  volatile byte head; // Next entry to write: only push() moves it
+  volatile byte tail; // Next entry to read: only pop() moves it
+  volatile unsigned int dropped;
+
+  Entry *claim(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty);
+  void publish();
+  static byte next(const byte aIndex);
+};
+
+#endif
@@ -0,0 +1,286 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <string.h>
+#include <limits.h>
+#include "SnowPlowMetrics.h"
+
+// Upper limit (exclusive) of each latency bucket
+// in ms, but the last, which takes the rest
+static const unsigned int kBucketLimits[SnowPlowMetrics::kLatencyBuckets - 1] PROGMEM = {
+  10, 20, 50, 100, 200, 500, 1000
+};
+
+/**
+ * Constructor for the SnowPlowMetrics
+ * class.
+ */
+SnowPlowMetrics::SnowPlowMetrics() {
+  this->reset();
+}
+
+/**
+ * Sets every count back to zero.
+ */
+void SnowPlowMetrics::reset() {
+  this->tracked = 0;
+  this->sent = 0;
+  memset(this->failed, 0, sizeof(this->failed));
+  this->retries = 0;
+  this->dropped = 0;
+  this->bytesWritten = 0;
+  this->wakes = 0;
+  this->onTime = 0;
+  memset(&this->connectLatency, 0, sizeof(this->connectLatency));
+  memset(&this->sendLatency, 0, sizeof(this->sendLatency));
+  memset(&this->responseLatency, 0, sizeof(this->responseLatency));
+}
+
+/**
+ * Counts events that failed with the
+ * given status.
+ *
+ * @param aStatus The ERROR_* value
+ *        they failed with. Anything
+ *        else is ignored
+ * @param aEvents How many events
+ */
+void SnowPlowMetrics::addFailed(const int aStatus, const unsigned long aEvents) {
+  if ((aStatus < 0) && (aStatus >= -(int)kErrorCodes)) {
+    this->failed[-aStatus - 1] += aEvents;
+  }
+}
+
+/**
+ * @param aStatus An ERROR_* value
+ * @return how many events have failed
+ *         with it
+ */
+unsigned long SnowPlowMetrics::getFailed(const int aStatus) const {
+  if ((aStatus < 0) && (aStatus >= -(int)kErrorCodes)) {
+    return this->failed[-aStatus - 1];
+  }
+  return 0;
+}
+
+/**
+ * Adds one request's latency to a
+ * histogram. Bucket counts stop at
+ * their maximum rather than wrap.
+ *
+ * @param aHistogram The histogram
+ * @param aLatency The latency in ms
+ */
+void SnowPlowMetrics::addLatency(Histogram &aHistogram, const unsigned long aLatency) {
+  byte bucket = 0;
+  while ((bucket < kLatencyBuckets - 1) && (aLatency >= getBucketLimit(bucket))) {
+    bucket++;
+  }
+  if (aHistogram.buckets[bucket] < UINT_MAX) {
+    aHistogram.buckets[bucket]++;
+  }
+
+  aHistogram.count++;
+  aHistogram.total += aLatency;
+  if (aLatency > aHistogram.max) {
+    aHistogram.max = aLatency;
+  }
+}
+
+/**
+ * @param aBucket A histogram bucket
+ * @return the latency in ms below
+ *         which requests go in the
+ *         bucket (if not an earlier
+ *         one), or 0 for the last
+ *         bucket, which has no limit
+ */
+unsigned int SnowPlowMetrics::getBucketLimit(const byte aBucket) {
+  if (aBucket >= kLatencyBuckets - 1) {
+    return 0;
+  }
+  return pgm_read_word(&kBucketLimits[aBucket]);
+}
+
+/**
+ * Estimates what each event costs in
+ * energy, for duty-cycled boards.
+ *
+ * @return the ms the network was up
+ *         for per event sent, or 0 if
+ *         none have been
+ */
+unsigned long SnowPlowMetrics::getOnTimePerEvent() const {
+  return (this->sent == 0) ? 0 : this->onTime / this->sent;
+}
+
+/**
+ * Writes the counts out as compact
+ * name=value pairs, separated by ';'
+ * like "n=12;ok=10;retry=1;drop=0;
+ * bytes=2345;e1=2;wakes=3;on=40;
+ * conn=18/40;send=3/5;resp=95/210".
+ * eN is the number of events failed
+ * with ERROR_* value -N, given only if
+ * there were any; wakes and on (ms the
+ * network was up per event sent) only
+ * when duty cycling; each latency is
+ * the mean/max in ms, given only once
+ * there's been a request.
+ *
+ * @param aOut Where to write to
+ */
+void SnowPlowMetrics::print(Print &aOut) const {
+  aOut.print(F("n="));
+  aOut.print(this->tracked);
+  aOut.print(F(";ok="));
+  aOut.print(this->sent);
+  aOut.print(F(";retry="));
+  aOut.print(this->retries);
+  aOut.print(F(";drop="));
+  aOut.print(this->dropped);
+  aOut.print(F(";bytes="));
+  aOut.print(this->bytesWritten);
+
+  for (byte i = 0; i < kErrorCodes; i++) {
+    if (this->failed[i] > 0) {
+      aOut.print(F(";e"));
+      aOut.print(i + 1);
+      aOut.print(F("="));
+      aOut.print(this->failed[i]);
+    }
+  }
+
+  if (this->wakes > 0) {
+    aOut.print(F(";wakes="));
+    aOut.print(this->wakes);
+    aOut.print(F(";on="));
+    aOut.print(this->getOnTimePerEvent());
+  }
+
+  printLatency(aOut, F(";conn="), this->connectLatency);
+  printLatency(aOut, F(";send="), this->sendLatency);
+  printLatency(aOut, F(";resp="), this->responseLatency);
+}
+
+/**
+ * Writes a histogram's mean and max,
+ * if it has any requests in it.
+ *
+ * @param aOut Where to write to
+ * @param aName What to write first
+ * @param aHistogram The histogram
+ */
+void SnowPlowMetrics::printLatency(Print &aOut, const __FlashStringHelper *aName, const Histogram &aHistogram) {
+  if (aHistogram.count == 0) {
+    return;
+  }
+  aOut.print(aName);
+  aOut.print(aHistogram.total / aHistogram.count);
+  aOut.print(F("/"));
+  aOut.print(aHistogram.max);
+}
+
+/**
+ * Takes a copy of the counts, with
+ * each latency histogram boiled down
+ * to its mean and max (both 0 if it
+ * has no requests in it).
+ *
+ * @param aSnapshot Where to copy them to
+ */
+void SnowPlowMetrics::snapshot(Snapshot &aSnapshot) const {
+  aSnapshot.tracked = this->tracked;
+  aSnapshot.sent = this->sent;
+  memcpy(aSnapshot.failed, this->failed, sizeof(aSnapshot.failed));
+  aSnapshot.retries = this->retries;
+  aSnapshot.dropped = this->dropped;
+  aSnapshot.bytesWritten = this->bytesWritten;
+  aSnapshot.wakes = this->wakes;
+  aSnapshot.onTimePerEvent = this->getOnTimePerEvent();
+
+  const Histogram *histograms[3] = { &this->connectLatency, &this->sendLatency, &this->responseLatency };
+  for (byte i = 0; i < 3; i++) {
+    aSnapshot.latency[i][0] = (histograms[i]->count == 0) ? 0 : histograms[i]->total / histograms[i]->count;
+    aSnapshot.latency[i][1] = histograms[i]->max;
+  }
+}
+
+/**
+ * Writes a snapshot out as the data
+ * of a tracker_metrics (1-0-0) JSON,
+ * like {"tracked":12,"sent":10,
+ * "failed":[2,0,0,0,0,0,0,0],
+ * "retries":1,"dropped":0,
+ * "bytesWritten":2345,"wakes":3,
+ * "onTimePerEvent":40,"connect":
+ * {"mean":18,"max":40},"send":{...},
+ * "response":{...}}. failed[i] is the
+ * number of events failed with
+ * ERROR_* value -(i + 1).
+ *
+ * @param aOut Where to write to
+ * @param aSnapshot The counts
+ */
+void SnowPlowMetrics::printJson(Print &aOut, const Snapshot &aSnapshot) {
+  aOut.print(F("{\"tracked\":"));
+  aOut.print(aSnapshot.tracked);
+  aOut.print(F(",\"sent\":"));
+  aOut.print(aSnapshot.sent);
+  aOut.print(F(",\"failed\":["));
+  for (byte i = 0; i < kErrorCodes; i++) {
+    if (i > 0) {
+      aOut.write(',');
+    }
+    aOut.print(aSnapshot.failed[i]);
+  }
+  aOut.print(F("],\"retries\":"));
+  aOut.print(aSnapshot.retries);
+  aOut.print(F(",\"dropped\":"));
+  aOut.print(aSnapshot.dropped);
+  aOut.print(F(",\"bytesWritten\":"));
+  aOut.print(aSnapshot.bytesWritten);
+  aOut.print(F(",\"wakes\":"));
+  aOut.print(aSnapshot.wakes);
+  aOut.print(F(",\"onTimePerEvent\":"));
+  aOut.print(aSnapshot.onTimePerEvent);
+  printJsonLatency(aOut, F(",\"connect\":"), aSnapshot.latency[0]);
+  printJsonLatency(aOut, F(",\"send\":"), aSnapshot.latency[1]);
+  printJsonLatency(aOut, F(",\"response\":"), aSnapshot.latency[2]);
+  aOut.write('}');
+}
+
+/**
+ * Writes one step's latency as a
+ * JSON object of its mean and max.
+ *
+ * @param aOut Where to write to
+ * @param aName What to write first
+ * @param aLatency The mean and max
+ */
+void SnowPlowMetrics::printJsonLatency(Print &aOut, const __FlashStringHelper *aName, const unsigned long *aLatency) {
+  aOut.print(aName);
+  aOut.print(F("{\"mean\":"));
+  aOut.print(aLatency[0]);
+  aOut.print(F(",\"max\":"));
+  aOut.print(aLatency[1]);
+  aOut.write('}');
+}
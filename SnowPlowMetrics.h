@@ -0,0 +1,110 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowMetrics_h
+#define SnowPlowMetrics_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+/**
+ * SnowPlowMetrics keeps count of how
+ * SnowPlowTracker is getting on: the
+ * events it has tracked, sent and
+ * failed to send (by ERROR_* code),
+ * its retries and drops, the bytes it
+ * has written, how long it kept the
+ * network up for when duty cycling,
+ * and histograms of how long
+ * connecting, sending and waiting for
+ * the response take.
+ *
+ * Counts are kept from boot (or the
+ * last reset()), so that nothing is
+ * lost if a metrics event goes
+ * missing: take the difference
+ * between two readings for a rate.
+ */
+class SnowPlowMetrics
+{
+ public:
+  // Buckets in each latency histogram (see getBucketLimit)
+  static const byte kLatencyBuckets = 8;
+  // ERROR_* codes we count, from -1 down
+  static const byte kErrorCodes = 8;
+
+  // How long one step of a request took, over many requests
+  typedef struct
+  {
+    unsigned int buckets[kLatencyBuckets]; // Requests by latency
+    unsigned long count;
+    unsigned long total; // ms
+    unsigned long max; // ms
+  } Histogram;
+
+  // The counts a metrics event carries, as they were when it
+  // was tracked (see SnowPlowTracker::setMetricsInterval)
+  typedef struct
+  {
+    unsigned long tracked;
+    unsigned long sent;
+    unsigned long failed[kErrorCodes];
+    unsigned long retries;
+    unsigned long dropped;
+    unsigned long bytesWritten;
+    unsigned long wakes;
+    unsigned long onTimePerEvent;
+    unsigned long latency[3][2]; // Mean and max ms connecting, sending and waiting
+  } Snapshot;
+
+  SnowPlowMetrics();
+
+  void reset();
+  void addFailed(const int aStatus, const unsigned long aEvents);
+  unsigned long getFailed(const int aStatus) const;
+  unsigned long getOnTimePerEvent() const;
+  void print(Print &aOut) const;
+  void snapshot(Snapshot &aSnapshot) const;
+
+  static void printJson(Print &aOut, const Snapshot &aSnapshot);
+
+  static void addLatency(Histogram &aHistogram, const unsigned long aLatency);
+  static unsigned int getBucketLimit(const byte aBucket);
+
+  unsigned long tracked; // Events accepted for sending
+  unsigned long sent; // Events the collector took
+  unsigned long failed[kErrorCodes]; // Failed events (each attempt) by ERROR_* code
+  unsigned long retries; // Requests retried after a failure
+  unsigned long dropped; // Events lost to a full queue or outbox
+  unsigned long bytesWritten; // Bytes sent to the collector over HTTP, headers included
+  unsigned long wakes; // Times the network was powered up (when duty cycling)
+  unsigned long onTime; // ms it was up for, over the bursts that have ended
+
+  Histogram connectLatency; // Connecting, including any DNS lookup
+  Histogram sendLatency; // Writing the request
+  Histogram responseLatency; // Waiting for the response
+
+ private:
+  static void printLatency(Print &aOut, const __FlashStringHelper *aName, const Histogram &aHistogram);
+  static void printJsonLatency(Print &aOut, const __FlashStringHelper *aName, const unsigned long *aLatency);
+};
+
+#endif
@@ -0,0 +1,180 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "SnowPlowNumber.h"
+
+// Powers of ten up to 10^kMaxPrecision
+static const unsigned long kPowersOfTen[] PROGMEM = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL,
+  1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+/**
+ * Writes an integer as a decimal
+ * string.
+ *
+ * @param aBuffer Where to write the
+ *        string: at least kMaxLength
+ *        chars
+ * @param aInt The integer to write
+ * @return the length of the string,
+ *         not counting its '\0'
+ */
+size_t SnowPlowNumber::formatInt(char *aBuffer, const long aInt) {
+  if (aInt < 0) {
+    aBuffer[0] = '-';
+    // Negate as unsigned, so LONG_MIN doesn't overflow
+    return 1 + formatDigits(aBuffer + 1, 0UL - (unsigned long)aInt, 1);
+  }
+  return formatDigits(aBuffer, (unsigned long)aInt, 1);
+}
+
+/**
+ * Writes a double (or a float) as a
+ * decimal string with a fixed number
+ * of digits after the decimal point.
+ *
+ * @param aBuffer Where to write the
+ *        string: at least kMaxLength
+ *        chars
+ * @param aDouble The double to write
+ * @param aPrecision How many digits to
+ *        write after the decimal point,
+ *        up to kMaxPrecision
+ * @return the length of the string,
+ *         not counting its '\0': 0 for
+ *         NaN or infinity
+ */
+size_t SnowPlowNumber::formatDouble(char *aBuffer, double aDouble, byte aPrecision) {
+  if (isnan(aDouble) || isinf(aDouble)) {
+    aBuffer[0] = '\0';
+    return 0;
+  }
+
+  size_t length = 0;
+  if (aDouble < 0) {
+    aBuffer[length++] = '-';
+    aDouble = -aDouble;
+  }
+  if (aPrecision > kMaxPrecision) {
+    aPrecision = kMaxPrecision;
+  }
+
+  if (aDouble >= 4294967295.0) {
+    // Too big to split into unsigned longs
+    return length + formatExponent(aBuffer + length, aDouble);
+  }
+
+  // Split at the decimal point, then round the fraction
+  const unsigned long scale = pgm_read_dword(&kPowersOfTen[aPrecision]);
+  unsigned long whole = (unsigned long)aDouble;
+  unsigned long fraction = (unsigned long)((aDouble - whole) * scale + 0.5);
+  if (fraction >= scale) {
+    // It rounded up to the next whole number
+    whole++;
+    fraction -= scale;
+  }
+
+  length += formatDigits(aBuffer + length, whole, 1);
+  if (aPrecision > 0) {
+    aBuffer[length++] = '.';
+    length += formatDigits(aBuffer + length, fraction, aPrecision);
+  }
+  return length;
+}
+
+/**
+ * Writes a large positive double in
+ * exponent form, e.g. "4.294967295e9",
+ * with up to kMaxPrecision digits after
+ * the decimal point (trailing zeros are
+ * left off).
+ *
+ * @param aBuffer Where to write it
+ * @param aDouble The double to write:
+ *        at least 10, and finite
+ * @return the length of the string,
+ *         not counting its '\0'
+ */
+size_t SnowPlowNumber::formatExponent(char *aBuffer, double aDouble) {
+  // Bring it down to one digit before the decimal point
+  int exponent = 0;
+  while (aDouble >= 10.0) {
+    aDouble /= 10.0;
+    exponent++;
+  }
+
+  const unsigned long scale = pgm_read_dword(&kPowersOfTen[kMaxPrecision]);
+  unsigned long whole = (unsigned long)aDouble;
+  unsigned long fraction = (unsigned long)((aDouble - whole) * scale + 0.5);
+  if (fraction >= scale) {
+    // It rounded up to the next digit, maybe to 10
+    whole++;
+    fraction -= scale;
+    if (whole == 10) {
+      whole = 1;
+      exponent++;
+    }
+  }
+
+  size_t length = formatDigits(aBuffer, whole, 1);
+  if (fraction > 0) {
+    byte digits = kMaxPrecision;
+    while (fraction % 10 == 0) {
+      fraction /= 10;
+      digits--;
+    }
+    aBuffer[length++] = '.';
+    length += formatDigits(aBuffer + length, fraction, digits);
+  }
+  aBuffer[length++] = 'e';
+  return length + formatDigits(aBuffer + length, (unsigned long)exponent, 1);
+}
+
+/**
+ * Writes the decimal digits of an
+ * unsigned number, most significant
+ * first.
+ *
+ * @param aBuffer Where to write them
+ * @param aNumber The number to write
+ * @param aMinDigits How many digits
+ *        to write at least, padding
+ *        with leading zeros
+ * @return how many digits were
+ *         written, not counting the
+ *         '\0' after them
+ */
+size_t SnowPlowNumber::formatDigits(char *aBuffer, unsigned long aNumber, const byte aMinDigits) {
+  // Fill in from the right, then move into place
+  char digits[3 * sizeof(unsigned long)];
+  size_t count = 0;
+  do {
+    digits[count++] = '0' + (char)(aNumber % 10);
+    aNumber /= 10;
+  } while ((aNumber > 0) || (count < aMinDigits));
+
+  for (size_t i = 0; i < count; i++) {
+    aBuffer[i] = digits[count - 1 - i];
+  }
+  aBuffer[count] = '\0';
+  return count;
+}
@@ -0,0 +1,64 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowNumber_h
+#define SnowPlowNumber_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+/**
+ * SnowPlowNumber turns ints and doubles
+ * into decimal strings, in place of
+ * snprintf() and dtostrf(). Those pull
+ * the whole printf machinery into the
+ * sketch and are slow on AVR; we only
+ * ever need plain fixed-point output.
+ *
+ * Doubles come out like dtostrf() with
+ * a width of 1: rounded half away from
+ * zero to the given precision. Values
+ * too big to fit an unsigned long are
+ * written in exponent form instead, to
+ * ten significant digits: "1.5e20".
+ * NaN and infinity aren't numbers a
+ * collector can read, so for those we
+ * write nothing at all.
+ */
+class SnowPlowNumber
+{
+ public:
+  // Most digits after the decimal point
+  static const byte kMaxPrecision = 9;
+  // Longest string we write, with its '\0':
+  // "-4294967295.123456789" (an exponent
+  // form is at most "-1.797693135e308")
+  static const size_t kMaxLength = 22;
+
+  static size_t formatInt(char *aBuffer, const long aInt);
+  static size_t formatDouble(char *aBuffer, double aDouble, byte aPrecision);
+
+ private:
+  static size_t formatExponent(char *aBuffer, double aDouble);
+  static size_t formatDigits(char *aBuffer, unsigned long aNumber, const byte aMinDigits);
+};
+
+#endif
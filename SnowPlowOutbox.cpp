@@ -0,0 +1,311 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "SnowPlowOutbox.h"
+
+/**
+ * Constructor for the SnowPlowOutbox
+ * class. Call begin() before use.
+ *
+ * @param aStore The persistent storage
+ *        to keep events in
+ * @param aBlockSize The size of each
+ *        block of storage. Smaller
+ *        blocks waste less space on
+ *        short events, but cost one
+ *        byte each in overhead
+ */
+SnowPlowOutbox::SnowPlowOutbox(SnowPlowStore *aStore, const size_t aBlockSize) {
+  this->store = aStore;
+  this->blockSize = aBlockSize;
+  this->blocks = aStore->size() / aBlockSize;
+  this->head = 0;
+  this->tail = 0;
+  this->entries = 0;
+}
+
+/**
+ * Finds the events left pending in
+ * the store, e.g. from before a reboot.
+ *
+ * Pending events are written in order
+ * round the blocks, so they form either
+ * one run, or (if they wrapped round
+ * the end of the store) a run starting
+ * at block 0 followed later on by the
+ * run holding the oldest events.
+ */
+void SnowPlowOutbox::begin() {
+  size_t firstRunEnd = 0;
+  size_t secondRunStart = 0;
+  size_t lastRecordEnd = 0;
+  bool inFirstRun = false;
+  bool firstRunDone = false;
+  bool inSecondRun = false;
+  bool firstRunFromZero = false;
+
+  this->entries = 0;
+  this->head = 0;
+
+  size_t block = 0;
+  while (block < this->blocks) {
+    const size_t length = this->recordBlocks(block);
+    if (length == 0) {
+      // Free, a continuation of an overwritten event, or junk
+      if (inFirstRun) {
+        inFirstRun = false;
+        firstRunDone = true;
+      }
+      block++;
+      continue;
+    }
+
+    const bool pending = (this->store->read(block * this->blockSize) == kPending);
+    lastRecordEnd = block + length;
+
+    if (pending) {
+      if (!firstRunDone) {
+        if (!inFirstRun) {
+          inFirstRun = true;
+          firstRunFromZero = (block == 0);
+          this->head = block;
+        }
+        firstRunEnd = block + length;
+        this->entries++;
+      } else if (firstRunFromZero) {
+        // The older events, from before we wrapped
+        if (!inSecondRun) {
+          inSecondRun = true;
+          secondRunStart = block;
+        }
+        this->entries++;
+      }
+    } else if (inFirstRun) {
+      inFirstRun = false;
+      firstRunDone = true;
+    }
+    block += length;
+  }
+
+  if (this->entries == 0) {
+    // Carry on after the last event written, to spread the wear
+    this->head = (lastRecordEnd < this->blocks) ? lastRecordEnd : 0;
+    this->tail = this->head;
+  } else {
+    this->tail = firstRunEnd;
+    if (inSecondRun) {
+      this->head = secondRunStart;
+    }
+  }
+}
+
+/**
+ * Appends an event to the outbox.
+ *
+ * @param aData The encoded event
+ * @param aLength The length of aData
+ * @return true if the event was stored,
+ *         false if there wasn't room
+ */
+bool SnowPlowOutbox::push(const byte *aData, const size_t aLength) {
+  const size_t needed = this->blocksFor(aLength);
+  if ((aLength > 255) || (needed >= this->blocks)) {
+    return false;
+  }
+
+  // Once wrapped round, we always leave a gap of at least one
+  // block before head so that begin() can tell where it is
+  size_t start = this->tail;
+  if ((this->entries == 0) || (this->tail > this->head)) {
+    // Free space runs to the end of the store, then from block 0 up to head
+    if (start + needed > this->blocks) {
+      if ((this->entries > 0) && (needed >= this->head)) {
+        return false;
+      }
+      start = 0;
+    }
+  } else if (start + needed >= this->head) {
+    // Free space runs from tail up to head
+    return false;
+  }
+
+  // Write the event before its status, so it's never seen half-written
+  this->writeData(start, aData, aLength);
+  this->store->write(start * this->blockSize + 1, (byte)aLength);
+  this->store->write(start * this->blockSize, kPending);
+  this->store->commit();
+
+  if (this->entries == 0) {
+    this->head = start;
+  }
+  this->tail = start + needed;
+  this->entries++;
+  return true;
+}
+
+/**
+ * Copies a pending event, leaving it
+ * in the outbox.
+ *
+ * @param aBuffer Where to copy the
+ *        event to
+ * @param aLength The size of aBuffer
+ * @param aPosition Which event to copy,
+ *        counting from 0 for the oldest
+ * @return the length of the event, or
+ *         0 if there's no such event or
+ *         it doesn't fit
+ */
+size_t SnowPlowOutbox::peek(byte *aBuffer, const size_t aLength, size_t aPosition) {
+  if (aPosition >= this->entries) {
+    return 0;
+  }
+
+  size_t block = this->head;
+  while (aPosition-- > 0) {
+    block = this->nextPending(block);
+  }
+
+  const size_t length = this->store->read(block * this->blockSize + 1);
+  if (length > aLength) {
+    return 0;
+  }
+
+  size_t address = block * this->blockSize + 2;
+  for (size_t i = 0; i < length; i++) {
+    if (address % this->blockSize == 0) {
+      address++; // Skip the continuation marker
+    }
+    aBuffer[i] = this->store->read(address++);
+  }
+  return length;
+}
+
+/**
+ * Marks the oldest pending event as
+ * sent.
+ *
+ * @return true if an event was marked,
+ *         false if the outbox was empty
+ */
+bool SnowPlowOutbox::pop() {
+  if (this->entries == 0) {
+    return false;
+  }
+
+  const size_t next = this->nextPending(this->head);
+  this->store->write(this->head * this->blockSize, kSent);
+  this->store->commit();
+
+  this->entries--;
+  this->head = (this->entries == 0) ? this->tail : next;
+  return true;
+}
+
+/**
+ * @return true if no events are pending
+ */
+bool SnowPlowOutbox::isEmpty() const {
+  return (this->entries == 0);
+}
+
+/**
+ * @return the number of pending events
+ */
+size_t SnowPlowOutbox::count() const {
+  return this->entries;
+}
+
+/**
+ * How many blocks an event of the
+ * given length takes up.
+ *
+ * @param aLength The length of the
+ *        encoded event
+ * @return the number of blocks
+ */
+size_t SnowPlowOutbox::blocksFor(const size_t aLength) const {
+  const size_t firstBlockData = this->blockSize - 2;
+  if (aLength <= firstBlockData) {
+    return 1;
+  }
+  const size_t otherBlockData = this->blockSize - 1;
+  return 1 + (aLength - firstBlockData + otherBlockData - 1) / otherBlockData;
+}
+
+/**
+ * How many blocks the event starting
+ * at the given block takes up.
+ *
+ * @param aBlock The block to look at
+ * @return the number of blocks, or 0
+ *         if no (whole) event starts
+ *         there
+ */
+size_t SnowPlowOutbox::recordBlocks(const size_t aBlock) {
+  const size_t address = aBlock * this->blockSize;
+  const byte status = this->store->read(address);
+  if ((status != kPending) && (status != kSent)) {
+    return 0;
+  }
+
+  const size_t length = this->blocksFor(this->store->read(address + 1));
+  return (aBlock + length <= this->blocks) ? length : 0;
+}
+
+/**
+ * Finds the pending event after the
+ * one at the given block, wrapping
+ * round to block 0 if need be.
+ *
+ * @param aBlock The first block of
+ *        a pending event
+ * @return the first block of the next
+ */
+size_t SnowPlowOutbox::nextPending(const size_t aBlock) {
+  const size_t next = aBlock + this->recordBlocks(aBlock);
+  if ((next >= this->blocks) || (next == this->tail) ||
+      (this->store->read(next * this->blockSize) != kPending)) {
+    // Events never straddle the end of the store, so the next one is at 0
+    return (next == this->tail) ? next : 0;
+  }
+  return next;
+}
+
+/**
+ * Writes an event's data into the
+ * blocks starting at the given one,
+ * marking the extra blocks it runs
+ * into as continuations.
+ *
+ * @param aBlock The first block
+ * @param aData The encoded event
+ * @param aLength The length of aData
+ */
+void SnowPlowOutbox::writeData(size_t aBlock, const byte *aData, const size_t aLength) {
+  size_t address = aBlock * this->blockSize + 2;
+  for (size_t i = 0; i < aLength; i++) {
+    if (address % this->blockSize == 0) {
+      this->store->write(address++, kContinued);
+    }
+    this->store->write(address++, aData[i]);
+  }
+}
@@ -0,0 +1,83 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowOutbox_h
+#define SnowPlowOutbox_h
+
+#include <stddef.h>
+#include <Arduino.h>
+#include "SnowPlowStore.h"
+
+/**
+ * SnowPlowOutbox is a persistent FIFO of
+ * encoded events, kept in a SnowPlowStore
+ * so they survive a reboot or a long
+ * outage.
+ *
+ * The store is split into fixed-size
+ * blocks, used round-robin so that wear
+ * is spread evenly. An event takes one
+ * or more consecutive blocks:
+ *
+ *   first block: [status][length][data...]
+ *   others:      [kContinued][data...]
+ *
+ * Its status byte is written last, so an
+ * event only appears once it's complete,
+ * and is rewritten once it's been sent.
+ * begin() rebuilds the queue by scanning
+ * the blocks.
+ */
+class SnowPlowOutbox
+{
+ public:
+  SnowPlowOutbox(SnowPlowStore *aStore, const size_t aBlockSize = 16);
+
+  void begin();
+
+  bool push(const byte *aData, const size_t aLength);
+  size_t peek(byte *aBuffer, const size_t aLength, size_t aPosition = 0);
+  bool pop();
+
+  bool isEmpty() const;
+  size_t count() const;
+
+ private:
+  // Status bytes
+  static const byte kPending = 0xA5;
+  static const byte kSent = 0x5A;
+  static const byte kContinued = 0xCC;
+
+  SnowPlowStore *store;
+  size_t blockSize;
+  size_t blocks;
+
+  size_t head; // First block of the oldest pending event
+  size_t tail; // Block after the newest pending event
+  size_t entries;
+
+  size_t blocksFor(const size_t aLength) const;
+  size_t recordBlocks(const size_t aBlock);
+  size_t nextPending(const size_t aBlock);
+  void writeData(size_t aBlock, const byte *aData, const size_t aLength);
+};
+
+#endif
@@ -0,0 +1,284 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "SnowPlowTracker.h"
+#include "SnowPlowSerialTransport.h"
+
+/**
+ * Constructor for the SnowPlowSerialTransport
+ * class.
+ *
+ * @param aStream The serial link to the
+ *        gateway, already begun (e.g.
+ *        Serial1.begin(1000000))
+ * @param aAckTimeout How long in ms to
+ *        wait for the gateway to ack
+ *        each request before giving up
+ *        with ERROR_TIMED_OUT
+ */
+SnowPlowSerialTransport::SnowPlowSerialTransport(Stream &aStream, const unsigned long aAckTimeout) {
+  this->stream = &aStream;
+  this->ackTimeout = aAckTimeout;
+  this->context = NULL;
+  this->contextSent = false;
+  this->sequence = 0;
+  this->crc = 0;
+  this->bytesWritten = 0;
+  this->ackRead = 0;
+  this->ackEscaped = false;
+  this->statusCode = 0;
+  this->sentAt = 0;
+}
+
+/**
+ * Sets the pairs sent with every
+ * event. They go to the gateway ahead
+ * of the next request.
+ *
+ * @param aContext The URL-encoded
+ *        pairs, or NULL for none
+ */
+void SnowPlowSerialTransport::setContext(const char *aContext) {
+  this->context = aContext;
+  this->contextSent = false;
+}
+
+/**
+ * Writes a request's events to the
+ * gateway in one 'E' frame, preceded
+ * by a 'C' frame if the gateway needs
+ * our context.
+ *
+ * @param aRecords Where to get the
+ *        events' records from
+ * @param aCount How many events
+ *        there are
+ * @return 0, as writing to the link
+ *         can't fail
+ */
+int SnowPlowSerialTransport::startRequest(Records &aRecords, const size_t aCount) {
+  this->sequence++;
+
+  if (!this->contextSent && (this->context != NULL)) {
+    const size_t length = strlen(this->context);
+    this->startFrame(kContextFrame);
+    this->writeLength(length);
+    for (size_t i = 0; i < length; i++) {
+      this->writeByte(this->context[i]);
+    }
+    this->endFrame();
+    this->contextSent = true;
+  }
+
+  byte record[SNOWPLOW_MAX_EVENT_LENGTH];
+  this->startFrame(kEventsFrame);
+  this->writeLength(aCount);
+  const unsigned long now = millis();
+  for (byte i = 0; i < 4; i++) {
+    this->writeByte(now >> (8 * i));
+  }
+  for (size_t i = 0; i < aCount; i++) {
+    const size_t length = aRecords.get(i, record, sizeof(record));
+    this->writeLength(length);
+    for (size_t j = 0; j < length; j++) {
+      this->writeByte(record[j]);
+    }
+  }
+  this->endFrame();
+
+  // Get ready to read the ack
+  this->ackRead = 0;
+  this->ackEscaped = false;
+  this->statusCode = 0;
+  this->sentAt = millis();
+  return 0;
+}
+
+/**
+ * Reads whatever bytes have arrived
+ * from the gateway, looking for the
+ * ack to our request. Never waits for
+ * more data. A 0x7E always starts a
+ * frame afresh, even part way through
+ * another (which must have lost bytes).
+ *
+ * @return the HTTP status code the
+ *         gateway acked with (or
+ *         ERROR_HTTP_STATUS for a
+ *         client or server error),
+ *         ERROR_TIMED_OUT, or
+ *         kResponsePending
+ */
+int SnowPlowSerialTransport::readResponse() {
+  while (this->stream->available() > 0) {
+    const int c = this->stream->read();
+    if (c < 0) {
+      break;
+    }
+
+    if (c == kFrameStart) {
+      this->ackRead = 1;
+      this->ackEscaped = false;
+      continue;
+    }
+    if (this->ackRead == 0) {
+      continue;
+    }
+    if (c == kFrameEscape) {
+      this->ackEscaped = true;
+      continue;
+    }
+    this->ack[this->ackRead - 1] = this->ackEscaped ? (byte)(c ^ kEscapeXor) : (byte)c;
+    this->ackEscaped = false;
+    if (++this->ackRead <= kAckLength) {
+      continue;
+    }
+
+    // A whole frame: is it our ack?
+    this->ackRead = 0;
+    byte check = 0;
+    for (byte i = 0; i < kAckLength - 1; i++) {
+      check = updateCrc(check, this->ack[i]);
+    }
+    if ((this->ack[0] != kAckFrame) || (this->ack[1] != this->sequence) || (this->ack[kAckLength - 1] != check)) {
+      continue; // Corrupt, or not for this request
+    }
+
+    this->statusCode = this->ack[2] | (this->ack[3] << 8);
+    if (this->statusCode < 400) {
+      return this->statusCode;
+    }
+    return SnowPlowTracker::ERROR_HTTP_STATUS;
+  }
+
+  if (millis() - this->sentAt >= this->ackTimeout) {
+    return SnowPlowTracker::ERROR_TIMED_OUT;
+  }
+  return kResponsePending;
+}
+
+/**
+ * @return the status code of the last
+ *         ack, or 0 if there was none
+ */
+int SnowPlowSerialTransport::getStatusCode() const {
+  return this->statusCode;
+}
+
+/**
+ * Finishes with a request. If the
+ * gateway didn't answer it may have
+ * restarted, so it gets our context
+ * again with the next request.
+ *
+ * @param aStatus How the request ended
+ */
+void SnowPlowSerialTransport::endRequest(const int aStatus) {
+  if (aStatus == SnowPlowTracker::ERROR_TIMED_OUT) {
+    this->contextSent = false;
+  }
+}
+
+/**
+ * @return the total number of bytes
+ *         written to the link
+ */
+unsigned long SnowPlowSerialTransport::getBytesWritten() const {
+  return this->bytesWritten;
+}
+
+/**
+ * Writes the start of a frame: the
+ * 0x7E, its type and our sequence
+ * number.
+ *
+ * @param aType The frame's type
+ */
+void SnowPlowSerialTransport::startFrame(const byte aType) {
+  this->stream->write(kFrameStart);
+  this->bytesWritten++;
+  this->crc = 0;
+  this->writeByte(aType);
+  this->writeByte(this->sequence);
+}
+
+/**
+ * Writes one byte of a frame, adding
+ * it to the frame's CRC.
+ *
+ * @param aByte The byte to write
+ */
+void SnowPlowSerialTransport::writeByte(const byte aByte) {
+  this->writeEscaped(aByte);
+  this->crc = updateCrc(this->crc, aByte);
+}
+
+/**
+ * Writes one byte after a frame's
+ * 0x7E, escaping it if it's a 0x7E
+ * or 0x7D.
+ *
+ * @param aByte The byte to write
+ */
+void SnowPlowSerialTransport::writeEscaped(const byte aByte) {
+  if ((aByte == kFrameStart) || (aByte == kFrameEscape)) {
+    this->stream->write(kFrameEscape);
+    this->bytesWritten++;
+    this->stream->write((byte)(aByte ^ kEscapeXor));
+  } else {
+    this->stream->write(aByte);
+  }
+  this->bytesWritten++;
+}
+
+/**
+ * Writes a length (or count) as 16
+ * bits, least significant byte first.
+ *
+ * @param aLength The length to write
+ */
+void SnowPlowSerialTransport::writeLength(const size_t aLength) {
+  this->writeByte(aLength & 0xFF);
+  this->writeByte((aLength >> 8) & 0xFF);
+}
+
+/**
+ * Ends a frame with its CRC.
+ */
+void SnowPlowSerialTransport::endFrame() {
+  this->writeEscaped(this->crc);
+}
+
+/**
+ * Adds a byte to a CRC-8 (polynomial
+ * 0x07, initial value 0).
+ *
+ * @param aCrc The CRC so far
+ * @param aByte The byte to add
+ * @return the new CRC
+ */
+byte SnowPlowSerialTransport::updateCrc(byte aCrc, const byte aByte) {
+  aCrc ^= aByte;
+  for (byte i = 0; i < 8; i++) {
+    aCrc = (aCrc & 0x80) ? (byte)((aCrc << 1) ^ 0x07) : (byte)(aCrc << 1);
+  }
+  return aCrc;
+}
@@ -0,0 +1,145 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowSerialTransport_h
+#define SnowPlowSerialTransport_h
+
+#include <stddef.h>
+#include <Arduino.h>
+#include "SnowPlowTransport.h"
+
+/**
+ * SnowPlowSerialTransport sends events
+ * over a serial link (a UART, say) to a
+ * gateway, which forwards them to the
+ * collector. There is no TCP connection
+ * or HTTP to set up per request, and
+ * events go as compact binary records,
+ * so a fast link can carry many more
+ * events a second than Ethernet can.
+ *
+ * Every frame is:
+ *   0x7E, type, sequence number,
+ *   payload, CRC-8
+ * The CRC (polynomial 0x07) covers
+ * everything after the 0x7E. Lengths
+ * and status codes are 16 bits, least
+ * significant byte first.
+ *
+ * As in HDLC, a 0x7E or 0x7D anywhere
+ * after the 0x7E (the CRC included) is
+ * sent as 0x7D and then the byte XOR
+ * 0x20, so a 0x7E only ever starts a
+ * frame: a reader that loses its place
+ * picks up again at the next one. The
+ * CRC is of the bytes before escaping,
+ * and so are the lengths.
+ *
+ * We send two types of frame:
+ *   'C' (context): length, then the
+ *       URL-encoded pairs sent with
+ *       every event, as given to
+ *       setContext(). Sent before the
+ *       first request, and again after
+ *       a link failure in case the
+ *       gateway restarted
+ *   'E' (events): a count, our millis()
+ *       as the frame was written (32
+ *       bits), then each event record
+ *       as a length and its bytes
+ * The gateway forwards each 'E' frame
+ * as the tracker does a batch: a POST
+ * to /com.snowplowanalytics.snowplow/tp2
+ * with "Content-Type: application/json;
+ * charset=utf-8" and a payload_data
+ * (1-0-4) body, one object per event
+ * holding the context pairs, tid, dtm,
+ * stm and the record's own fields, each
+ * value a string. It answers with an
+ * 'A' (ack) frame carrying the same
+ * sequence number and the HTTP status
+ * code it got from the collector (or a
+ * 5xx one if it couldn't reach it).
+ * Anything else read is skipped.
+ *
+ * Event records are in the tracker's
+ * binary format, with ints and doubles
+ * in the board's own byte order and
+ * size (on AVR a double is 4 bytes).
+ * Each starts with the millis() it was
+ * created at (or, replayed from the
+ * outbox, its Unix time in seconds):
+ * the gateway takes that from the
+ * frame's millis() and its own clock
+ * to get the dtm it sends on. A
+ * metrics event's ue_pr is a binary
+ * SnowPlowMetrics::Snapshot, which the
+ * gateway writes out as the tracker
+ * does (see SnowPlowTracker::
+ * printMetrics()).
+ */
+class SnowPlowSerialTransport : public SnowPlowTransport
+{
+ public:
+  SnowPlowSerialTransport(Stream &aStream, const unsigned long aAckTimeout = 1000);
+
+  virtual void setContext(const char *aContext);
+  virtual int startRequest(Records &aRecords, const size_t aCount);
+  virtual int readResponse();
+  virtual int getStatusCode() const;
+  virtual void endRequest(const int aStatus);
+
+  // Bytes written to the link so far
+  unsigned long getBytesWritten() const;
+
+ private:
+  static const byte kFrameStart = 0x7E;
+  static const byte kFrameEscape = 0x7D; // Followed by a byte XOR kEscapeXor
+  static const byte kEscapeXor = 0x20;
+  static const byte kContextFrame = 'C';
+  static const byte kEventsFrame = 'E';
+  static const byte kAckFrame = 'A';
+  static const byte kAckLength = 5; // Bytes of an ack after the 0x7E
+
+  Stream *stream;
+  unsigned long ackTimeout;
+  const char *context;
+  bool contextSent;
+  byte sequence;
+  byte crc;
+  unsigned long bytesWritten;
+
+  // Progress through the ack
+  byte ack[kAckLength];
+  byte ackRead; // Bytes of ack read, or 0 if we're looking for a 0x7E
+  bool ackEscaped; // Whether the last byte read was a 0x7D
+  int statusCode;
+  unsigned long sentAt;
+
+  void startFrame(const byte aType);
+  void writeByte(const byte aByte);
+  void writeEscaped(const byte aByte);
+  void writeLength(const size_t aLength);
+  void endFrame();
+  static byte updateCrc(byte aCrc, const byte aByte);
+};
+
+#endif
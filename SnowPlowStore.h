@@ -0,0 +1,54 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowStore_h
+#define SnowPlowStore_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+/**
+ * SnowPlowStore is the interface to a
+ * block of persistent, byte-addressable
+ * storage (EEPROM, a file on an SD card,
+ * FRAM etc) for SnowPlowOutbox to keep
+ * unsent events in.
+ *
+ * Implementations should skip writes
+ * that don't change a byte, to spare
+ * storage with limited write cycles.
+ */
+class SnowPlowStore
+{
+ public:
+  virtual ~SnowPlowStore() {}
+
+  // Total bytes available
+  virtual size_t size() const = 0;
+
+  virtual byte read(const size_t aAddress) = 0;
+  virtual void write(const size_t aAddress, const byte aValue) = 0;
+
+  // Make any buffered writes durable
+  virtual void commit() {}
+};
+
+#endif
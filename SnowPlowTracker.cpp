@@ -28,10 +28,19 @@
 #define LOG_LEVEL   0x03 // Change to 0x00 when you've finished testing
 #include "SnowPlowTracker.h"
 
-// Initialize constants
-const char *SnowPlowTracker::kUserAgent = "Arduino/2.0";
-const char *SnowPlowTracker::kTrackerPlatform = "iot"; // Internet of things
-const char *SnowPlowTracker::kTrackerVersion = "arduino-0.1.0";
+// Initialize constants (in flash: read them with pgm_read_byte() or print them with FPSTR())
+const char SnowPlowTracker::kUserAgent[] PROGMEM = "Arduino/2.0";
+const char SnowPlowTracker::kTrackerPlatform[] PROGMEM = "iot"; // Internet of things
+const char SnowPlowTracker::kTrackerVersion[] PROGMEM = "arduino-0.1.0";
+const char SnowPlowTracker::kHttpStatusPrefix[] PROGMEM = "HTTP/*.* "; // Psuedo-regexp we're expecting before the status-code
+const char SnowPlowTracker::kContentLengthHeader[] PROGMEM = "content-length:"; // Lower case, we match case-insensitively
+const char SnowPlowTracker::kDateHeader[] PROGMEM = "date:"; // Likewise
+const char SnowPlowTracker::kFieldNames[][kMaxFieldNameLength] PROGMEM = { "e", "ev_ca", "ev_ac", "ev_la", "ev_pr", "ev_va", "dtm", "ue_pr" }; // Indexed by field key
+const char SnowPlowTracker::kPayloadDataSchema[] PROGMEM = "iglu:com.snowplowanalytics.snowplow/payload_data/jsonschema/1-0-4";
+const char SnowPlowTracker::kUnstructEventSchema[] PROGMEM = "iglu:com.snowplowanalytics.snowplow/unstruct_event/jsonschema/1-0-0";
+const char SnowPlowTracker::kMetricsSchema[] PROGMEM = "iglu:com.snowplowanalytics.arduino/tracker_metrics/jsonschema/1-0-0";
+const char SnowPlowTracker::kSummarySchema[] PROGMEM = "iglu:com.snowplowanalytics.arduino/event_summary/jsonschema/1-0-0";
+const char SnowPlowTracker::kSummaryNames[][sizeof("category")] PROGMEM = { "category", "action", "label", "property" }; // In record order
 
 /**
  * Constructor for the SnowPlowTracker
@@ -46,10 +55,93 @@ const char *SnowPlowTracker::kTrackerVersion = "arduino-0.1.0";
  * @param aAppId The SnowPlow application
  *        ID
  **/
-SnowPlowTracker::SnowPlowTracker(EthernetClass *aEthernet, const byte* aMac, const char *aAppId) {  
+SnowPlowTracker::SnowPlowTracker(EthernetClass *aEthernet, const byte* aMac, const char *aAppId)
+  : http(this), records(this), queue(NULL, 0), priorityQueue(NULL, 0),
+    out(writeBuffer, sizeof(writeBuffer), &metrics.bytesWritten) {
   this->ethernet = aEthernet;
+  this->client = NULL;
+  this->transport = &this->http;
   this->mac = (byte*)aMac;
   this->appId = (char*)aAppId;
+  this->userId = NULL;
+  this->collectorHost = NULL;
+  this->collectorResolved = false;
+  this->resolvedAt = 0;
+  this->dnsCacheTtl = kDnsCacheTtl;
+  this->encodedContext = NULL;
+  this->encodedJsonContext = NULL;
+  this->encodedHeaders = NULL;
+
+  this->collectorPort = kCollectorPort;
+  this->responseTimeout = kHttpResponseTimeout;
+  this->pollBackoff = kHttpWaitForDataDelay;
+
+  this->async = false;
+  this->keepAlive = false;
+  this->callback = NULL;
+  this->eventLength = 0;
+  this->httpState = eIdle;
+
+  this->queueAllocation = NULL;
+  this->overflowPolicy = eDropOldest;
+  this->priorityQueueAllocation = NULL;
+  this->priorityOverflowPolicy = eDropOldest;
+  this->priority = eNormalPriority;
+  this->metricsInterval = 0;
+  this->metricsSentAt = 0;
+
+  this->batchSize = 1;
+  this->batchMaxAge = 0;
+  this->batchStarted = 0;
+  this->batchCount = 0;
+  this->batchPriorityCount = 0;
+  this->compressor = NULL;
+
+  this->powerCallback = NULL;
+  this->flushEvents = 0;
+  this->flushAge = 0;
+  this->powered = false;
+  this->poweredOnAt = 0;
+  this->poweredOffAt = 0;
+
+  this->aggregator = NULL;
+  this->interruptQueue = NULL;
+  this->backdated = false;
+  this->backdatedTo = 0;
+  this->outbox = NULL;
+  this->requestSource = eFromCaller;
+  this->requestStamp = 0;
+
+  this->maxRetries = kMaxRetries;
+  this->retryBaseDelay = kRetryBaseDelay;
+  this->retryMaxDelay = kRetryMaxDelay;
+  this->breakerThreshold = kBreakerThreshold;
+  this->breakerCoolOff = kBreakerCoolOff;
+  this->attempts = 0;
+  this->consecutiveFailures = 0;
+  this->backoffStart = 0;
+  this->backoffDelay = 0;
+}
+
+/**
+ * Constructor for the SnowPlowTracker
+ * class, for networks other than an
+ * Ethernet shield (WiFi, GSM etc).
+ *
+ * @param aClient The network's Client
+ *        (e.g. a WiFiClient), on a
+ *        network already brought up
+ *        outside of this library. It
+ *        looks up the collector's
+ *        host itself
+ * @param aMac The MAC address of the
+ *        Arduino's network shield
+ * @param aAppId The SnowPlow application
+ *        ID
+ **/
+SnowPlowTracker::SnowPlowTracker(Client *aClient, const byte* aMac, const char *aAppId)
+  : SnowPlowTracker((EthernetClass*)NULL, aMac, aAppId) {
+  this->client = aClient;
 }
 
 /**
@@ -64,8 +156,9 @@ SnowPlowTracker::SnowPlowTracker(EthernetClass *aEthernet, const byte* aMac, con
 void SnowPlowTracker::initCf(const char *aCfSubdomain) {
   const size_t hostLength = strlen(aCfSubdomain) + 16; // .cloudfront.net\0 = 16
   char *host = (char*)malloc(hostLength);
-  snprintf(host, hostLength, "%s.cloudfront.net", aCfSubdomain);
-  this->init(host);
+  strcpy(host, aCfSubdomain);
+  strcat_P(host, PSTR(".cloudfront.net"));
+  this->init(host, kCollectorPort);
 }
 
 /**
@@ -76,9 +169,46 @@ void SnowPlowTracker::initCf(const char *aCfSubdomain) {
  * @param aHost The hostname of the
  *        URL hosting the collector
  *        e.g. tracking.mysite.com
+ * @param aPort The port the collector
+ *        listens on. Defaults to 80;
+ *        handy for pointing at a test
+ *        collector on a dev box
  */
-void SnowPlowTracker::initUrl(const char *aHost) {
-  this->init(aHost);
+void SnowPlowTracker::initUrl(const char *aHost, const int aPort) {
+  this->init(aHost, aPort);
+}
+
+/**
+ * Initializes the SnowPlow tracker to
+ * send its events through a transport
+ * other than HTTP, such as a
+ * SnowPlowSerialTransport to a gateway.
+ * The network isn't used, so needn't
+ * be there.
+ *
+ * @param aTransport The transport to
+ *        send through, which must
+ *        outlive the tracker
+ */
+void SnowPlowTracker::initTransport(SnowPlowTransport *aTransport) {
+  this->transport = aTransport;
+  mac2Chars(this->macAddress, this->mac);
+  this->encodeRequestParts();
+
+  LOGLN_INFO(F("SnowPlowTracker initialized with its own transport"));
+}
+
+/**
+ * Sets how long to wait for the
+ * collector to respond before giving
+ * up with ERROR_TIMED_OUT. The clock
+ * restarts whenever a byte arrives.
+ *
+ * @param aTimeout The timeout in ms.
+ *        Defaults to 15 seconds
+ */
+void SnowPlowTracker::setResponseTimeout(const unsigned long aTimeout) {
+  this->responseTimeout = aTimeout;
 }
 
 /**
@@ -88,10 +218,642 @@ void SnowPlowTracker::initUrl(const char *aHost) {
  */
 void SnowPlowTracker::setUserId(const char *aUserId) {
   this->userId = (char*)aUserId;
+  this->encodeRequestParts();
 
-  LOG_INFO("SnowPlow user id updated to [");
+  LOG_INFO(F("SnowPlow user id updated to ["));
   LOG_INFO(aUserId);
-  LOGLN_INFO("]");
+  LOGLN_INFO(F("]"));
+}
+
+/**
+ * Sets the longest we pause between
+ * checks for the collector's response
+ * when sending in blocking mode (or
+ * from flush()). Shorter pauses cut
+ * the time each event takes; longer
+ * ones leave the Ethernet shield
+ * alone more.
+ *
+ * @param aMaxDelay The longest pause
+ *        in ms. Defaults to 50
+ */
+void SnowPlowTracker::setPollBackoff(const unsigned long aMaxDelay) {
+  this->pollBackoff = (aMaxDelay < kMinPollDelay) ? kMinPollDelay : aMaxDelay;
+}
+
+/**
+ * Sets how long we keep using the
+ * collector's IP address before
+ * looking its hostname up again. We
+ * also look it up again whenever we
+ * can't connect to it.
+ *
+ * @param aTtl How long in ms to keep
+ *        the address, or 0 to look
+ *        the hostname up for every
+ *        connection. Defaults to 10
+ *        minutes
+ */
+void SnowPlowTracker::setDnsCacheTtl(const unsigned long aTtl) {
+  this->dnsCacheTtl = aTtl;
+  this->collectorResolved = false;
+}
+
+/**
+ * Switches between blocking and
+ * asynchronous sending. In async
+ * mode trackStructEvent() returns
+ * EVENT_QUEUED straightaway and the
+ * event is sent by calling update()
+ * from loop().
+ *
+ * Events wait in a queue until then:
+ * unless setQueue() has given it a
+ * buffer, the first call takes
+ * kQueueSize bytes from the heap for
+ * one. Blocking mode needs no queue.
+ *
+ * @param aAsync Whether to send
+ *        asynchronously
+ */
+void SnowPlowTracker::setAsync(const bool aAsync) {
+  this->async = aAsync;
+  if (aAsync) {
+    this->allocateQueue(eNormalPriority, kQueueSize);
+  }
+}
+
+/**
+ * Gives a queue a buffer of the
+ * sketch's own, to keep events in
+ * while they wait to be sent in
+ * async mode, in place of the one
+ * setAsync() (or, for high priority
+ * events, setPriority()) would take
+ * from the heap. Call it before
+ * tracking any events: those already
+ * in the queue are dropped, and it
+ * does nothing while the queue is
+ * being sent. E.g.
+ *
+ *   byte eventQueue[512];
+ *   snowplow.setQueue(eventQueue, sizeof(eventQueue));
+ *   snowplow.setAsync(true);
+ *
+ * Each event takes its encoded length
+ * plus one byte; an event longer than
+ * the whole buffer can't be queued.
+ *
+ * @param aBuffer The buffer, which must
+ *        outlive the tracker's use of
+ *        it, or NULL for none
+ * @param aSize Its size in bytes
+ * @param aPriority The queue to give
+ *        it to
+ */
+void SnowPlowTracker::setQueue(byte *aBuffer, const size_t aSize, const Priority aPriority) {
+  const bool high = (aPriority == eHighPriority);
+  SnowPlowEventQueue &lane = high ? this->priorityQueue : this->queue;
+  byte *&allocation = high ? this->priorityQueueAllocation : this->queueAllocation;
+
+  if (this->isSending(lane)) {
+    // The request in flight still reads from it
+    LOGLN_ERROR(F("Can't change a queue while it's being sent"));
+    return;
+  }
+  this->metrics.dropped += lane.count();
+  if (aBuffer != allocation) {
+    free(allocation);
+    allocation = NULL;
+  }
+  lane = SnowPlowEventQueue(aBuffer, (aBuffer == NULL) ? 0 : aSize);
+}
+
+/**
+ * Switches on HTTP keep-alive: the
+ * connection to the collector stays
+ * open between events, and we only
+ * reconnect once the server closes
+ * it.
+ *
+ * @param aKeepAlive Whether to keep
+ *        the connection open
+ */
+void SnowPlowTracker::setKeepAlive(const bool aKeepAlive) {
+  this->keepAlive = aKeepAlive;
+  this->encodeRequestParts();
+  if (!aKeepAlive && (this->httpState == eIdle) && (this->client != NULL)) {
+    this->client->stop();
+  }
+}
+
+/**
+ * Sets a function to be called with
+ * the final status (an HTTP status
+ * code or one of the ERROR_*
+ * values) of each event sent.
+ *
+ * @param aCallback The function to
+ *        call, or NULL for none
+ */
+void SnowPlowTracker::setTrackCallback(TrackCallback aCallback) {
+  this->callback = aCallback;
+}
+
+/**
+ * Advances the request in flight by
+ * one step without ever calling
+ * delay(): takes the next event off
+ * the queue and writes its GET if
+ * we're idle, otherwise reads
+ * whatever response bytes have
+ * arrived. Once the queue is empty,
+ * replays any events kept in the
+ * outbox. Call this on every pass
+ * through loop() when in async mode.
+ *
+ * Also picks up any events tracked
+ * from interrupt handlers.
+ *
+ * When duty cycling, powers the
+ * network up only once a send is due
+ * (see setDutyCycle), then sends
+ * everything waiting and powers it
+ * down again.
+ */
+void SnowPlowTracker::update() {
+  this->drainInterruptQueue();
+  while (this->sendSummary(false)) {
+    // Send every summary that's due
+  }
+  if ((this->metricsInterval > 0) && (millis() - this->metricsSentAt >= this->metricsInterval)) {
+    this->sendMetrics();
+  }
+
+  // Nothing in flight: start on the next queued event, or stored one, if any
+  if (this->httpState == eIdle) {
+    const bool dutyCycled = (this->powerCallback != NULL);
+    if (dutyCycled && !this->powered && !this->isFlushDue()) {
+      // Not worth waking the network for yet
+      return;
+    }
+    // Once awake, send everything rather than waiting for full batches
+    if (!this->dequeue(dutyCycled) && !this->replay()) {
+      this->powerDown();
+      return;
+    }
+    this->powerUp();
+  }
+
+  int status;
+  if (this->httpState == eRequestStarted) {
+    status = this->startRequest();
+    if (status != 0) {
+      this->finish(status);
+    }
+  } else {
+    status = this->transport->readResponse();
+    if (status != this->kResponsePending) {
+      this->finish(status);
+    }
+  }
+}
+
+/**
+ * Sets how often to retry queued
+ * events the collector fails on (we
+ * couldn't connect, it timed out or
+ * it had a server error), and how
+ * long to back off between attempts.
+ * Each failure in a row doubles the
+ * back-off, up to aMaxDelay; each
+ * actual wait is picked at random
+ * from the top half of that, so that
+ * devices that failed together don't
+ * retry together. Async mode only.
+ *
+ * @param aMaxRetries How many times to
+ *        retry an event before giving
+ *        up on it (and keeping it in
+ *        the outbox, if there is one).
+ *        Defaults to 3
+ * @param aBaseDelay The back-off in ms
+ *        after the first failure.
+ *        Defaults to 1 second
+ * @param aMaxDelay The longest back-off
+ *        in ms. Defaults to 1 minute
+ */
+void SnowPlowTracker::setRetryPolicy(const byte aMaxRetries, const unsigned long aBaseDelay, const unsigned long aMaxDelay) {
+  this->maxRetries = aMaxRetries;
+  this->retryBaseDelay = aBaseDelay;
+  this->retryMaxDelay = (aMaxDelay < aBaseDelay) ? aBaseDelay : aMaxDelay;
+}
+
+/**
+ * Sets up our circuit breaker: after
+ * aThreshold failures in a row we stop
+ * trying the collector for aCoolOff ms.
+ * Meanwhile queued events stay queued
+ * and, in blocking mode, events fail
+ * straightaway with ERROR_CIRCUIT_OPEN
+ * (and go to the outbox, if there is
+ * one). After that, one request is let
+ * through: if it succeeds the breaker
+ * closes, else it stays open for
+ * another aCoolOff ms.
+ *
+ * @param aThreshold Failures in a row to
+ *        open the breaker after, or 0
+ *        for no breaker. Defaults to 5
+ * @param aCoolOff How long in ms to stay
+ *        open. Defaults to 1 minute
+ */
+void SnowPlowTracker::setCircuitBreaker(const byte aThreshold, const unsigned long aCoolOff) {
+  this->breakerThreshold = aThreshold;
+  this->breakerCoolOff = aCoolOff;
+}
+
+/**
+ * Whether we've stopped trying the
+ * collector for a while because it
+ * keeps failing.
+ *
+ * @return true if the circuit breaker
+ *         is open
+ */
+bool SnowPlowTracker::isCircuitOpen() const {
+  return (this->breakerThreshold > 0) &&
+         (this->consecutiveFailures >= this->breakerThreshold) &&
+         this->isBackingOff();
+}
+
+/**
+ * Turns on batching: rather than a
+ * GET per event, update() waits until
+ * aMaxEvents events are queued (or
+ * the oldest has waited aMaxAge ms)
+ * and POSTs them all in one request,
+ * as payload_data JSON, to the
+ * collector's tp2 endpoint. Async
+ * mode only.
+ *
+ * @param aMaxEvents How many events
+ *        to send per request. 1 turns
+ *        batching off
+ * @param aMaxAge Longest time in ms
+ *        to hold an event back for
+ *        a batch to fill up, or 0 to
+ *        always wait for a full batch
+ */
+void SnowPlowTracker::setBatching(const size_t aMaxEvents, const unsigned long aMaxAge) {
+  this->batchSize = (aMaxEvents > kMaxBatchSize) ? kMaxBatchSize : aMaxEvents;
+  this->batchMaxAge = aMaxAge;
+  this->encodeRequestParts();
+}
+
+/**
+ * Turns on gzip compression of batch
+ * POST bodies, sent with a
+ * "Content-Encoding: gzip" header, for
+ * collectors (or proxies in front of
+ * them) that accept it. The keys and
+ * context repeated for every event
+ * shrink to a few bytes each, but the
+ * compressor takes about 535 bytes of
+ * RAM from the heap while it's on (or
+ * 1050 with a bigger window: see
+ * SNOWPLOW_COMPRESS_WINDOW).
+ * Single events sent with GET aren't
+ * compressed.
+ *
+ * @param aCompress Whether to compress
+ */
+void SnowPlowTracker::setCompression(const bool aCompress) {
+  if (aCompress && (this->compressor == NULL)) {
+    this->compressor = new SnowPlowCompressor();
+  } else if (!aCompress) {
+    delete this->compressor;
+    this->compressor = NULL;
+  }
+}
+
+/**
+ * Turns on duty cycling, for boards
+ * that power their network down to
+ * save energy. Events are only sent
+ * in bursts, with aCallback(true)
+ * called first to power the network
+ * up (blocking until it's ready) and
+ * aCallback(false) once everything
+ * waiting has been sent, or the
+ * collector failed and we're backing
+ * off. Async mode only.
+ *
+ * A burst starts as soon as any one of
+ * these happens:
+ * - aMaxEvents events are queued
+ * - the oldest has waited aMaxAge ms
+ * - a high priority event is queued
+ *   (see setPriority)
+ * - events have been in the outbox
+ *   aMaxAge ms since the last burst
+ *
+ * Make sure aMaxEvents events fit in
+ * the queue (see setQueue). Turning on
+ * batching too (see setBatching) cuts
+ * the time the network is up for.
+ * getMetrics() reports how long that
+ * is per event sent.
+ *
+ * @param aCallback Powers the network
+ *        up or down, or NULL to turn
+ *        duty cycling off
+ * @param aMaxEvents How many queued
+ *        events to start a burst at,
+ *        or 0 for no limit
+ * @param aMaxAge Longest time in ms an
+ *        event waits for a burst, or 0
+ *        for no limit. With no limit on
+ *        either, normal events would
+ *        never be sent, so the age
+ *        stays at kDutyCycleMaxAge
+ */
+void SnowPlowTracker::setDutyCycle(PowerCallback aCallback, const size_t aMaxEvents, const unsigned long aMaxAge) {
+  this->powerDown();
+  this->powerCallback = aCallback;
+  this->flushEvents = aMaxEvents;
+  this->flushAge = aMaxAge;
+  if ((aMaxEvents == 0) && (aMaxAge == 0)) {
+    LOGLN_ERROR(F("Duty cycling needs aMaxEvents or aMaxAge: using kDutyCycleMaxAge"));
+    this->flushAge = kDutyCycleMaxAge;
+  }
+}
+
+/**
+ * Sends every queued event (and any
+ * aggregated events, whether or not
+ * their window is over), blocking
+ * until the queues have drained. Then
+ * replays the outbox, if there is
+ * one, until it's empty or the
+ * collector stops answering.
+ */
+void SnowPlowTracker::flush() {
+  this->drainInterruptQueue();
+  while (this->sendSummary(true)) {
+    // Send every summary, due or not
+  }
+  while (this->sendNext()) {
+    // Keep going
+  }
+  this->powerDown();
+}
+
+/**
+ * Whether events are still waiting
+ * to be sent or for their response.
+ *
+ * @return true until the queues have
+ *         drained and the last event
+ *         has completed
+ */
+bool SnowPlowTracker::isBusy() const {
+  return (this->httpState != eIdle) || !this->queue.isEmpty() || !this->priorityQueue.isEmpty();
+}
+
+/**
+ * Sets the priority of the events
+ * tracked from now on. High priority
+ * events wait in a queue of their own,
+ * which is always sent from first, and
+ * don't wait for a batch to fill up.
+ * Unless setQueue() has given it a
+ * buffer, the first call for them
+ * takes kPriorityQueueSize bytes (room
+ * for the longest event) from the
+ * heap: sketches that never use it
+ * don't pay for it. Sketches that
+ * can't risk the heap running short
+ * when an alarm goes should give it
+ * a buffer in setup().
+ * They're never aggregated either.
+ * Async mode only. E.g.
+ *
+ *   snowplow.setPriority(SnowPlowTracker::eHighPriority);
+ *   snowplow.trackStructEvent("alarm", "overheat");
+ *   snowplow.setPriority(SnowPlowTracker::eNormalPriority);
+ *
+ * Summaries, metrics and events from
+ * interrupt handlers are always normal
+ * priority.
+ *
+ * @param aPriority The Priority to
+ *        track events with
+ */
+void SnowPlowTracker::setPriority(const Priority aPriority) {
+  this->priority = aPriority;
+  if (aPriority == eHighPriority) {
+    this->allocateQueue(eHighPriority, kPriorityQueueSize);
+  }
+}
+
+/**
+ * Sets what happens to a new event
+ * when there's no room left for it
+ * in its queue. Defaults to
+ * eDropOldest for both queues, so
+ * tracking never waits on the
+ * network.
+ *
+ * eBlock loses no events, but then
+ * trackStructEvent() sends queued
+ * events itself until there's room:
+ * it can take the response timeout
+ * (or longer, backing off) for each,
+ * and returns ERROR_BUSY if the
+ * circuit breaker is open. Only opt
+ * into it where the sketch can wait.
+ *
+ * @param aPolicy The OverflowPolicy
+ *        to apply
+ * @param aPriority The queue to apply
+ *        it to
+ */
+void SnowPlowTracker::setOverflowPolicy(const OverflowPolicy aPolicy, const Priority aPriority) {
+  if (aPriority == eHighPriority) {
+    this->priorityOverflowPolicy = aPolicy;
+  } else {
+    this->overflowPolicy = aPolicy;
+  }
+}
+
+/**
+ * @return the number of events waiting
+ *         in the queues
+ */
+size_t SnowPlowTracker::getQueuedEvents() const {
+  return this->queue.count() + this->priorityQueue.count();
+}
+
+/**
+ * @return the number of events dropped
+ *         because the queue was full
+ */
+unsigned long SnowPlowTracker::getDroppedEvents() const {
+  return this->metrics.dropped;
+}
+
+/**
+ * Gives the tracker somewhere to keep
+ * events that couldn't be sent because
+ * the collector was unreachable (we
+ * couldn't connect or it timed out).
+ * They're sent again in batches by
+ * update() (or flush()) once it's
+ * reachable again, even after a
+ * reboot.
+ *
+ * @param aOutbox The SnowPlowOutbox
+ *        to use, or NULL for none
+ */
+void SnowPlowTracker::setOutbox(SnowPlowOutbox *aOutbox) {
+  this->outbox = aOutbox;
+  if (aOutbox != NULL) {
+    aOutbox->begin();
+
+    LOG_INFO(F("SnowPlow outbox holds ["));
+    LOG_INFO(aOutbox->count());
+    LOGLN_INFO(F("] unsent events"));
+  }
+}
+
+/**
+ * @return the number of events waiting
+ *         in the outbox
+ */
+size_t SnowPlowTracker::getStoredEvents() const {
+  return (this->outbox == NULL) ? 0 : this->outbox->count();
+}
+
+/**
+ * Turns on aggregation: events tracked
+ * with a numeric value are summed up
+ * by aAggregator rather than sent, and
+ * one summary event is sent for each
+ * (category, action, label, property)
+ * per window. That's an unstructured
+ * event, its ue_pr an event_summary
+ * self-describing JSON of the event's
+ * strings and the count, min, max, mean,
+ * sum and last of the values tracked
+ * (see extras/schemas).
+ *
+ * Summaries are sent from update() (or
+ * the next trackStructEvent() call)
+ * once their window is over, and by
+ * flush().
+ *
+ * @param aAggregator The SnowPlowAggregator
+ *        to use, or NULL for none
+ */
+void SnowPlowTracker::setAggregator(SnowPlowAggregator *aAggregator) {
+  this->aggregator = aAggregator;
+}
+
+/**
+ * Sets a queue that interrupt handlers
+ * can track events into. update()
+ * picks them up and tracks them as if
+ * trackStructEvent() had been called
+ * from loop().
+ *
+ * @param aQueue The SnowPlowInterruptQueue
+ *        to use, or NULL for none
+ */
+void SnowPlowTracker::setInterruptQueue(SnowPlowInterruptQueue *aQueue) {
+  this->interruptQueue = aQueue;
+}
+
+/**
+ * Sets the wall-clock time, e.g. from
+ * NTP, an RTC or GPS, so that events
+ * are timestamped exactly. Without it
+ * the tracker sets its clock from the
+ * Date header of the collector's
+ * responses, to about half a second.
+ *
+ * Once called, Date headers are
+ * ignored, so call it again every so
+ * often (daily, say) to correct for
+ * millis() drifting.
+ *
+ * @param aUnixTime The time now, in
+ *        seconds since 1970-01-01 UTC
+ */
+void SnowPlowTracker::setClock(const unsigned long aUnixTime) {
+  this->clock.set(aUnixTime, millis());
+}
+
+/**
+ * @return the time now, in seconds
+ *         since 1970-01-01 UTC, or 0
+ *         until the clock has been
+ *         set (by setClock() or the
+ *         collector's Date header)
+ */
+unsigned long SnowPlowTracker::getUnixTime() const {
+  const unsigned long now = millis();
+  return this->clock.getUnixTime(now, now);
+}
+
+/**
+ * @return the total number of bytes
+ *         written to the collector,
+ *         headers included
+ */
+unsigned long SnowPlowTracker::getBytesWritten() const {
+  return this->metrics.bytesWritten;
+}
+
+/**
+ * Gets the tracker's metrics: its
+ * event counts, by outcome, and how
+ * long its requests take.
+ *
+ * @return the SnowPlowMetrics, which
+ *         stay up to date
+ */
+const SnowPlowMetrics &SnowPlowTracker::getMetrics() const {
+  return this->metrics;
+}
+
+/**
+ * Sets every count in the tracker's
+ * metrics back to zero.
+ */
+void SnowPlowTracker::resetMetrics() {
+  this->metrics.reset();
+}
+
+/**
+ * Has update() track the tracker's own
+ * metrics every aInterval ms, as an
+ * unstructured (e=ue) event. Its ue_pr
+ * is a self-describing JSON of the
+ * counts as they were when it was
+ * tracked, with the schema
+ * iglu:com.snowplowanalytics.arduino/
+ * tracker_metrics/jsonschema/1-0-0 (see
+ * SnowPlowMetrics::printJson() and, for
+ * the schema itself, extras/schemas/).
+ *
+ * @param aInterval How often to send
+ *        them in ms, or 0 (the default)
+ *        not to
+ */
+void SnowPlowTracker::setMetricsInterval(const unsigned long aInterval) {
+  this->metricsInterval = aInterval;
+  this->metricsSentAt = millis();
 }
 
 /**
@@ -123,12 +885,16 @@ int SnowPlowTracker::trackStructEvent(
   const char *aAction,
   const char *aLabel,
   const char *aProperty,
-  const int aValue) const {
+  const int aValue) {
 
-  char *value = int2Chars(aValue);
-  const int status = this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, value);
-  free(value);
-  return status;
+  if ((this->aggregator != NULL) && (this->priority == eNormalPriority)) {
+    return this->aggregate(aCategory, aAction, aLabel, aProperty, aValue, 2);
+  }
+
+  char value[kMaxNumberLength];
+  BufferWriter field(value, sizeof(value));
+  addField(field, kFieldValue, aValue);
+  return this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, (const byte*)value, field.length);
 }
 
 /**
@@ -163,12 +929,16 @@ int SnowPlowTracker::trackStructEvent(
   const char *aLabel,
   const char *aProperty,
   const double aValue,
-  const int aValuePrecision) const {
+  const int aValuePrecision) {
 
-  char *value = double2Chars(aValue, aValuePrecision);
-  const int status = this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, value);
-  free(value);
-  return status;
+  if ((this->aggregator != NULL) && (this->priority == eNormalPriority)) {
+    return this->aggregate(aCategory, aAction, aLabel, aProperty, aValue, aValuePrecision);
+  }
+
+  char value[kMaxNumberLength];
+  BufferWriter field(value, sizeof(value));
+  addField(field, kFieldValue, aValue, aValuePrecision);
+  return this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, (const byte*)value, field.length);
 }
 
 /**
@@ -203,12 +973,16 @@ int SnowPlowTracker::trackStructEvent(
   const char *aLabel,
   const char *aProperty,
   const float aValue,
-  const int aValuePrecision) const {
+  const int aValuePrecision) {
 
-  char *value = double2Chars(aValue, aValuePrecision);
-  const int status = this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, value);
-  free(value);
-  return status;
+  if ((this->aggregator != NULL) && (this->priority == eNormalPriority)) {
+    return this->aggregate(aCategory, aAction, aLabel, aProperty, aValue, aValuePrecision);
+  }
+
+  char value[kMaxNumberLength];
+  BufferWriter field(value, sizeof(value));
+  addField(field, kFieldValue, aValue, aValuePrecision);
+  return this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, (const byte*)value, field.length);
 }
 
 /**
@@ -237,17 +1011,16 @@ int SnowPlowTracker::trackStructEvent(
   const char *aCategory,
   const char *aAction,
   const char *aLabel,
-  const char *aProperty) const {
+  const char *aProperty) {
 
-  return this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, NULL);
+  return this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, NULL, 0);
 }
 
 /**
  * Sends a structured event to a SnowPlow
- * collector. Builds the set of event
- * name=value pairs and then passes them
- * to the general-purpose track() to track
- * the event.
+ * collector. Builds the event's record
+ * and then passes it to the general-
+ * purpose track() to track the event.
  *
  * @param aCategory The name you supply for
  *        the group of objects you want to track
@@ -262,9 +1035,10 @@ int SnowPlowTracker::trackStructEvent(
  *        describing the object or the action
  *        performed on it. This might be the
  *        quantity of an item added to basket
- * @param aValue A char *value that
- *        you can use to provide non-numerical data
- *        about the user event
+ * @param aValue The value field, already
+ *        encoded by addField(), or NULL for
+ *        none
+ * @param aValueLength The length of aValue
  * @return An integer indicating the success/failure
  *         of logging the event to SnowPlow
  */ 
@@ -273,39 +1047,115 @@ int SnowPlowTracker::_trackStructEvent(
   const char *aAction,
   const char *aLabel,
   const char *aProperty,
-  const char *aValue) const {
+  const byte *aValue,
+  const size_t aValueLength) {
 
-  LOG_INFO("Tracking structured event: category [");
+  LOG_INFO(F("Tracking structured event: category ["));
   LOG_INFO(aCategory);
-  LOG_INFO("], action [");
+  LOG_INFO(F("], action ["));
   LOG_INFO(aAction);
-  LOG_INFO("], label [");
+  LOG_INFO(F("], label ["));
   LOG_INFO(aLabel);
-  LOG_INFO("], property [");
+  LOG_INFO(F("], property ["));
   LOG_INFO(aProperty);
-  LOG_INFO("], value [");
-  LOG_INFO(aValue);  
-  LOGLN_INFO("]");
+  LOG_INFO(F("], value ["));
+#if LOG_LEVEL >= INFO_LEVEL
+  if (aValue != NULL) {
+    printField(Serial, aValue, aValueLength, eQuerystring);
+  }
+#endif
+  LOGLN_INFO(F("]"));
 
   // Validate that we have our category and action
   if (aCategory == NULL || aAction == NULL) {
+    this->metrics.addFailed(ERROR_MISSING_ARGUMENT, 1);
     return SnowPlowTracker::ERROR_MISSING_ARGUMENT;
   }
 
-  const QuerystringPair eventPairs[] = {
-    { "e", "se" }, // Structured event
-    { "ev_ca", (char*)aCategory },
-    { "ev_ac", (char*)aAction },
-    { "ev_la", (char*)aLabel },
-    { "ev_pr", (char*)aProperty },
-    { "ev_va", (char*)aValue }, 
-    { NULL, NULL } // Signals end of array
-  };
+  // In async mode eventRecord may hold the event being sent
+  byte encoded[SNOWPLOW_MAX_EVENT_LENGTH];
+  byte *record = this->async ? encoded : this->eventRecord;
+
+  byte created[kCreatedLength];
+  this->putCreated(created);
+
+  BufferWriter writer((char*)record, SNOWPLOW_MAX_EVENT_LENGTH);
+  writer.write(created, sizeof(created));
+  addField(writer, kFieldEvent, F("se")); // Structured event
+  addField(writer, kFieldCategory, aCategory);
+  addField(writer, kFieldAction, aAction);
+  addField(writer, kFieldLabel, aLabel);
+  addField(writer, kFieldProperty, aProperty);
+  if (aValue != NULL) {
+    writer.write(aValue, aValueLength);
+  }
+
+  const int length = writer.terminate();
+  if (length < 0) {
+    LOGLN_ERROR(F("Tracking returned ERROR_EVENT_TOO_LARGE"));
+    this->metrics.addFailed(ERROR_EVENT_TOO_LARGE, 1);
+    return SnowPlowTracker::ERROR_EVENT_TOO_LARGE;
+  }
 
-  const int status = this->track(eventPairs);
+  const int status = this->track(record, length);
   return status;
 }
 
+/**
+ * Tracks an Event with no value.
+ *
+ * @param aEvent The Event to track
+ * @return An integer indicating the success/failure
+ *         of logging the event to SnowPlow
+ */
+int SnowPlowTracker::trackEvent(const Event<> &aEvent) {
+  return this->_trackEvent(aEvent, NULL, 0);
+}
+
+/**
+ * Sends an Event to a SnowPlow
+ * collector. Like _trackStructEvent(),
+ * but the Event's constructor has
+ * already checked that its strings
+ * are there and its record fits, so
+ * we write the record straight out.
+ *
+ * @param aEvent The Event to track
+ * @param aValue The value field, already
+ *        encoded by ValueField::write(),
+ *        or NULL for none
+ * @param aValueLength The length of aValue
+ * @return An integer indicating the success/failure
+ *         of logging the event to SnowPlow
+ */
+int SnowPlowTracker::_trackEvent(const EventStrings &aEvent, const byte *aValue, const size_t aValueLength) {
+
+  LOG_INFO(F("Tracking event: category ["));
+  LOG_INFO(aEvent.category);
+  LOG_INFO(F("], action ["));
+  LOG_INFO(aEvent.action);
+  LOGLN_INFO(F("]"));
+
+  // In async mode eventRecord may hold the event being sent
+  byte encoded[SNOWPLOW_MAX_EVENT_LENGTH];
+  byte *record = this->async ? encoded : this->eventRecord;
+
+  byte *next = this->putCreated(record);
+  *next++ = kFieldEvent | kFieldString; // Structured event
+  *next++ = 2;
+  *next++ = 's';
+  *next++ = 'e';
+  next = putField(next, kFieldCategory, aEvent.category, aEvent.categoryLength);
+  next = putField(next, kFieldAction, aEvent.action, aEvent.actionLength);
+  next = putField(next, kFieldLabel, aEvent.label, aEvent.labelLength);
+  next = putField(next, kFieldProperty, aEvent.property, aEvent.propertyLength);
+  if (aValue != NULL) {
+    memcpy(next, aValue, aValueLength);
+  }
+
+  return this->track(record, aEvent.length);
+}
+
 /**
  * Common initialization, called by
  * both initCf and initUrl.
@@ -314,406 +1164,2303 @@ int SnowPlowTracker::_trackStructEvent(
  *        URL hosting the collector
  *        e.g. tracking.mysite.com
  *        or d3rkrsqgmqf.cloudfront.net
+ * @param aPort The port the collector
+ *        listens on
  */
-void SnowPlowTracker::init(const char *aHost) {
+void SnowPlowTracker::init(const char *aHost, const int aPort) {
 
   // Set collectorHost and userId
   this->collectorHost = (char*)aHost;
-  this->macAddress = mac2Chars(this->mac);
-
-  // Boot the Ethernet connection
-  this->ethernet->begin((byte*)this->mac);
-  delay(1000); // Wait 1 sec
-  this->client = new EthernetClient();
-
-  LOG_INFO("Ethernet booted with MAC address [");
-  LOG_INFO(this->macAddress);
-  LOG_INFO("], local IP address [");
-  LOG_INFO(this->ethernet->localIP());
-  LOGLN_INFO("]");
+  this->collectorPort = aPort;
+  this->collectorResolved = false;
+  mac2Chars(this->macAddress, this->mac);
+  this->encodeRequestParts();
+
+  // Boot the Ethernet connection, unless we were given another Client
+  if (this->ethernet != NULL) {
+    this->ethernet->begin((byte*)this->mac);
+    delay(SNOWPLOW_ETHERNET_BOOT_DELAY);
+    this->client = new EthernetClient();
+
+    LOG_INFO(F("Ethernet booted with MAC address ["));
+    LOG_INFO(this->macAddress);
+    LOG_INFO(F("], local IP address ["));
+    LOG_INFO(this->ethernet->localIP());
+    LOGLN_INFO(F("]"));
+  }
+  this->out.client = this->client;
+  this->transport = &this->http;
   
-  LOG_INFO("SnowPlowTracker initialized with collector host [");
+  LOG_INFO(F("SnowPlowTracker initialized with collector host ["));
   LOG_INFO(this->collectorHost);
-  LOGLN_INFO("]");
+  LOG_INFO(F("], port ["));
+  LOG_INFO(this->collectorPort);
+  LOGLN_INFO(F("]"));
 }
 
 /**
- * A wrapper around getUri to send
- * an event to the SnowPlow collector
- * via a GET.
+ * Either sends the event's record to
+ * the SnowPlow collector (blocking
+ * mode) or queues it for update()
+ * to send (async mode).
  *
- * @param aEventPairs the name-value
- *        pairs specific to this event
- *        to add to our GET
+ * @param aRecord The event's fields,
+ *        as written by addField()
+ * @param aLength The length of
+ *        aRecord
  * @return An integer indicating the
  *         success/failure of logging
  *         the event to SnowPlow
  */
-int SnowPlowTracker::track(const QuerystringPair aEventPairs[]) const {
+int SnowPlowTracker::track(const byte *aRecord, const size_t aLength) {
 
-  char *txnId = this->getTransactionId();
-
-  const int fixedPairCount = 6; // Update this if more pairs added below.
-  QuerystringPair qsPairs[fixedPairCount + this->kMaxEventPairs] = {
-    { "tid", (char*)txnId },
-    { "p",   (char*)this->kTrackerPlatform },
-    { "mac", (char*)this->macAddress },
-    { "uid", (char*)this->userId },
-    { "aid", (char*)this->appId },
-    { "tv",  (char*)this->kTrackerVersion }
-  };
-
-  const int eventPairCount = countPairs(aEventPairs);
-  for (int i = 0; i < eventPairCount; i++) {
-    qsPairs[fixedPairCount + i].name = aEventPairs[i].name;
-    qsPairs[fixedPairCount + i].value = aEventPairs[i].value;
+  this->metrics.tracked++;
+  if (this->async) {
+    // update() takes it from here
+    return this->enqueue(aRecord, aLength);
   }
 
-  const int status = this->getUri(this->collectorHost, this->kCollectorPort, "/i", qsPairs);
-  free(txnId);
+  if (aRecord != this->eventRecord) {
+    memcpy(this->eventRecord, aRecord, aLength);
+  }
+  this->eventLength = aLength;
 
-  switch (status) {
-  case ERROR_CONNECTION_FAILED:
-    LOGLN_ERROR("Tracking returned ERROR_CONNECTION_FAILED");
-    break;
-  case ERROR_TIMED_OUT:
-    LOGLN_ERROR("Tracking returned ERROR_TIMED_OUT");
-    break;
-  case ERROR_INVALID_RESPONSE:
-    LOGLN_ERROR("Tracking returned ERROR_INVALID_RESPONSE");
-    break;
-  default:
-    LOG_INFO("Tracking returned HTTP Status Code: ");
-    LOGLN_INFO(status);
-    break;
+  if (this->isCircuitOpen()) {
+    // Don't wait on a collector that keeps failing
+    this->finish(SnowPlowTracker::ERROR_CIRCUIT_OPEN);
+    return SnowPlowTracker::ERROR_CIRCUIT_OPEN;
   }
+  this->powerUp();
+  const int status = this->send();
+  this->powerDown();
   return status;
 }
 
 /**
- * Returns the transaction ID for this
- * track event. Uses random().
+ * Adds an encoded event to the back
+ * of the queue for its priority,
+ * applying that queue's OverflowPolicy
+ * if it's full.
  *
- * IMPORTANT: be sure to free() the returned
- * string after use
- *
- * @return the transaction ID, effectively
- *         millis() cast to an integer
+ * @param aRecord The event's fields,
+ *        as written by addField()
+ * @param aLength The length of
+ *        aRecord
+ * @return EVENT_QUEUED, ERROR_BUSY if
+ *         the event was dropped, or
+ *         ERROR_EVENT_TOO_LARGE if it
+ *         could never fit
  */
-char *SnowPlowTracker::getTransactionId() {
-  const int rndm = (int)random(INT_MAX); // Restrict to int range
-  return int2Chars(rndm);
-}
+int SnowPlowTracker::enqueue(const byte *aRecord, const size_t aLength) {
 
-/**
- * Converts a MAC address byte array
+  const bool high = (this->priority == eHighPriority);
+  SnowPlowEventQueue &lane = high ? this->priorityQueue : this->queue;
+  if (lane.capacity() == 0) {
+    // setQueue() took it away, or there was no RAM for it
+    this->metrics.dropped++;
+    LOGLN_ERROR(F("No queue: tracking returned ERROR_BUSY"));
+    this->metrics.addFailed(ERROR_BUSY, 1);
+    return SnowPlowTracker::ERROR_BUSY;
+  }
+  if ((aLength > SnowPlowEventQueue::kMaxEntryLength) || (aLength + 1 > lane.capacity())) {
+    // Even an empty queue couldn't hold it: don't drop or send others for it
+    LOGLN_ERROR(F("Tracking returned ERROR_EVENT_TOO_LARGE"));
+    this->metrics.addFailed(ERROR_EVENT_TOO_LARGE, 1);
+    return SnowPlowTracker::ERROR_EVENT_TOO_LARGE;
+  }
+  while (!lane.hasRoomFor(aLength)) {
+    switch (high ? this->priorityOverflowPolicy : this->overflowPolicy) {
+    case eDropNewest:
+      this->metrics.dropped++;
+      LOGLN_ERROR(F("Tracking returned ERROR_BUSY"));
+      this->metrics.addFailed(ERROR_BUSY, 1);
+      return SnowPlowTracker::ERROR_BUSY;
+    case eDropOldest:
+      if (this->isSending(lane)) {
+        // The oldest events are being sent, so they stay
+        this->metrics.dropped++;
+        LOGLN_ERROR(F("Tracking returned ERROR_BUSY"));
+        this->metrics.addFailed(ERROR_BUSY, 1);
+        return SnowPlowTracker::ERROR_BUSY;
+      }
+      lane.pop();
+      this->attempts = 0; // They were for the event just dropped
+      this->metrics.dropped++;
+      break;
+    case eBlock:
+      if (!this->sendNext()) {
+        // The circuit breaker is open, so nothing's going to make room
+        this->metrics.dropped++;
+        LOGLN_ERROR(F("Tracking returned ERROR_BUSY"));
+        this->metrics.addFailed(ERROR_BUSY, 1);
+        return SnowPlowTracker::ERROR_BUSY;
+      }
+      break;
+    }
+  }
+
+  if (!high && lane.isEmpty()) {
+    // Age a new batch from its first event
+    this->batchStarted = getCreated(aRecord, aLength);
+  }
+  lane.push(aRecord, aLength);
+  return SnowPlowTracker::EVENT_QUEUED;
+}
+
+/**
+ * Takes a buffer for a queue from the
+ * heap, if it doesn't have one yet.
+ *
+ * @param aPriority The queue
+ * @param aSize How big a buffer to take
+ */
+void SnowPlowTracker::allocateQueue(const Priority aPriority, const size_t aSize) {
+  if (((aPriority == eHighPriority) ? this->priorityQueue : this->queue).capacity() > 0) {
+    return;
+  }
+  byte *buffer = (byte*)malloc(aSize);
+  if (buffer == NULL) {
+    LOGLN_ERROR(F("No RAM for the event queue"));
+    return;
+  }
+  this->setQueue(buffer, aSize, aPriority);
+  if (aPriority == eHighPriority) {
+    this->priorityQueueAllocation = buffer;
+  } else {
+    this->queueAllocation = buffer;
+  }
+}
+
+/**
+ * Whether the request in flight holds
+ * the events at the front of a queue.
+ *
+ * @param aLane queue or priorityQueue
+ * @return true if they're being sent
+ */
+bool SnowPlowTracker::isSending(const SnowPlowEventQueue &aLane) const {
+  if ((this->httpState == eIdle) || (this->requestSource != eFromQueue)) {
+    return false;
+  }
+  const size_t count = (this->batchCount == 0) ? 1 : this->batchCount;
+  return (&aLane == &this->priorityQueue) ? (this->batchPriorityCount > 0) : (count > this->batchPriorityCount);
+}
+
+/**
+ * Copies one of the queued events
+ * being sent: the high priority ones
+ * come first, then the normal ones.
+ *
+ * @param aBuffer Where to copy it to
+ * @param aSize The size of aBuffer
+ * @param aIndex Which event in the
+ *        request
+ * @return the record's length, or 0
+ *         if it doesn't fit
+ */
+size_t SnowPlowTracker::peekQueued(byte *aBuffer, const size_t aSize, const size_t aIndex) const {
+  if (aIndex < this->batchPriorityCount) {
+    return this->priorityQueue.peek(aBuffer, aSize, aIndex);
+  }
+  return this->queue.peek(aBuffer, aSize, aIndex - this->batchPriorityCount);
+}
+
+/**
+ * Tracks the events waiting in the
+ * interrupt queue, if there is one.
+ */
+void SnowPlowTracker::drainInterruptQueue() {
+  if (this->interruptQueue == NULL) {
+    return;
+  }
+
+  const Priority priority = this->priority;
+  this->priority = eNormalPriority; // Whatever the sketch is tracking with
+  SnowPlowInterruptQueue::Entry entry;
+  while (this->interruptQueue->pop(entry)) {
+    // Stamp it with when the interrupt happened, not now
+    this->backdated = true;
+    this->backdatedTo = entry.created;
+    switch (entry.valueType) {
+    case SnowPlowInterruptQueue::eIntValue:
+      this->trackStructEvent(entry.category, entry.action, entry.label, entry.property, entry.intValue);
+      break;
+    case SnowPlowInterruptQueue::eDoubleValue:
+      this->trackStructEvent(entry.category, entry.action, entry.label, entry.property, entry.doubleValue, entry.valuePrecision);
+      break;
+    default:
+      this->trackStructEvent(entry.category, entry.action, entry.label, entry.property);
+      break;
+    }
+    this->backdated = false;
+  }
+  this->priority = priority;
+}
+
+/**
+ * Adds a value to our aggregated
+ * statistics for its event, first
+ * sending any summaries that are due.
+ *
+ * @param aCategory The event's category
+ * @param aAction The event's action
+ * @param aLabel The event's label
+ * @param aProperty The event's property
+ * @param aValue The event's value
+ * @param aPrecision How many digits to
+ *        keep after the decimal sign
+ * @return EVENT_QUEUED, or
+ *         ERROR_MISSING_ARGUMENT, or for
+ *         NaN or infinity whatever
+ *         _trackStructEvent() returns
+ */
+int SnowPlowTracker::aggregate(
+  const char *aCategory,
+  const char *aAction,
+  const char *aLabel,
+  const char *aProperty,
+  const double aValue,
+  const int aPrecision) {
+
+  // Validate that we have our category and action
+  if (aCategory == NULL || aAction == NULL) {
+    this->metrics.addFailed(ERROR_MISSING_ARGUMENT, 1);
+    return SnowPlowTracker::ERROR_MISSING_ARGUMENT;
+  }
+
+  while (this->sendSummary(false)) {
+    // Send every summary that's due
+  }
+
+  if (isnan(aValue) || isinf(aValue)) {
+    // It would spoil the statistics: send it on its own, without its value
+    return this->_trackStructEvent(aCategory, aAction, aLabel, aProperty, NULL, 0);
+  }
+
+  if (!this->aggregator->add(aCategory, aAction, aLabel, aProperty, aValue, aPrecision)) {
+    // Every slot's in use: make room by sending the oldest summary early
+    this->sendSummary(true);
+    this->aggregator->add(aCategory, aAction, aLabel, aProperty, aValue, aPrecision);
+  }
+  return SnowPlowTracker::EVENT_QUEUED;
+}
+
+/**
+ * Tracks the summary of an aggregated
+ * event whose window is over. Like the
+ * metrics, the record keeps the
+ * statistics in binary: they're only
+ * written out as JSON when the event
+ * is sent. If the event's strings leave
+ * no room for them the summary is
+ * dropped, never cut short.
+ *
+ * @param aForce Whether to send the
+ *        oldest summary even if its
+ *        window isn't over yet
+ * @return true if a summary was taken
+ *         (and sent, queued or dropped)
+ */
+bool SnowPlowTracker::sendSummary(const bool aForce) {
+  SnowPlowAggregator::Summary summary;
+  if ((this->aggregator == NULL) || !this->aggregator->take(summary, aForce)) {
+    return false;
+  }
+
+  // In async mode eventRecord may hold the event being sent
+  byte encoded[SNOWPLOW_MAX_EVENT_LENGTH];
+  byte *record = this->async ? encoded : this->eventRecord;
+
+  byte created[kCreatedLength];
+  this->putCreated(created);
+
+  BufferWriter writer((char*)record, SNOWPLOW_MAX_EVENT_LENGTH);
+  writer.write(created, sizeof(created));
+  addField(writer, kFieldEvent, F("ue")); // Unstructured event
+  writer.write(kFieldUnstructEvent | kFieldSummary);
+  writer.write((const byte*)&summary.statistics, sizeof(summary.statistics));
+  addString(writer, summary.category);
+  addString(writer, summary.action);
+  addString(writer, summary.label);
+  addString(writer, summary.property);
+
+  const int length = writer.terminate();
+  if (length < 0) {
+    LOGLN_ERROR(F("Summary returned ERROR_EVENT_TOO_LARGE"));
+    this->metrics.addFailed(ERROR_EVENT_TOO_LARGE, 1);
+    return true;
+  }
+
+  const Priority priority = this->priority;
+  this->priority = eNormalPriority; // Whatever the sketch is tracking with
+  this->track(record, length);
+  this->priority = priority;
+  return true;
+}
+
+/**
+ * Tracks the tracker's own metrics,
+ * as set up by setMetricsInterval().
+ * The record keeps the counts in
+ * binary, always the same size, so
+ * they're never cut short: they're
+ * only written out as JSON when the
+ * event is sent.
+ */
+void SnowPlowTracker::sendMetrics() {
+  this->metricsSentAt = millis();
+
+  SnowPlowMetrics::Snapshot snapshot;
+  this->metrics.snapshot(snapshot);
+
+  // In async mode eventRecord may hold the event being sent
+  byte encoded[SNOWPLOW_MAX_EVENT_LENGTH];
+  byte *record = this->async ? encoded : this->eventRecord;
+
+  byte created[kCreatedLength];
+  this->putCreated(created);
+
+  BufferWriter writer((char*)record, SNOWPLOW_MAX_EVENT_LENGTH);
+  writer.write(created, sizeof(created));
+  addField(writer, kFieldEvent, F("ue")); // Unstructured event
+  writer.write(kFieldUnstructEvent | kFieldMetrics);
+  writer.write((const byte*)&snapshot, sizeof(snapshot)); // Always fits: see kMetricsLength
+
+  const Priority priority = this->priority;
+  this->priority = eNormalPriority; // Whatever the sketch is tracking with
+  this->track(record, writer.length);
+  this->priority = priority;
+}
+
+/**
+ * Takes the event at the front of
+ * the queue (or, when batching, as
+ * many events as make up a batch)
+ * and makes it the next to send,
+ * unless we're backing off after a
+ * failure. High priority events go
+ * first, and are sent straight away
+ * rather than waiting for a batch to
+ * fill up.
+ *
+ * @param aForce Whether to send a
+ *        batch even if it isn't full
+ *        or old enough yet
+ * @return true if there was anything
+ *         to take
+ */
+bool SnowPlowTracker::dequeue(const bool aForce) {
+  const size_t urgent = this->priorityQueue.count();
+  const size_t queued = urgent + this->queue.count();
+  if ((queued == 0) || this->isBackingOff()) {
+    return false;
+  }
+
+  if (this->batchSize > 1) {
+    if (!aForce && (urgent == 0) && (queued < this->batchSize) &&
+        ((this->batchMaxAge == 0) || (millis() - this->batchStarted < this->batchMaxAge))) {
+      // Keep accumulating
+      return false;
+    }
+    this->batchCount = (queued < this->batchSize) ? queued : this->batchSize;
+    this->batchPriorityCount = (urgent < this->batchCount) ? urgent : this->batchCount;
+  } else {
+    this->batchCount = 0;
+    this->batchPriorityCount = (urgent > 0) ? 1 : 0;
+    this->eventLength = this->peekQueued(this->eventRecord, sizeof(this->eventRecord), 0);
+  }
+
+  // It stays on the queue until it's been sent
+  this->requestSource = eFromQueue;
+  this->httpState = eRequestStarted;
+  return true;
+}
+
+/**
+ * Whether enough is waiting to be
+ * worth powering the network up for,
+ * when duty cycling.
+ *
+ * @return true if a burst is due
+ */
+bool SnowPlowTracker::isFlushDue() const {
+  if (!this->priorityQueue.isEmpty()) {
+    return true;
+  }
+  const size_t queued = this->queue.count();
+  if ((this->flushEvents > 0) && (queued >= this->flushEvents)) {
+    return true;
+  }
+  if (this->flushAge == 0) {
+    return false;
+  }
+  if (queued > 0) {
+    return (millis() - this->batchStarted >= this->flushAge);
+  }
+  return (this->outbox != NULL) && !this->outbox->isEmpty() && (millis() - this->poweredOffAt >= this->flushAge);
+}
+
+/**
+ * Powers the network up, if we're
+ * duty cycling and it's down.
+ */
+void SnowPlowTracker::powerUp() {
+  if ((this->powerCallback == NULL) || this->powered) {
+    return;
+  }
+  this->powered = true;
+  this->poweredOnAt = millis();
+  this->metrics.wakes++;
+  LOGLN_DEBUG(F("Powering the network up"));
+  this->powerCallback(true);
+}
+
+/**
+ * Powers the network down, if we're
+ * duty cycling and it's up, closing
+ * any kept-alive connection first.
+ */
+void SnowPlowTracker::powerDown() {
+  if ((this->powerCallback == NULL) || !this->powered) {
+    return;
+  }
+  if ((this->transport == &this->http) && (this->client != NULL)) {
+    this->client->stop();
+  }
+  this->powered = false;
+  this->poweredOffAt = millis();
+  this->metrics.onTime += this->poweredOffAt - this->poweredOnAt;
+  LOGLN_DEBUG(F("Powering the network down"));
+  this->powerCallback(false);
+}
+
+/**
+ * Takes the oldest events in the
+ * outbox (as many as make up a batch
+ * when batching) and makes them the
+ * next to send, unless we're backing
+ * off after a failure.
+ *
+ * @return true if there was anything
+ *         to take
+ */
+bool SnowPlowTracker::replay() {
+  if ((this->outbox == NULL) || this->outbox->isEmpty() || (this->getQueuedEvents() > 0) || this->isBackingOff()) {
+    return false;
+  }
+
+  if (this->batchSize > 1) {
+    const size_t stored = this->outbox->count();
+    this->batchCount = (stored < this->batchSize) ? stored : this->batchSize;
+  } else {
+    this->eventLength = this->outbox->peek(this->eventRecord, sizeof(this->eventRecord));
+    this->batchCount = 0;
+  }
+
+  LOG_INFO(F("Replaying ["));
+  LOG_INFO((this->batchCount == 0) ? 1 : this->batchCount);
+  LOGLN_INFO(F("] stored events"));
+
+  this->requestSource = eFromOutbox;
+  this->httpState = eRequestStarted;
+  return true;
+}
+
+/**
+ * Keeps an event we couldn't send in
+ * the outbox, if there is one.
+ *
+ * The outbox may outlive a reboot, and
+ * millis() with it, so the time the
+ * event was created is first turned
+ * into wall-clock time, to the second
+ * (or 0, for unknown, if the clock
+ * isn't set yet).
+ *
+ * @param aRecord The event's fields,
+ *        as written by addField(). Its
+ *        created time is rewritten
+ * @param aLength The length of
+ *        aRecord
+ */
+void SnowPlowTracker::store(byte *aRecord, const size_t aLength) {
+  if (this->outbox == NULL) {
+    return;
+  }
+
+  if ((aLength >= kCreatedLength) && (aRecord[0] == (kFieldCreated | kFieldMillis))) {
+    unsigned long created;
+    memcpy(&created, aRecord + 1, sizeof(created));
+    created = this->clock.getUnixTime(created, millis());
+    aRecord[0] = kFieldCreated | kFieldUnixTime;
+    memcpy(aRecord + 1, &created, sizeof(created));
+  }
+  if (!this->outbox->push(aRecord, aLength)) {
+    LOGLN_ERROR(F("Outbox full, event dropped"));
+    this->metrics.dropped++;
+  }
+}
+
+/**
+ * Blocks until the request in flight
+ * (or failing that, the next queued
+ * event or batch) has been sent,
+ * waiting out any back-off first.
+ *
+ * @return true if anything was sent,
+ *         false if there was nothing
+ *         to send or the circuit
+ *         breaker is open
+ */
+bool SnowPlowTracker::sendNext() {
+  if (this->httpState == eIdle) {
+    if (this->isCircuitOpen()) {
+      // Don't sit out the whole cooling-off period
+      return false;
+    }
+    // Read the clock once: it may pass the back-off between two reads
+    const unsigned long elapsed = millis() - this->backoffStart;
+    if ((this->backoffDelay > 0) && (elapsed < this->backoffDelay)) {
+      delay(this->backoffDelay - elapsed);
+    }
+    if (!this->dequeue(true) && !this->replay()) {
+      return false;
+    }
+  }
+
+  if (this->httpState == eRequestStarted) {
+    this->powerUp();
+    this->send();
+  } else {
+    this->finish(this->getResponseCode());
+  }
+  return true;
+}
+
+/**
+ * Sends the encoded event (or batch)
+ * to the SnowPlow collector, blocking
+ * until we have its response.
+ *
+ * @return An integer indicating the
+ *         success/failure of logging
+ *         the event to SnowPlow
+ */
+int SnowPlowTracker::send() {
+  int status = this->startRequest();
+  if (status == 0) {
+    status = this->getResponseCode();
+  }
+  this->finish(status);
+  return status;
+}
+
+/**
+ * Sends the next request (the event
+ * being sent, or the batch taken from
+ * the queue or outbox) through our
+ * transport.
+ *
+ * @return 0 if the request was sent,
+ *         else an ERROR_* value
+ */
+int SnowPlowTracker::startRequest() {
+  const int status = this->transport->startRequest(this->records, (this->batchCount == 0) ? 1 : this->batchCount);
+  if (status == 0) {
+    this->awaitResponse();
+  }
+  return status;
+}
+
+/**
+ * Writes the next request to the
+ * SnowPlow collector: a POST of the
+ * batch taken from the queue (or
+ * outbox) if batching, else a GET of
+ * the encoded event.
+ *
+ * @return 0 if the request was sent,
+ *         else ERROR_CONNECTION_FAILED
+ */
+int SnowPlowTracker::startHttpRequest() {
+  const int txnId = getTransactionId();
+  this->requestStamp = millis(); // The same for every event, and both passes over a batch
+
+  if (this->batchCount == 0) {
+    return this->getUri(this->collectorPort, F("/i"), txnId, this->eventRecord, this->eventLength);
+  }
+  return this->postUri(this->collectorPort, F("/com.snowplowanalytics.snowplow/tp2"), txnId, this->batchCount);
+}
+
+/**
+ * Closes the connection, logs the
+ * event's final status and reports
+ * it to the callback, if any.
+ *
+ * If the collector failed us (we
+ * couldn't connect, it timed out or
+ * it had a server error) we back off
+ * before sending anything else. Queued
+ * events are left on the queue to be
+ * retried; once out of retries, or
+ * when not queued, they're kept in
+ * the outbox (if there is one) to
+ * send again later.
+ *
+ * @param aStatus The HTTP status code
+ *        or ERROR_* value
+ */
+void SnowPlowTracker::finish(const int aStatus) {
+  this->transport->endRequest(aStatus);
+  if ((this->httpState >= eRequestSent) && (aStatus != ERROR_TIMED_OUT)) {
+    SnowPlowMetrics::addLatency(this->metrics.responseLatency, millis() - this->requestSentAt);
+  }
+  this->httpState = eIdle;
+
+  // Did the collector fail us (rather than turn the event down)?
+  const bool tried = (aStatus != ERROR_CIRCUIT_OPEN);
+  const bool failed = !tried || (aStatus == ERROR_CONNECTION_FAILED) || (aStatus == ERROR_TIMED_OUT) ||
+                      ((aStatus == ERROR_HTTP_STATUS) && (this->transport->getStatusCode() >= 500));
+  if (!tried) {
+    // Leave the circuit breaker as it is
+  } else if (failed) {
+    if (this->consecutiveFailures < 255) {
+      this->consecutiveFailures++;
+    }
+    this->backoffStart = millis();
+    this->backoffDelay = this->getBackoffDelay();
+  } else {
+    this->consecutiveFailures = 0;
+    this->backoffDelay = 0;
+  }
+
+  const size_t sent = (this->batchCount == 0) ? 1 : this->batchCount;
+  if (aStatus >= 0) {
+    this->metrics.sent += sent;
+  } else {
+    this->metrics.addFailed(aStatus, sent);
+  }
+
+  switch (this->requestSource) {
+  case eFromOutbox:
+    // Stored events stay stored until the collector has them
+    if (!failed) {
+      for (size_t i = 0; i < sent; i++) {
+        this->outbox->pop();
+      }
+    }
+    break;
+  case eFromQueue:
+    if (failed && (this->attempts < this->maxRetries)) {
+      // Leave it at the front of the queue to try again
+      this->attempts++;
+      this->metrics.retries++;
+      break;
+    }
+    // Done with: take it off the queue, keeping it if it never got through
+    for (size_t i = 0; i < sent; i++) {
+      SnowPlowEventQueue &lane = (i < this->batchPriorityCount) ? this->priorityQueue : this->queue;
+      if (failed) {
+        this->eventLength = lane.peek(this->eventRecord, sizeof(this->eventRecord));
+        this->store(this->eventRecord, this->eventLength);
+      }
+      lane.pop();
+    }
+    this->attempts = 0;
+    // Age what's left from its oldest event, not from now
+    this->eventLength = this->queue.peek(this->eventRecord, sizeof(this->eventRecord));
+    this->batchStarted = getCreated(this->eventRecord, this->eventLength);
+    break;
+  default:
+    if (failed) {
+      this->store(this->eventRecord, this->eventLength);
+    }
+    break;
+  }
+  this->requestSource = eFromCaller;
+  this->batchCount = 0;
+  this->batchPriorityCount = 0;
+
+  switch (aStatus) {
+  case ERROR_CONNECTION_FAILED:
+    LOGLN_ERROR(F("Tracking returned ERROR_CONNECTION_FAILED"));
+    break;
+  case ERROR_TIMED_OUT:
+    LOGLN_ERROR(F("Tracking returned ERROR_TIMED_OUT"));
+    break;
+  case ERROR_INVALID_RESPONSE:
+    LOGLN_ERROR(F("Tracking returned ERROR_INVALID_RESPONSE"));
+    break;
+  case ERROR_CIRCUIT_OPEN:
+    LOGLN_ERROR(F("Tracking returned ERROR_CIRCUIT_OPEN"));
+    break;
+  default:
+    LOG_INFO(F("Tracking returned HTTP Status Code: "));
+    LOGLN_INFO(aStatus);
+    break;
+  }
+
+  if (this->callback != NULL) {
+    this->callback(aStatus);
+  }
+}
+
+/**
+ * Whether we're waiting before trying
+ * the collector again after a failure.
+ *
+ * @return true until the back-off is
+ *         over
+ */
+bool SnowPlowTracker::isBackingOff() const {
+  return (this->backoffDelay > 0) && (millis() - this->backoffStart < this->backoffDelay);
+}
+
+/**
+ * Works out how long to back off for
+ * after the latest failure: exponential
+ * in the number of failures in a row,
+ * with jitter, or the circuit breaker's
+ * cooling-off period once that opens.
+ *
+ * @return the back-off in ms
+ */
+unsigned long SnowPlowTracker::getBackoffDelay() const {
+  if ((this->breakerThreshold > 0) && (this->consecutiveFailures >= this->breakerThreshold)) {
+    LOGLN_ERROR(F("Circuit breaker open"));
+    return this->breakerCoolOff;
+  }
+
+  // Double it for each failure in a row, without overflowing
+  unsigned long wait = this->retryBaseDelay;
+  for (byte i = 1; (i < this->consecutiveFailures) && (wait < this->retryMaxDelay); i++) {
+    wait *= 2;
+  }
+  if (wait > this->retryMaxDelay) {
+    wait = this->retryMaxDelay;
+  }
+
+  // Pick a time in the top half, so devices that failed together spread out
+  return wait / 2 + random(wait / 2 + 1);
+}
+
+/**
+ * Returns the transaction ID for this
+ * track event. Uses random(). Leaves
+ * room for a batch's worth of
+ * consecutive IDs above it.
+ *
+ * @return the transaction ID, a random
+ *         non-negative integer
+ */
+int SnowPlowTracker::getTransactionId() {
+  return (int)random(INT_MAX - kMaxBatchSize); // Restrict to int range
+}
+
+/**
+ * Converts a MAC address byte array
  * into a String. Generated char *is
  * of the format: "00:01:0A:2E:05:0B"
  *
- * IMPORTANT: be sure to free() the returned
- * string after use
+ * @param aBuffer Where to write the
+ *        String: at least
+ *        kMacAddressLength chars
+ * @param aMac The MAC address, in bytes,
+ *             to convert
+ * @return aBuffer
+ */
+char *SnowPlowTracker::mac2Chars(char *aBuffer, const byte* aMac) {
+  char *next = aBuffer;
+  for (size_t i = 0; i < 6; i++) {
+    *next++ = toupper(char2Hex(aMac[i] >> 4));
+    *next++ = toupper(char2Hex(aMac[i] & 15));
+    *next++ = (i < 5) ? ':' : '\0';
+  }
+  return aBuffer;
+}
+
+/**
+ * Adds a string field to an event
+ * record: its tag, its length and
+ * then its characters, as they are.
+ * We leave URL-encoding them until
+ * they're sent, to save space in the
+ * queue and outbox.
+ *
+ * @param aRecord The record to add to
+ * @param aKey The field's kField* key
+ * @param aValue The field's value. If
+ *        NULL the field is left out
+ */
+void SnowPlowTracker::addField(BufferWriter &aRecord, const byte aKey, const char *aValue) {
+  if (aValue == NULL) {
+    return;
+  }
+
+  const size_t length = strlen(aValue);
+  if (length > 255) {
+    aRecord.overflowed = true;
+    return;
+  }
+  aRecord.write(aKey | kFieldString);
+  aRecord.write((uint8_t)length);
+  aRecord.write((const uint8_t*)aValue, length);
+}
+
+/**
+ * Adds a string field kept in flash
+ * to an event record.
+ *
+ * @param aRecord The record to add to
+ * @param aKey The field's kField* key
+ * @param aValue The field's value
+ */
+void SnowPlowTracker::addField(BufferWriter &aRecord, const byte aKey, const __FlashStringHelper *aValue) {
+  const char *value = (const char*)aValue;
+  const size_t length = strlen_P(value);
+  if (length > 255) {
+    aRecord.overflowed = true;
+    return;
+  }
+  aRecord.write(aKey | kFieldString);
+  aRecord.write((uint8_t)length);
+  for (size_t i = 0; i < length; i++) {
+    aRecord.write(pgm_read_byte(value + i));
+  }
+}
+
+/**
+ * Adds an int field to an event
+ * record: its tag and then the int,
+ * in binary.
+ *
+ * @param aRecord The record to add to
+ * @param aKey The field's kField* key
+ * @param aValue The field's value
+ */
+void SnowPlowTracker::addField(BufferWriter &aRecord, const byte aKey, const int aValue) {
+  aRecord.write(aKey | kFieldInt);
+  aRecord.write((const uint8_t*)&aValue, sizeof(aValue));
+}
+
+/**
+ * Adds a double field to an event
+ * record: its tag, the precision to
+ * print it with and then the double,
+ * in binary.
+ *
+ * @param aRecord The record to add to
+ * @param aKey The field's kField* key
+ * @param aValue The field's value
+ * @param aPrecision How many digits to
+ *        keep after the decimal sign
+ */
+void SnowPlowTracker::addField(BufferWriter &aRecord, const byte aKey, const double aValue, const int aPrecision) {
+  aRecord.write(aKey | kFieldDouble);
+  aRecord.write((uint8_t)aPrecision);
+  aRecord.write((const uint8_t*)&aValue, sizeof(aValue));
+}
+
+/**
+ * Adds a string to an event record
+ * without a tag: its length and then
+ * its chars. NULL is written as "".
+ *
+ * @param aRecord The record to add to
+ * @param aValue The string, or NULL
+ */
+void SnowPlowTracker::addString(BufferWriter &aRecord, const char *aValue) {
+  const size_t length = (aValue == NULL) ? 0 : strlen(aValue);
+  if (length > 255) {
+    aRecord.overflowed = true;
+    return;
+  }
+  aRecord.write((uint8_t)length);
+  aRecord.write((const uint8_t*)aValue, length);
+}
+
+/**
+ * Writes a string field of known
+ * length into an event record, as
+ * addField() would but without
+ * checking for room.
+ *
+ * @param aRecord Where to write it
+ * @param aKey The field's kField* key
+ * @param aValue The field's value. If
+ *        NULL the field is left out
+ * @param aLength The length of aValue
+ * @return where the next field goes
+ */
+byte *SnowPlowTracker::putField(byte *aRecord, const byte aKey, const char *aValue, const byte aLength) {
+  if (aValue == NULL) {
+    return aRecord;
+  }
+
+  aRecord[0] = aKey | kFieldString;
+  aRecord[1] = aLength;
+  memcpy(aRecord + 2, aValue, aLength);
+  return aRecord + 2 + aLength;
+}
+
+/**
+ * Writes the time an event is being
+ * created into the start of its
+ * record: now, or when the interrupt
+ * that tracked it happened.
+ *
+ * @param aRecord Where to write it:
+ *        kCreatedLength bytes
+ * @return where the next field goes
+ */
+byte *SnowPlowTracker::putCreated(byte *aRecord) const {
+  const unsigned long created = this->backdated ? this->backdatedTo : millis();
+  aRecord[0] = kFieldCreated | kFieldMillis;
+  memcpy(aRecord + 1, &created, sizeof(created));
+  return aRecord + kCreatedLength;
+}
+
+/**
+ * Reads when an event was tracked
+ * from its record.
+ *
+ * @param aRecord The event's record
+ * @param aLength The length of aRecord
+ * @return millis() when it was tracked,
+ *         or now if the record doesn't
+ *         say (or there isn't one)
+ */
+unsigned long SnowPlowTracker::getCreated(const byte *aRecord, const size_t aLength) {
+  unsigned long created = millis();
+  if ((aLength >= kCreatedLength) && (aRecord[0] == (kFieldCreated | kFieldMillis))) {
+    memcpy(&created, aRecord + 1, sizeof(created));
+  }
+  return created;
+}
+
+/**
+ * Writes an event record out as
+ * URL-encoded name=value pairs, each
+ * preceded by '&', or as JSON members,
+ * each preceded by ','.
+ *
+ * @param aOut Where to write to
+ * @param aRecord The event's fields,
+ *        as written by addField()
+ * @param aLength The length of
+ *        aRecord
+ * @param aEncoding How to write them
+ */
+void SnowPlowTracker::printFields(Print &aOut, const byte *aRecord, const size_t aLength, const Encoding aEncoding) {
+  size_t i = 0;
+  while (i < aLength) {
+    const byte key = aRecord[i] & kFieldKeyMask;
+    if (key >= kFieldCount) {
+      return; // Not a record we understand
+    }
+    if (((aRecord[i] & kFieldTypeMask) == kFieldDouble) && (aLength - i >= 2 + sizeof(double))) {
+      // NaN and infinity aren't numbers the collector can read: leave them out
+      double value;
+      memcpy(&value, aRecord + i + 2, sizeof(value));
+      if (isnan(value) || isinf(value)) {
+        i += 2 + sizeof(value);
+        continue;
+      }
+    }
+
+    printName(aOut, FPSTR(kFieldNames[key]), aEncoding);
+    const size_t length = printField(aOut, aRecord + i, aLength - i, aEncoding);
+    if (length == 0) {
+      return; // Cut short
+    }
+    printValueEnd(aOut, aEncoding);
+    i += length;
+  }
+}
+
+/**
+ * Writes the value of the field at
+ * the start of an event record out
+ * in querystring or JSON string form
+ * (without the quotes).
+ *
+ * @param aOut Where to write to
+ * @param aField The field's tag, and
+ *        what follows it
+ * @param aLength How many bytes of
+ *        the record are left
+ * @param aEncoding How to write it
+ * @return the size of the field, or 0
+ *         if it runs past aLength
+ */
+size_t SnowPlowTracker::printField(Print &aOut, const byte *aField, const size_t aLength, const Encoding aEncoding) {
+  char number[kMaxNumberLength];
+  int intValue;
+  double doubleValue;
+  SnowPlowMetrics::Snapshot snapshot;
+  SnowPlowAggregator::Statistics statistics;
+  size_t length;
+
+  switch (aField[0] & kFieldTypeMask) {
+  case kFieldInt:
+    if (aLength < 1 + sizeof(intValue)) {
+      return 0;
+    }
+    memcpy(&intValue, aField + 1, sizeof(intValue));
+    aOut.print(int2Chars(number, intValue));
+    return 1 + sizeof(intValue);
+  case kFieldDouble:
+    if (aLength < 2 + sizeof(doubleValue)) {
+      return 0;
+    }
+    memcpy(&doubleValue, aField + 2, sizeof(doubleValue));
+    aOut.print(double2Chars(number, doubleValue, aField[1]));
+    return 2 + sizeof(doubleValue);
+  case kFieldMetrics:
+    if (aLength < 1 + sizeof(snapshot)) {
+      return 0;
+    }
+    memcpy(&snapshot, aField + 1, sizeof(snapshot));
+    printMetrics(aOut, snapshot, aEncoding);
+    return 1 + sizeof(snapshot);
+  case kFieldSummary:
+    length = 1 + sizeof(statistics);
+    for (byte i = 0; i < kSummaryStrings; i++) {
+      if ((aLength < length + 1) || (aLength < length + 1 + aField[length])) {
+        return 0;
+      }
+      length += 1 + aField[length];
+    }
+    memcpy(&statistics, aField + 1, sizeof(statistics));
+    printSummary(aOut, statistics, aField + 1 + sizeof(statistics), aEncoding);
+    return length;
+  default:
+    if ((aLength < 2) || (aLength < 2 + (size_t)aField[1])) {
+      return 0;
+    }
+    if (aEncoding == eJson) {
+      jsonEscape(aOut, (const char*)aField + 2, aField[1]);
+    } else {
+      urlEncode(aOut, (const char*)aField + 2, aField[1]);
+    }
+    return 2 + aField[1];
+  }
+}
+
+/**
+ * Writes the ue_pr of a metrics event:
+ * an unstruct_event JSON wrapping the
+ * counts in a self-describing JSON of
+ * their own, encoded as a value.
+ *
+ * @param aOut Where to write to
+ * @param aSnapshot The counts
+ * @param aEncoding How to write them
+ */
+void SnowPlowTracker::printMetrics(Print &aOut, const SnowPlowMetrics::Snapshot &aSnapshot, const Encoding aEncoding) {
+  EncodingWriter writer(aOut, aEncoding);
+  writer.print(F("{\"schema\":\""));
+  writer.print(FPSTR(kUnstructEventSchema));
+  writer.print(F("\",\"data\":{\"schema\":\""));
+  writer.print(FPSTR(kMetricsSchema));
+  writer.print(F("\",\"data\":"));
+  SnowPlowMetrics::printJson(writer, aSnapshot);
+  writer.print(F("}}"));
+}
+
+/**
+ * Writes the ue_pr of a summary event:
+ * an unstruct_event JSON wrapping the
+ * event's strings and statistics in a
+ * self-describing JSON of their own,
+ * encoded as a value.
+ *
+ * @param aOut Where to write to
+ * @param aStatistics The statistics
+ * @param aStrings The category, action,
+ *        label and property, each as
+ *        [length][chars]. The label and
+ *        property are left out if ""
+ * @param aEncoding How to write them
+ */
+void SnowPlowTracker::printSummary(Print &aOut, const SnowPlowAggregator::Statistics &aStatistics, const byte *aStrings, const Encoding aEncoding) {
+  EncodingWriter writer(aOut, aEncoding);
+  writer.print(F("{\"schema\":\""));
+  writer.print(FPSTR(kUnstructEventSchema));
+  writer.print(F("\",\"data\":{\"schema\":\""));
+  writer.print(FPSTR(kSummarySchema));
+  writer.print(F("\",\"data\":{"));
+  for (byte i = 0; i < kSummaryStrings; i++) {
+    if ((i < 2) || (aStrings[0] > 0)) {
+      if (i > 0) {
+        writer.write(',');
+      }
+      writer.write('"');
+      writer.print(FPSTR(kSummaryNames[i]));
+      writer.print(F("\":\""));
+      jsonEscape(writer, (const char*)aStrings + 1, aStrings[0]);
+      writer.write('"');
+    }
+    aStrings += 1 + aStrings[0];
+  }
+  writer.print(F(",\"count\":"));
+  writer.print(aStatistics.count);
+  printJsonNumber(writer, F(",\"min\":"), aStatistics.min, aStatistics.precision);
+  printJsonNumber(writer, F(",\"max\":"), aStatistics.max, aStatistics.precision);
+  printJsonNumber(writer, F(",\"mean\":"), aStatistics.sum / aStatistics.count, aStatistics.precision);
+  printJsonNumber(writer, F(",\"sum\":"), aStatistics.sum, aStatistics.precision);
+  printJsonNumber(writer, F(",\"last\":"), aStatistics.last, aStatistics.precision);
+  writer.print(F("}}}"));
+}
+
+/**
+ * Writes a JSON name and number, or
+ * null if it isn't one: a sum can
+ * overflow to infinity.
+ *
+ * @param aOut Where to write to
+ * @param aName What to write first
+ * @param aValue The number
+ * @param aPrecision How many digits to
+ *        keep after the decimal sign
+ */
+void SnowPlowTracker::printJsonNumber(Print &aOut, const __FlashStringHelper *aName, const double aValue, const byte aPrecision) {
+  char number[kMaxNumberLength];
+  aOut.print(aName);
+  if (isnan(aValue) || isinf(aValue)) {
+    aOut.print(F("null"));
+  } else {
+    aOut.print(double2Chars(number, aValue, aPrecision));
+  }
+}
+
+/**
+ * Converts an int into a stringified float.
+ *
+ * @param aBuffer Where to write the
+ *        String: at least
+ *        kMaxNumberLength chars
+ * @param aInt The integer to convert to
+ *        to a stringified float
+ * @return aBuffer
+ */
+// TODO: can't decide if adding ".0" on the end
+// should be the tracker's job or the ETL.
+char *SnowPlowTracker::int2Chars(char *aBuffer, const int aInt) {
+  strcpy_P(aBuffer + SnowPlowNumber::formatInt(aBuffer, aInt), PSTR(".0"));
+  return aBuffer;
+}
+
+/**
+ * Converts a double (or a float)
+ * into a String. Generated char *is
+ * 1 or more characters long, with the
+ * number of digits after the decimal
+ * point specified by `aPrecision`
+ * (at most SnowPlowNumber::kMaxPrecision).
+ *
+ * @param aBuffer Where to write the
+ *        String: at least
+ *        kMaxNumberLength chars
+ * @param aDbl The double (or float) to
+ *        convert into a String
+ * @return aBuffer
+ */
+char *SnowPlowTracker::double2Chars(char *aBuffer, const double aDouble, const int aPrecision) {
+  SnowPlowNumber::formatDouble(aBuffer, aDouble, (aPrecision < 0) ? 0 : aPrecision);
+  return aBuffer;
+}
+
+/**
+ * Converts an integer value to its
+ * hex character
+ *
+ * @param aChar The character to hexify
+ * @return the character in hex form
+ */
+char SnowPlowTracker::char2Hex(const char aChar) {
+  static const char hex[] PROGMEM = "0123456789abcdef";
+  return pgm_read_byte(&hex[aChar & 15]);
+}
+
+/**
+ * URL-encodes a string, writing it
+ * straight out as we go. Using code
+ * adapted from:
+ *
+ * http://www.geekhideout.com/urlcode.shtml
+ * http://hardwarefun.com/tutorials/url-encoding-in-arduino
+ * 
+ * @param aOut Where to write the
+ *        encoded String
+ * @param aStr The characters to URL-encode.
+ */
+void SnowPlowTracker::urlEncode(Print &aOut, const char* aStr)
+{
+  urlEncode(aOut, aStr, strlen(aStr));
+}
+
+/**
+ * URL-encodes a string kept in
+ * flash, writing it straight out
+ * as we go.
+ *
+ * @param aOut Where to write the
+ *        encoded String
+ * @param aStr The characters to URL-encode
+ */
+void SnowPlowTracker::urlEncode(Print &aOut, const __FlashStringHelper* aStr)
+{
+  const char *pstr = (const char*)aStr;
+  for (char c = pgm_read_byte(pstr); c != '\0'; c = pgm_read_byte(++pstr)) {
+    encodeChar(aOut, c);
+  }
+}
+
+/**
+ * URL-encodes the first aLength
+ * characters of a string, writing
+ * them straight out as we go.
+ *
+ * @param aOut Where to write the
+ *        encoded String
+ * @param aStr The characters to URL-encode
+ * @param aLength How many of them
+ */
+void SnowPlowTracker::urlEncode(Print &aOut, const char* aStr, const size_t aLength)
+{
+  for (const char *pstr = aStr; pstr < aStr + aLength; pstr++) {
+    encodeChar(aOut, *pstr);
+  }
+}
+
+/**
+ * URL-encodes a single character.
+ *
+ * @param aOut Where to write the
+ *        encoded character
+ * @param aChar The character to
+ *        URL-encode
+ */
+void SnowPlowTracker::encodeChar(Print &aOut, const char aChar)
+{
+  if (isalnum(aChar) || aChar == '-' || aChar == '_' || aChar == '.' || aChar == '~') {
+    aOut.write(aChar);
+  } else {
+    aOut.write('%');
+    aOut.write(char2Hex(aChar >> 4));
+    aOut.write(char2Hex(aChar & 15));
+  }
+}
+
+/**
+ * Escapes the first aLength characters
+ * of a string for a JSON string,
+ * writing them straight out as we go.
+ * Anything other than quotes,
+ * backslashes and control characters
+ * (UTF-8 included) goes as it is.
+ *
+ * @param aOut Where to write the
+ *        escaped String
+ * @param aStr The characters to escape
+ * @param aLength How many of them
+ */
+void SnowPlowTracker::jsonEscape(Print &aOut, const char* aStr, const size_t aLength)
+{
+  for (const char *pstr = aStr; pstr < aStr + aLength; pstr++) {
+    escapeChar(aOut, *pstr);
+  }
+}
+
+/**
+ * Escapes a single character for a
+ * JSON string.
+ *
+ * @param aOut Where to write the
+ *        escaped character
+ * @param aChar The character to
+ *        escape
+ */
+void SnowPlowTracker::escapeChar(Print &aOut, const char aChar)
+{
+  if ((aChar == '"') || (aChar == '\\')) {
+    aOut.write('\\');
+    aOut.write(aChar);
+  } else if ((byte)aChar < 0x20) {
+    aOut.print(F("\\u00"));
+    aOut.write(char2Hex(aChar >> 4));
+    aOut.write(char2Hex(aChar & 15));
+  } else {
+    aOut.write(aChar);
+  }
+}
+
+/**
+ * Encodes a string, URL-encoding it
+ * or escaping it for JSON.
+ *
+ * @param aOut Where to write to
+ * @param aStr The characters to encode
+ * @param aEncoding How to encode them
+ */
+void SnowPlowTracker::encode(Print &aOut, const char* aStr, const Encoding aEncoding)
+{
+  if (aEncoding == eJson) {
+    jsonEscape(aOut, aStr, strlen(aStr));
+  } else {
+    urlEncode(aOut, aStr);
+  }
+}
+
+/**
+ * Encodes a string kept in flash,
+ * URL-encoding it or escaping it
+ * for JSON.
+ *
+ * @param aOut Where to write to
+ * @param aStr The characters to encode
+ * @param aEncoding How to encode them
+ */
+void SnowPlowTracker::encode(Print &aOut, const __FlashStringHelper* aStr, const Encoding aEncoding)
+{
+  if (aEncoding == eQuerystring) {
+    urlEncode(aOut, aStr);
+    return;
+  }
+  const char *pstr = (const char*)aStr;
+  for (char c = pgm_read_byte(pstr); c != '\0'; c = pgm_read_byte(++pstr)) {
+    escapeChar(aOut, c);
+  }
+}
+
+/**
+ * Starts a name/value pair after the
+ * first: "&name=" in a querystring,
+ * or ,"name":" in JSON.
+ *
+ * @param aOut Where to write to
+ * @param aName The pair's name
+ * @param aEncoding How to write it
+ */
+void SnowPlowTracker::printName(Print &aOut, const __FlashStringHelper *aName, const Encoding aEncoding)
+{
+  if (aEncoding == eJson) {
+    aOut.print(F(",\""));
+    aOut.print(aName);
+    aOut.print(F("\":\""));
+  } else {
+    aOut.print(F("&"));
+    aOut.print(aName);
+    aOut.print(F("="));
+  }
+}
+
+/**
+ * Ends a name/value pair's value: the
+ * closing quote, in JSON.
+ *
+ * @param aOut Where to write to
+ * @param aEncoding How it was written
+ */
+void SnowPlowTracker::printValueEnd(Print &aOut, const Encoding aEncoding)
+{
+  if (aEncoding == eJson) {
+    aOut.write('"');
+  }
+}
+
+/**
+ * Reads whatever bytes of the HTTP
+ * response have arrived, a buffer's
+ * worth at a time, and advances our
+ * HttpState accordingly. Never waits
+ * for more data.
+ *
+ * When keeping the connection alive
+ * we read the whole response, using
+ * Content-Length to find the end of
+ * the body; otherwise we stop at the
+ * end of the status line.
+ *
+ * Parses a Status-Line like:
+ *   HTTP-Version SP Status-Code SP Reason-Phrase CRLF
+ * Where HTTP-Version is of the form:
+ *   HTTP-Version   = "HTTP" "/" 1*DIGIT "." 1*DIGIT
+ *
+ * Simplified from:
+ *
+ * https://github.com/amcewen/HttpClient/blob/master/HttpClient.cpp
+ * https://github.com/exosite-garage/arduino_exosite_library/blob/master/Exosite.cpp 
  *
- * @param aMac The MAC address, in bytes,
- *             to convert
- * @return the MAC address as a String
+ * @return the HTTP status code as an int,
+ *         an ERROR_* value, or
+ *         kResponsePending if the
+ *         status line isn't complete
+ */
+int SnowPlowTracker::readResponse() {
+
+  byte chunk[kReadBufferSize];
+  while (this->client->available() > 0) {
+    const int length = this->client->read(chunk, sizeof(chunk));
+    if (length <= 0) {
+      break;
+    }
+    // We read something, reset the timeout counter
+    this->timeoutStart = millis();
+
+    for (int i = 0; i < length; i++) {
+      const int c = chunk[i];
+
+      switch (this->httpState) {
+      case eRequestSent:
+        // We haven't reached the status code yet
+        if ((c != '\n') && ((pgm_read_byte(this->statusPtr) == '*') || (pgm_read_byte(this->statusPtr) == c))) {
+          // This character matches, just move along
+          this->statusPtr++;
+          if (pgm_read_byte(this->statusPtr) == '\0') {
+            // We've reached the end of the prefix
+            this->httpState = eReadingStatusCode;
+          }
+        } else {
+          // Not a properly formed status line, or not one we could understand
+          return SnowPlowTracker::ERROR_INVALID_RESPONSE;
+        }
+        break;
+      case eReadingStatusCode:
+        if (isdigit(c)) {
+          // This assumes we won't get more than the 3 digits we want
+          this->statusCode = this->statusCode*10 + (c - '0');
+          break;
+        }
+        // We've reached the end of the status code
+        if ((this->statusCode < 100) || (this->statusCode > 999)) {
+          // Not the three digits it should be
+          return SnowPlowTracker::ERROR_INVALID_RESPONSE;
+        }
+        this->httpState = eStatusCodeRead;
+        if (c != '\n') {
+          break;
+        }
+        // Else the status line ends here
+        // fall through
+      case eStatusCodeRead:
+        // We're just waiting for the end of the line now
+        if (c == '\n') {
+          if ((this->statusCode >= 200) && !this->keepAlive && !this->clock.wantsDate()) {
+            // The rest of the response goes when we close the connection
+            return this->getFinalStatus();
+          }
+          this->startHeaderLine();
+        }
+        break;
+      case eReadingHeader:
+        // At or near the start of a header line: is it Content-Length or Date?
+        if (this->headerPtr == kContentLengthHeader && ((c == '\r') || (c == '\n'))) {
+          // A blank line: the end of the headers
+          this->httpState = eLineStartingCRFound;
+          if (c == '\n') {
+            const int status = this->endHeaders();
+            if (status != this->kResponsePending) {
+              return status;
+            }
+          }
+        } else if (c == '\n') {
+          this->startHeaderLine();
+        } else if (pgm_read_byte(this->headerPtr) == '\0') {
+          // It is: read its value
+          if (isdigit(c)) {
+            this->contentLength = ((this->contentLength < 0) ? 0 : this->contentLength*10) + (c - '0');
+          }
+        } else if (tolower(c) == pgm_read_byte(this->headerPtr)) {
+          this->headerPtr++;
+          if (this->headerPtr == kDateHeader + sizeof(kDateHeader) - 1) {
+            // It's the Date: have the clock parse its value
+            this->clock.startDate();
+            this->httpState = eReadingDate;
+          }
+        } else if ((this->headerPtr == kContentLengthHeader) && (tolower(c) == pgm_read_byte(kDateHeader))) {
+          this->headerPtr = kDateHeader + 1;
+        } else {
+          this->httpState = eSkipToEndOfHeader;
+        }
+        break;
+      case eReadingDate:
+        if (c == '\n') {
+          this->clock.endDate(millis());
+          this->startHeaderLine();
+        } else {
+          this->clock.parseDate(c);
+        }
+        break;
+      case eSkipToEndOfHeader:
+        if (c == '\n') {
+          this->startHeaderLine();
+        }
+        break;
+      case eLineStartingCRFound:
+        if (c == '\n') {
+          const int status = this->endHeaders();
+          if (status != this->kResponsePending) {
+            return status;
+          }
+        } else {
+          this->httpState = eSkipToEndOfHeader;
+        }
+        break;
+      case eReadingBody:
+        // We don't need the body, just to get past it
+        if (--this->contentLength <= 0) {
+          this->responseComplete = true;
+          return this->getFinalStatus();
+        }
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  if ((millis() - this->timeoutStart) >= this->responseTimeout) {
+    // We must've timed out before we reached the end of the response
+    return SnowPlowTracker::ERROR_TIMED_OUT;
+  }
+  return this->kResponsePending;
+}
+
+/**
+ * Gets ready to read the next line
+ * of the response headers.
  */
-char *SnowPlowTracker::mac2Chars(const byte* aMac) {
-  const size_t bufferLength = 18; // 17 chars plus \0
-  char *buffer = (char*)malloc(bufferLength);
-  snprintf(buffer, bufferLength, "%02X:%02X:%02X:%02X:%02X:%02X",
-          aMac[0],
-          aMac[1],
-          aMac[2],
-          aMac[3],
-          aMac[4],
-          aMac[5]);
-  return buffer;
+void SnowPlowTracker::startHeaderLine() {
+  this->headerPtr = kContentLengthHeader;
+  this->httpState = eReadingHeader;
 }
 
 /**
- * Returns the length of an array
- * of QuerystringPairs. Assumes
- * the array ends with a sentinel
- * value of NULL.
+ * Works out what comes after the
+ * blank line ending the headers.
  *
- * @param aPairs The QuerystringPairs
- *        to count
- * @return the number of pairs in the
- *         array
+ * @return the final status if the
+ *         response is complete, else
+ *         kResponsePending
  */
-int SnowPlowTracker::countPairs(const QuerystringPair aPairs[]) {
-  int i = 1;
-  while (aPairs[i].name != NULL) {
-    i++;
+int SnowPlowTracker::endHeaders() {
+  if (this->statusCode < 200) {
+    // An informational (1xx) response: just ignore it,
+    // and read the next one for a proper response
+    this->statusCode = 0;
+    this->statusPtr = kHttpStatusPrefix;
+    this->contentLength = -1;
+    this->httpState = eRequestSent;
+    return this->kResponsePending;
+  }
+
+  if (!this->keepAlive) {
+    // We only read the headers for the Date: the body
+    // goes when we close the connection
+    return this->getFinalStatus();
   }
-  return i;
+
+  if (this->contentLength > 0) {
+    this->httpState = eReadingBody;
+    return this->kResponsePending;
+  }
+
+  // With no Content-Length we can't tell where the body
+  // ends, so the connection can't be used again
+  this->responseComplete = (this->contentLength == 0);
+  return this->getFinalStatus();
 }
 
 /**
- * Converts an int into a stringified float.
+ * Turns the status code we've read
+ * into our return value.
  *
- * IMPORTANT: be sure to free() the returned
- * string after use
- *
- * @param aInt The integer to convert to
- *        to a stringified float
- * @return the converted String
+ * @return the HTTP status code, or
+ *         ERROR_HTTP_STATUS for a
+ *         client or server error
  */
-// TODO: can't decide if adding ".0" on the end
-// should be the tracker's job or the ETL.
-char *SnowPlowTracker::int2Chars(const int aInt) {
-  const size_t bufferLength = 14; // "-2147483648.0\0"
-  char *buffer = (char*)malloc(bufferLength);
-  snprintf(buffer, bufferLength, "%d.0", aInt);
-  return buffer;
+int SnowPlowTracker::getFinalStatus() const {
+  if (this->statusCode < 400) {
+    return this->statusCode;
+  } else {
+    return SnowPlowTracker::ERROR_HTTP_STATUS;
+  }
 }
 
 /**
- * Converts a double (or a float)
- * into a String. Generated char *is
- * 1 or more characters long, with the
- * number of digits after the decimal
- * point specified by `aPrecision`.
+ * Return the HTTP status code from this request,
+ * blocking until the status line has been read.
  *
- * IMPORTANT: be sure to free() the returned
- * string after use
+ * While no data is available we poll again after
+ * 1ms, doubling the wait each time up to the
+ * limit set by setPollBackoff().
  *
- * @param aDbl The double (or float) to
- *        convert into a String
- * @return the converted String
+ * @return the HTTP status code as an int
+ */ 
+int SnowPlowTracker::getResponseCode() {
+  int status;
+  unsigned long wait = kMinPollDelay;
+  unsigned long lastData = this->timeoutStart;
+  while ((status = this->transport->readResponse()) == this->kResponsePending) {
+    if (this->timeoutStart != lastData) {
+      // Data's arriving, so it shouldn't be long before there's more
+      lastData = this->timeoutStart;
+      wait = kMinPollDelay;
+    }
+    // No data available, so pause to allow some to arrive
+    delay(wait);
+    wait = (wait * 2 < this->pollBackoff) ? wait * 2 : this->pollBackoff;
+  }
+  return status;
+}
+
+/**
+ * Writes one event, as a querystring
+ * or a JSON object: its transaction
+ * ID, our fixed tracker pairs, when
+ * it was created and sent, and then
+ * the event's own.
+ *
+ * @param aOut Where to write to
+ * @param aTxnId The transaction ID
+ *        for this event
+ * @param aRecord The event's fields,
+ *        as written by addField()
+ * @param aLength The length of
+ *        aRecord
+ * @param aEncoding How to write it
  */
-char *SnowPlowTracker::double2Chars(const double aDouble, const int aPrecision) {
-  const size_t bufferLength = 25;
-  char *buffer = (char*)malloc(bufferLength);
-  dtostrf(aDouble, 1, aPrecision, buffer);
-  return buffer;
+void SnowPlowTracker::writeEvent(Print &aOut, const int aTxnId, const byte *aRecord, const size_t aLength, const Encoding aEncoding) const {
+
+  char txnId[kMaxNumberLength];
+  aOut.print((aEncoding == eJson) ? F("{\"tid\":\"") : F("tid="));
+  aOut.print(int2Chars(txnId, aTxnId));
+  printValueEnd(aOut, aEncoding);
+
+  const char *context = (aEncoding == eJson) ? this->encodedJsonContext : this->encodedContext;
+  if (context != NULL) {
+    aOut.print(context);
+  } else {
+    this->writeContext(aOut, aEncoding);
+  }
+
+  const size_t created = this->writeCreated(aOut, aRecord, aLength, aEncoding);
+  printName(aOut, F("stm"), aEncoding);
+  this->clock.printTime(aOut, this->requestStamp, this->requestStamp);
+  printValueEnd(aOut, aEncoding);
+  printFields(aOut, aRecord + created, aLength - created, aEncoding);
+  if (aEncoding == eJson) {
+    aOut.write('}');
+  }
 }
 
 /**
- * Converts an integer value to its
- * hex character
+ * Writes the time an event was created
+ * as a dtm pair, if its record starts
+ * with it and it's known.
  *
- * @param aChar The character to hexify
- * @return the character in hex form
+ * @param aOut Where to write to
+ * @param aRecord The event's fields,
+ *        as written by addField()
+ * @param aLength The length of
+ *        aRecord
+ * @param aEncoding How to write it
+ * @return how many bytes of aRecord
+ *         the created time took up
  */
-char SnowPlowTracker::char2Hex(const char aChar) {
-  static char hex[] = "0123456789abcdef";
-  return hex[aChar & 15];
+size_t SnowPlowTracker::writeCreated(Print &aOut, const byte *aRecord, const size_t aLength, const Encoding aEncoding) const {
+  if ((aLength < kCreatedLength) || ((aRecord[0] & kFieldKeyMask) != kFieldCreated)) {
+    return 0;
+  }
+
+  unsigned long created;
+  memcpy(&created, aRecord + 1, sizeof(created));
+  if ((aRecord[0] & kFieldTypeMask) == kFieldMillis) {
+    printName(aOut, FPSTR(kFieldNames[kFieldCreated]), aEncoding);
+    this->clock.printTime(aOut, created, this->requestStamp);
+    printValueEnd(aOut, aEncoding);
+  } else if (created != 0) {
+    printName(aOut, FPSTR(kFieldNames[kFieldCreated]), aEncoding);
+    aOut.print(created);
+    aOut.print(F("000"));
+    printValueEnd(aOut, aEncoding);
+  }
+  return kCreatedLength;
 }
 
 /**
- * URL-encodes a string. Using code
- * adapted from:
+ * Writes our fixed tracker pairs,
+ * each preceded by '&' (or ',' in
+ * JSON).
  *
- * http://www.geekhideout.com/urlcode.shtml
- * http://hardwarefun.com/tutorials/url-encoding-in-arduino
+ * @param aOut Where to write to
+ * @param aEncoding How to write them
+ */
+void SnowPlowTracker::writeContext(Print &aOut, const Encoding aEncoding) const {
+  printName(aOut, F("p"), aEncoding);
+  encode(aOut, FPSTR(kTrackerPlatform), aEncoding);
+  printValueEnd(aOut, aEncoding);
+  printName(aOut, F("mac"), aEncoding);
+  encode(aOut, this->macAddress, aEncoding);
+  printValueEnd(aOut, aEncoding);
+
+  // Only add if value is not null
+  if (this->userId != NULL) {
+    printName(aOut, F("uid"), aEncoding);
+    encode(aOut, this->userId, aEncoding);
+    printValueEnd(aOut, aEncoding);
+  }
+  if (this->appId != NULL) {
+    printName(aOut, F("aid"), aEncoding);
+    encode(aOut, this->appId, aEncoding);
+    printValueEnd(aOut, aEncoding);
+  }
+
+  printName(aOut, F("tv"), aEncoding);
+  encode(aOut, FPSTR(kTrackerVersion), aEncoding);
+  printValueEnd(aOut, aEncoding);
+}
+
+/**
+ * Encodes the parts of each request
+ * that only change when we're set up:
+ * our tracker pairs and our headers.
+ * Called whenever any of those
+ * settings change, so that sending
+ * an event doesn't have to encode
+ * them again.
  *
- * IMPORTANT: be sure to free() the returned
- * string after use
- * 
- * @param aStr The characters to URL-encode.
- * @return the encoded String
+ * If there's no memory for them, we
+ * fall back to encoding them for
+ * every request.
  */
-char *SnowPlowTracker::urlEncode(const char* aStr)
-{
-  const size_t bufferLength = strlen(aStr) * 3 + 1;
-  char *pstr = (char*)aStr, *encodedStr = (char*)malloc(bufferLength), *pbuf = encodedStr;
-  
-  while (*pstr) {
-    if (isalnum(*pstr) || *pstr == '-' || *pstr == '_' || *pstr == '.' || *pstr == '~') 
-      *pbuf++ = *pstr;
-    else 
-      *pbuf++ = '%', *pbuf++ = char2Hex(*pstr >> 4), *pbuf++ = char2Hex(*pstr & 15);
-    pstr++;
-  }
-  *pbuf = '\0'; // Tail it
-  
-  return encodedStr;
+void SnowPlowTracker::encodeRequestParts() {
+  ByteCounter counter;
+
+  free(this->encodedContext);
+  this->writeContext(counter, eQuerystring);
+  this->encodedContext = (char*)malloc(counter.count + 1);
+  if (this->encodedContext != NULL) {
+    BufferWriter writer(this->encodedContext, counter.count + 1);
+    this->writeContext(writer, eQuerystring);
+    writer.terminate();
+  }
+  this->transport->setContext(this->encodedContext);
+
+  // Batches are POSTed as JSON
+  free(this->encodedJsonContext);
+  this->encodedJsonContext = NULL;
+  if (this->batchSize > 1) {
+    counter.count = 0;
+    this->writeContext(counter, eJson);
+    this->encodedJsonContext = (char*)malloc(counter.count + 1);
+    if (this->encodedJsonContext != NULL) {
+      BufferWriter writer(this->encodedJsonContext, counter.count + 1);
+      this->writeContext(writer, eJson);
+      writer.terminate();
+    }
+  }
+
+  free(this->encodedHeaders);
+  this->encodedHeaders = NULL;
+  if (this->collectorHost == NULL) {
+    // Not initialized yet: init() calls us again
+    return;
+  }
+  counter.count = 0;
+  this->writeHeaderBlock(counter);
+  this->encodedHeaders = (char*)malloc(counter.count + 1);
+  if (this->encodedHeaders != NULL) {
+    BufferWriter writer(this->encodedHeaders, counter.count + 1);
+    this->writeHeaderBlock(writer);
+    writer.terminate();
+  }
 }
 
 /**
- * Return the HTTP status code from this request.
+ * Writes the body of a batch POST:
+ * a payload_data JSON object, with
+ * an object for each event in the
+ * batch.
  *
- * Parses a Status-Line like:
- *   HTTP-Version SP Status-Code SP Reason-Phrase CRLF
- * Where HTTP-Version is of the form:
- *   HTTP-Version   = "HTTP" "/" 1*DIGIT "." 1*DIGIT
+ * @param aOut Where to write to
+ * @param aFirstTxnId The transaction
+ *        ID for the first event; the
+ *        rest count up from it
+ * @param aCount How many events from
+ *        the front of the queue (or
+ *        outbox, when replaying) to
+ *        write
+ */
+void SnowPlowTracker::writeBatch(Print &aOut, const int aFirstTxnId, const size_t aCount) {
+  aOut.print(F("{\"schema\":\""));
+  aOut.print(FPSTR(kPayloadDataSchema));
+  aOut.print(F("\",\"data\":["));
+  for (size_t i = 0; i < aCount; i++) {
+    this->eventLength = (this->requestSource == eFromOutbox) ?
+      this->outbox->peek(this->eventRecord, sizeof(this->eventRecord), i) :
+      this->peekQueued(this->eventRecord, sizeof(this->eventRecord), i);
+
+    if (i > 0) {
+      aOut.write(',');
+    }
+    this->writeEvent(aOut, aFirstTxnId + i, this->eventRecord, this->eventLength, eJson);
+  }
+  aOut.print(F("]}"));
+}
+
+/**
+ * Writes the body of a batch POST,
+ * gzipped if compression is on.
  *
- * Simplified from:
+ * @param aOut Where to write to
+ * @param aFirstTxnId The transaction
+ *        ID for the first event
+ * @param aCount How many events to
+ *        write
+ */
+void SnowPlowTracker::writeBody(Print &aOut, const int aFirstTxnId, const size_t aCount) {
+  if (this->compressor == NULL) {
+    this->writeBatch(aOut, aFirstTxnId, aCount);
+    return;
+  }
+  this->compressor->begin(aOut);
+  this->writeBatch(*this->compressor, aFirstTxnId, aCount);
+  this->compressor->end();
+}
+
+/**
+ * Writes the headers common to all
+ * our requests, up to and including
+ * the blank line ending them.
+ */
+void SnowPlowTracker::writeHeaders() {
+  if (this->encodedHeaders != NULL) {
+    this->out.print(this->encodedHeaders);
+  } else {
+    this->writeHeaderBlock(this->out);
+  }
+}
+
+/**
+ * Encodes the headers common to all
+ * our requests, up to and including
+ * the blank line ending them.
  *
- * https://github.com/amcewen/HttpClient/blob/master/HttpClient.cpp
- * https://github.com/exosite-garage/arduino_exosite_library/blob/master/Exosite.cpp 
+ * @param aOut Where to write to
+ */
+void SnowPlowTracker::writeHeaderBlock(Print &aOut) const {
+  aOut.print(F("Host: "));
+  aOut.print(this->collectorHost);
+  if (this->collectorPort != kCollectorPort) {
+    aOut.print(F(":"));
+    aOut.print(this->collectorPort);
+  }
+  aOut.println();
+  aOut.print(F("User-Agent: "));
+  aOut.println(FPSTR(kUserAgent));
+  if (this->keepAlive) {
+    aOut.println(F("Connection: keep-alive"));
+  } else {
+    aOut.println(F("Connection: close"));
+  }
+  aOut.println();
+}
+
+/**
+ * Connects to the collector, unless
+ * we're keeping the connection alive
+ * and it's still open. We connect by
+ * its cached IP address, so there's
+ * no DNS lookup per event.
  *
- * @return the HTTP status code as an int
- */ 
-int SnowPlowTracker::getResponseCode() const {
-  int statusCode;
-  HttpState httpState;
-
-  char c = '\0';
-  do
-  {
-    // Make sure the status code is reset, and likewise the state.
-    // Lets us easily cope with 1xx informational responses by just
-    // ignoring them really, and reading the next line for a proper response
-    statusCode = 0;
-    httpState = eRequestSent;
-
-    unsigned long timeoutStart = millis();
-    // Psuedo-regexp we're expecting before the status-code
-    const char* statusPrefix = "HTTP/*.* ";
-    const char* statusPtr = statusPrefix;
-    
-    // Whilst we haven't timed out & haven't reached the end of the headers
-    while ((c != '\n') && ((millis() - timeoutStart) < this->kHttpResponseTimeout )) {
-      if (this->client->available()) {
-        c = this->client->read();
-        if (c != -1) {
-          switch (httpState) {
-          case eRequestSent:
-            // We haven't reached the status code yet
-            if ((*statusPtr == '*') || (*statusPtr == c)) {
-              // This character matches, just move along
-              statusPtr++;
-              if (*statusPtr == '\0') {
-                // We've reached the end of the prefix
-                httpState = eReadingStatusCode;
-              }
-            } else {
-              return SnowPlowTracker::ERROR_INVALID_RESPONSE;
-            }
-            break;
-          case eReadingStatusCode:
-            if (isdigit(c)) {
-              // This assumes we won't get more than the 3 digits we want
-              statusCode = statusCode*10 + (c - '0');
-            } else {
-              // We've reached the end of the status code
-              httpState = eStatusCodeRead;
-            }
-            break;
-          case eStatusCodeRead:
-            // We're just waiting for the end of the line now
-            break;
-          };
-          // We read something, reset the timeout counter
-          timeoutStart = millis();
-        }
-      } else {
-        // No data available, so pause to allow some to arrive
-        delay(this->kHttpWaitForDataDelay);
-      }
-    }
+ * @param aPort The port to
+ *        connect to
+ * @return true if we're connected
+ */
+bool SnowPlowTracker::connect(const int aPort) {
+  if (this->keepAlive && this->client->connected()) {
+    return true;
+  }
 
-    // Have we reached the end of an informational status line?
-    if ((c == '\n') && (statusCode < 200)) {
-      c = '\0'; // Clear c so we'll go back into the data reading loop
-    }
+  // The server may have closed its end: tidy up ours
+  this->client->stop();
+  if (this->ethernet == NULL) {
+    // Not an Ethernet shield: the client looks the host up itself
+    return this->client->connect(this->collectorHost, aPort);
+  }
+  const bool cached = this->collectorResolved;
+  if (!this->resolve(false)) {
+    return false;
+  }
+  if (this->client->connect(this->collectorIp, aPort)) {
+    return true;
+  }
 
-  // If we've read a status code successfully but it's informational (1xx)
-  // loop back to the start
-  } while ((httpState == eStatusCodeRead) && (statusCode < 200));
+  // It may have moved: look it up again, and retry if it has
+  const IPAddress lastIp = this->collectorIp;
+  if (!cached || !this->resolve(true) || (this->collectorIp == lastIp)) {
+    return false;
+  }
+  this->client->stop();
+  return this->client->connect(this->collectorIp, aPort);
+}
 
-  // Now return status code as appropriate
-  if ((c == '\n') && (httpState == eStatusCodeRead)) {
-    // We've read the status-line successfully, check if it's an error code
-    if (statusCode < 400) {
-      return statusCode;
-    } else {
-      return SnowPlowTracker::ERROR_HTTP_STATUS;
-    }
-  } else if (c != '\n') {
-    // We must've timed out before we reached the end of the line
-    return SnowPlowTracker::ERROR_TIMED_OUT;
+/**
+ * Looks up the collector's IP address,
+ * unless we looked it up less than
+ * dnsCacheTtl ms ago.
+ *
+ * @param aForce Whether to look it up
+ *        even if we already have it
+ * @return true if we have its address
+ */
+bool SnowPlowTracker::resolve(const bool aForce) {
+  if (!aForce && this->collectorResolved && (millis() - this->resolvedAt < this->dnsCacheTtl)) {
+    return true;
+  }
+
+  DNSClient dns;
+  dns.begin(this->ethernet->dnsServerIP());
+  this->collectorResolved = (dns.getHostByName(this->collectorHost, this->collectorIp) == 1);
+  this->resolvedAt = millis();
+
+  if (!this->collectorResolved) {
+    LOG_ERROR(F("Couldn't resolve collector host ["));
+    LOG_ERROR(this->collectorHost);
+    LOGLN_ERROR(F("]"));
   }
+  return this->collectorResolved;
+}
 
-  // Fallback: not a properly formed status line, or not one we could understand
-  return SnowPlowTracker::ERROR_INVALID_RESPONSE;
+/**
+ * Resets our HttpState ready to
+ * read the response to the request
+ * just sent.
+ */
+void SnowPlowTracker::awaitResponse() {
+  this->statusCode = 0;
+  this->statusPtr = kHttpStatusPrefix;
+  this->contentLength = -1;
+  this->responseComplete = false;
+  this->timeoutStart = millis();
+  this->requestSentAt = this->timeoutStart;
+  this->httpState = eRequestSent;
 }
 
 /**
- * Performs a GET against the
- * specified URI, passing in
- * the given parameters and
- * headers.
+ * Connects to the specified URI
+ * and writes a GET for it, passing
+ * in the given event on the
+ * querystring. The response is left
+ * for readResponse().
  *
- * @param aHost The hostname of
- *        the URI to GET
  * @param aPort The port of the
  *        URI to GET
  * @param aPath The path of the
  *        URI to GET
- * @param aParameters The name-
- *        value pairs to append
- *        on the querystring
- * @return An integer indicating the
- *         success/failure of logging
- *         the event to SnowPlow
+ * @param aTxnId The transaction ID
+ *        for this event
+ * @param aRecord The event's fields,
+ *        as written by addField()
+ * @param aLength The length of
+ *        aRecord
+ * @return 0 if the GET was sent,
+ *         else ERROR_CONNECTION_FAILED
  */
 int SnowPlowTracker::getUri(
-  const char *aHost,
   const int aPort,
-  const char *aPath,
-  const QuerystringPair aPairs[]) const {
+  const __FlashStringHelper *aPath,
+  const int aTxnId,
+  const byte *aRecord,
+  const size_t aLength) {
 
   // Connect to the host
-  if (this->client->connect(aHost, aPort)) {
+  const unsigned long connectStart = micros();
+  if (this->connect(aPort)) {
+    const unsigned long sendStart = micros();
+    SnowPlowMetrics::addLatency(this->metrics.connectLatency, (sendStart - connectStart) / 1000);
+
     // Build our GET line from:
     // 1. The URI path... 
-    this->client->print("GET ");
-    LOG_DEBUG("GET ");
-    this->client->print(aPath);
+    this->out.print(F("GET "));
+    LOG_DEBUG(F("GET "));
+    this->out.print(aPath);
     LOG_DEBUG(aPath);
 
-    // 2. The querychar *name-value pairs
-    if (aPairs != NULL) {
-      this->client->print("?");
-      LOG_DEBUG("?");
-      char idx = 0;
-      QuerystringPair* pair = (QuerystringPair*)&aPairs[0];
-      // Loop for all pairs
-      while (pair->name != NULL) {
-        // Only add if value is not null
-        if (pair->value != NULL) {
-          if (idx > 0) {
-            this->client->print("&");
-            LOG_DEBUG("&");
-          }
-          
-          this->client->print(pair->name);
-          LOG_DEBUG(pair->name);
-
-          this->client->print("=");
-          LOG_DEBUG("=");
-          
-          char *encoded = urlEncode(pair->value);
-          this->client->print(encoded);
-          LOG_DEBUG(encoded);
-          free(encoded);
-        }
-        pair = (QuerystringPair*)&aPairs[++idx];
-      }
-    }
+    // 2. The querystring name-value pairs
+    this->out.print(F("?"));
+    LOG_DEBUG(F("?"));
+    this->writeEvent(this->out, aTxnId, aRecord, aLength, eQuerystring);
+#if LOG_LEVEL >= DEBUG_LEVEL
+    this->writeEvent(Serial, aTxnId, aRecord, aLength, eQuerystring);
+#endif
 
     // 3. Finish the GET definition
-    this->client->println(" HTTP/1.1");
-    LOGLN_DEBUG(" HTTP/1.1");
+    this->out.println(F(" HTTP/1.1"));
+    LOGLN_DEBUG(F(" HTTP/1.1"));
+
+    // Headers
+    this->writeHeaders();
+    this->out.flush();
+    SnowPlowMetrics::addLatency(this->metrics.sendLatency, (micros() - sendStart) / 1000);
+    return 0;
+  } else {
+    // Connection didn't work
+    return SnowPlowTracker::ERROR_CONNECTION_FAILED;
+  }
+}
+
+/**
+ * Connects to the specified URI
+ * and POSTs a batch of events to
+ * it, as payload_data JSON (see
+ * writeBatch()). The response is
+ * left for readResponse().
+ *
+ * @param aPort The port of the
+ *        URI to POST to
+ * @param aPath The path of the
+ *        URI to POST to
+ * @param aFirstTxnId The transaction
+ *        ID for the first event
+ * @param aCount How many events from
+ *        the front of the queue to
+ *        send
+ * @return 0 if the POST was sent,
+ *         else ERROR_CONNECTION_FAILED
+ */
+int SnowPlowTracker::postUri(
+  const int aPort,
+  const __FlashStringHelper *aPath,
+  const int aFirstTxnId,
+  const size_t aCount) {
+
+  // We need the body's length up front for the Content-Length
+  ByteCounter counter;
+  this->writeBody(counter, aFirstTxnId, aCount);
+
+  // Connect to the host
+  const unsigned long connectStart = micros();
+  if (this->connect(aPort)) {
+    const unsigned long sendStart = micros();
+    SnowPlowMetrics::addLatency(this->metrics.connectLatency, (sendStart - connectStart) / 1000);
+
+    this->out.print(F("POST "));
+    LOG_DEBUG(F("POST "));
+    this->out.print(aPath);
+    LOG_DEBUG(aPath);
+    this->out.println(F(" HTTP/1.1"));
+    LOG_DEBUG(F(" HTTP/1.1 ("));
+    LOG_DEBUG(aCount);
+    LOGLN_DEBUG(F(" events)"));
 
     // Headers
-    this->client->print("Host: ");
-    this->client->println(aHost);
-    this->client->print("User-Agent: ");
-    this->client->println(this->kUserAgent);
-    this->client->println("Connection: close");
-    this->client->println();
-    // End of headers
-
-    // Check and return HTTP status code value
-    const int code = getResponseCode();
-    this->client->stop(); // Important: close the connection
-    return code;
+    this->out.println(F("Content-Type: application/json; charset=utf-8"));
+    if (this->compressor != NULL) {
+      this->out.println(F("Content-Encoding: gzip"));
+    }
+    this->out.print(F("Content-Length: "));
+    this->out.println(counter.count);
+    this->writeHeaders();
+
+    // Body
+    this->writeBody(this->out, aFirstTxnId, aCount);
+    this->out.flush();
+    SnowPlowMetrics::addLatency(this->metrics.sendLatency, (micros() - sendStart) / 1000);
+    return 0;
   } else {
     // Connection didn't work
     return SnowPlowTracker::ERROR_CONNECTION_FAILED;
   }
 }
+
+/**
+ * Sends a request over HTTP, as a GET
+ * of one event or a POST of a batch.
+ * The records come straight from where
+ * the tracker keeps them, so aRecords
+ * isn't needed.
+ *
+ * @param aRecords Unused
+ * @param aCount Unused
+ * @return 0 if the request was sent,
+ *         else ERROR_CONNECTION_FAILED
+ */
+int SnowPlowTracker::HttpTransport::startRequest(Records &aRecords, const size_t aCount) {
+  return this->tracker->startHttpRequest();
+}
+
+/**
+ * @return the HTTP status code, an
+ *         ERROR_* value or
+ *         kResponsePending
+ */
+int SnowPlowTracker::HttpTransport::readResponse() {
+  return this->tracker->readResponse();
+}
+
+/**
+ * @return the status code of the
+ *         last HTTP response
+ */
+int SnowPlowTracker::HttpTransport::getStatusCode() const {
+  return this->tracker->statusCode;
+}
+
+/**
+ * Closes the connection, unless we're
+ * keeping it alive and the response
+ * was read to the end.
+ *
+ * @param aStatus How the request ended
+ */
+void SnowPlowTracker::HttpTransport::endRequest(const int aStatus) {
+  if (!this->tracker->keepAlive || !this->tracker->responseComplete) {
+    this->tracker->client->stop(); // Important: close the connection
+  }
+}
+
+/**
+ * Copies the record of one of the
+ * events being sent: the event itself,
+ * or one from the batch at the front
+ * of the queue (or outbox).
+ *
+ * @param aIndex Which event
+ * @param aBuffer Where to copy it to
+ * @param aSize The size of aBuffer
+ * @return the record's length, or 0
+ *         if there's no such event or
+ *         it doesn't fit
+ */
+size_t SnowPlowTracker::RecordReader::get(const size_t aIndex, byte *aBuffer, const size_t aSize) {
+  SnowPlowTracker *tracker = this->tracker;
+  if (tracker->batchCount == 0) {
+    if ((aIndex > 0) || (tracker->eventLength > aSize)) {
+      return 0;
+    }
+    memcpy(aBuffer, tracker->eventRecord, tracker->eventLength);
+    return tracker->eventLength;
+  }
+  return (tracker->requestSource == eFromOutbox) ?
+    tracker->outbox->peek(aBuffer, aSize, aIndex) :
+    tracker->peekQueued(aBuffer, aSize, aIndex);
+}
+
+/**
+ * Counts the bytes written to it
+ * rather than sending them anywhere.
+ *
+ * @param aChar The byte written
+ * @return 1, the number of bytes
+ *         "written"
+ */
+size_t SnowPlowTracker::ByteCounter::write(uint8_t aChar) {
+  this->count++;
+  return 1;
+}
+
+/**
+ * URL-encodes the byte written to it,
+ * or escapes it for a JSON string,
+ * on its way out.
+ *
+ * @param aChar The byte written
+ * @return 1
+ */
+size_t SnowPlowTracker::EncodingWriter::write(uint8_t aChar) {
+  if (this->encoding == eJson) {
+    escapeChar(*this->out, aChar);
+  } else {
+    encodeChar(*this->out, aChar);
+  }
+  return 1;
+}
+
+/**
+ * Adds a byte to the request, sending
+ * the buffer on to the client first
+ * if it's full.
+ *
+ * @param aChar The byte to write
+ * @return 1, the number of bytes
+ *         written
+ */
+size_t SnowPlowTracker::RequestWriter::write(uint8_t aChar) {
+  if (this->length == this->size) {
+    this->flush();
+  }
+  this->buffer[this->length++] = aChar;
+  return 1;
+}
+
+/**
+ * Adds a run of bytes to the request,
+ * sending the buffer on to the client
+ * each time it fills up.
+ *
+ * @param aBuffer The bytes to write
+ * @param aSize How many bytes to write
+ * @return aSize, the number of bytes
+ *         written
+ */
+size_t SnowPlowTracker::RequestWriter::write(const uint8_t *aBuffer, size_t aSize) {
+  const size_t written = aSize;
+  while (aSize > 0) {
+    if (this->length == this->size) {
+      this->flush();
+    }
+    const size_t room = this->size - this->length;
+    const size_t chunk = (aSize < room) ? aSize : room;
+    memcpy(this->buffer + this->length, aBuffer, chunk);
+    this->length += chunk;
+    aBuffer += chunk;
+    aSize -= chunk;
+  }
+  return written;
+}
+
+/**
+ * Sends whatever is in the buffer to
+ * the client in one write.
+ */
+void SnowPlowTracker::RequestWriter::flush() {
+  if (this->length > 0) {
+    this->client->write(this->buffer, this->length);
+    *this->written += this->length;
+    this->length = 0;
+  }
+}
+
+/**
+ * Appends a byte to the buffer, if
+ * there's room for it (and the
+ * trailing \0).
+ *
+ * @param aChar The byte to write
+ * @return 1 if it was written, else 0
+ */
+size_t SnowPlowTracker::BufferWriter::write(uint8_t aChar) {
+  if (this->length + 1 >= this->size) {
+    this->overflowed = true;
+    return 0;
+  }
+  this->buffer[this->length++] = aChar;
+  return 1;
+}
+
+/**
+ * Tails the buffer with a \0.
+ *
+ * @return the length of the String
+ *         written, or -1 if it didn't
+ *         all fit
+ */
+int SnowPlowTracker::BufferWriter::terminate() {
+  this->buffer[this->length] = '\0';
+  return this->overflowed ? -1 : (int)this->length;
+}
+
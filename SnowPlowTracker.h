@@ -25,6 +25,17 @@
 #include <SPI.h>
 #include <Ethernet.h>
 #include <EthernetClient.h>
+#include <Client.h>
+#include <Dns.h>
+#include "SnowPlowEventQueue.h"
+#include "SnowPlowOutbox.h"
+#include "SnowPlowInterruptQueue.h"
+#include "SnowPlowAggregator.h"
+#include "SnowPlowNumber.h"
+#include "SnowPlowMetrics.h"
+#include "SnowPlowTransport.h"
+#include "SnowPlowCompressor.h"
+#include "SnowPlowClock.h"
 
 // Logging - adapted from https://github.com/dmcrodrigues/macro-logger
 #define NO_LOG          0x00
@@ -63,6 +74,67 @@
 #define LOGLN_ERROR(...)
 #endif
 
+// Constant strings are kept in flash (PROGMEM) on AVR, where
+// string literals would otherwise be copied into SRAM at boot.
+// Elsewhere these fall back to plain memory access
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef PSTR
+#define PSTR(aString) (aString)
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(aAddress) (*(const unsigned char *)(aAddress))
+#endif
+#ifndef strlen_P
+#define strlen_P strlen
+#endif
+#ifndef strcpy_P
+#define strcpy_P strcpy
+#endif
+#ifndef strcat_P
+#define strcat_P strcat
+#endif
+#endif
+
+// Lets a PROGMEM string be print()ed like an F() one
+#ifndef FPSTR
+#define FPSTR(aString) (reinterpret_cast<const __FlashStringHelper *>(aString))
+#endif
+
+// The sizes below are macros so that boards
+// can tune them, but they size members of
+// SnowPlowTracker: the library and every
+// sketch using it must agree on them, or
+// they disagree on its layout and corrupt
+// memory without a word. So set them as
+// build flags for the whole library (e.g.
+// build_flags in PlatformIO), never with a
+// #define in the sketch. Queue sizes are
+// set at run time: see setQueue()
+
+// Longest encoded event (its category,
+// action etc) we can hold for sending
+#ifndef SNOWPLOW_MAX_EVENT_LENGTH
+#define SNOWPLOW_MAX_EVENT_LENGTH 192
+#endif
+
+// ms to give an Ethernet shield after begin()
+// before using it. Boards that power the
+// shield up themselves can make it 0
+#ifndef SNOWPLOW_ETHERNET_BOOT_DELAY
+#define SNOWPLOW_ETHERNET_BOOT_DELAY 1000
+#endif
+
+// Bytes of RAM used to gather up each request
+// before writing it to the Ethernet shield
+#ifndef SNOWPLOW_WRITE_BUFFER_SIZE
+#define SNOWPLOW_WRITE_BUFFER_SIZE 128
+#endif
+
 /**
  * SnowPlowTracker encapsulates our Arduino
  * tracking code for SnowPlow.
@@ -82,41 +154,219 @@ class SnowPlowTracker
   static const int ERROR_MISSING_ARGUMENT = -4;
   // We had a client or server HTTP error
   static const int ERROR_HTTP_STATUS = -5;  
+  // The encoded event doesn't fit in SNOWPLOW_MAX_EVENT_LENGTH
+  static const int ERROR_EVENT_TOO_LARGE = -6;
+  // No room to queue the event (async mode only)
+  static const int ERROR_BUSY = -7;
+  // Not sent because the collector keeps failing (see setCircuitBreaker)
+  static const int ERROR_CIRCUIT_OPEN = -8;
+  // The event was accepted and will be sent by update() (async mode or aggregated)
+  static const int EVENT_QUEUED = 0;
 
-  // Constructor
+  // Called with the final status of each sent event
+  typedef void (*TrackCallback)(const int aStatus);
+
+  // Called to power the network up (aOn true) or down (see setDutyCycle)
+  typedef void (*PowerCallback)(const bool aOn);
+  // Longest ms an event waits for the network by default, when duty cycling
+  static const unsigned long kDutyCycleMaxAge = 60*1000UL;
+
+  // What to do with a new event when the queue is full
+  typedef enum {
+    eDropOldest,  // Make room by dropping the oldest queued events
+    eDropNewest,  // Drop the new event and return ERROR_BUSY
+    eBlock        // Send queued events until there's room (blocks: see setOverflowPolicy)
+  } OverflowPolicy;
+
+  // Which queue an event waits in (async mode only)
+  typedef enum {
+    eHighPriority,  // Sent before any normal event, e.g. alarms
+    eNormalPriority // Routine readings
+  } Priority;
+
+  // Constructors: for an Ethernet shield, or any other network Client
   SnowPlowTracker(EthernetClass *aEthernet, const byte* aMac, const char *aAppId);
+  SnowPlowTracker(Client *aClient, const byte* aMac, const char *aAppId);
 
   // Initialisation options for the HTTP connection
   void initCf(const char *aCfSubdomain);
-  void initUrl(const char *aHost);
+  void initUrl(const char *aHost, const int aPort = 80);
+
+  // Or send through another transport instead
+  void initTransport(SnowPlowTransport *aTransport);
+
+  // How long to wait for the collector to respond
+  void setResponseTimeout(const unsigned long aTimeout);
+  void setPollBackoff(const unsigned long aMaxDelay);
+
+  // How long to trust the collector's IP address for
+  void setDnsCacheTtl(const unsigned long aTtl);
 
   // Manually set the 'user' ID
   void setUserId(const char *aUserId);
 
+  // Asynchronous (non-blocking) sending
+  void setAsync(const bool aAsync);
+  void setQueue(byte *aBuffer, const size_t aSize, const Priority aPriority = eNormalPriority);
+  void setKeepAlive(const bool aKeepAlive);
+  void setTrackCallback(TrackCallback aCallback);
+  void update();
+  void setBatching(const size_t aMaxEvents, const unsigned long aMaxAge = 0);
+  void setCompression(const bool aCompress);
+  void setDutyCycle(PowerCallback aCallback, const size_t aMaxEvents = 0, const unsigned long aMaxAge = kDutyCycleMaxAge);
+  void flush();
+  bool isBusy() const;
+
+  // Coping with a failing collector
+  void setRetryPolicy(const byte aMaxRetries, const unsigned long aBaseDelay = 1000, const unsigned long aMaxDelay = 60000);
+  void setCircuitBreaker(const byte aThreshold, const unsigned long aCoolOff = 60000);
+  bool isCircuitOpen() const;
+
+  // Event queues (async mode only)
+  void setPriority(const Priority aPriority);
+  void setOverflowPolicy(const OverflowPolicy aPolicy, const Priority aPriority = eNormalPriority);
+  size_t getQueuedEvents() const;
+  unsigned long getDroppedEvents() const;
+
+  // Persistent storage for events we couldn't send
+  void setOutbox(SnowPlowOutbox *aOutbox);
+  size_t getStoredEvents() const;
+
+  // Summing up events with numeric values
+  void setAggregator(SnowPlowAggregator *aAggregator);
+
+  // Events tracked from interrupt handlers
+  void setInterruptQueue(SnowPlowInterruptQueue *aQueue);
+
+  // Wall-clock time, to timestamp events with (see SnowPlowClock)
+  void setClock(const unsigned long aUnixTime);
+  unsigned long getUnixTime() const;
+
+  // Bytes sent to the collector so far
+  unsigned long getBytesWritten() const;
+
+  // How the tracker is getting on
+  const SnowPlowMetrics &getMetrics() const;
+  void resetMetrics();
+  void setMetricsInterval(const unsigned long aInterval);
+
   // Track structured SnowPlow events
-  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel = NULL, const char *aProperty = NULL) const;
-  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const int aValue) const;
-  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const double aValue, const int aValuePrecision = 2) const;
-  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const float aValue, const int aValuePrecision = 2) const;
+  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel = NULL, const char *aProperty = NULL);
+  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const int aValue);
+  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const double aValue, const int aValuePrecision = 2);
+  int trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const float aValue, const int aValuePrecision = 2);
+
+  // Track structured events defined up front (see Event below)
+  template <typename TValue = void, byte TPrecision = 2> class Event;
+  int trackEvent(const Event<> &aEvent);
+  template <typename TValue, byte TPrecision>
+  int trackEvent(const Event<TValue, TPrecision> &aEvent, const typename Event<TValue, TPrecision>::Value aValue);
 
  private:
-  static const char *kUserAgent;
-  static const char *kTrackerPlatform;
-  static const char *kTrackerVersion;
+  static const size_t kMaxFieldNameLength = 6; // "ev_ca\0"
+  static const char kUserAgent[];
+  static const char kTrackerPlatform[];
+  static const char kTrackerVersion[];
+  static const char kHttpStatusPrefix[];
+  static const char kContentLengthHeader[];
+  static const char kDateHeader[];
+  static const char kFieldNames[][kMaxFieldNameLength];
+  static const char kPayloadDataSchema[];
+  static const char kUnstructEventSchema[];
+  static const char kMetricsSchema[];
+  static const char kSummarySchema[];
+  static const char kSummaryNames[][sizeof("category")];
   static const int kCollectorPort = 80; // Default port
-  static const int kMaxEventPairs = 7; // 6 fields plus trailing NULL indicator
   static const int kHttpResponseTimeout = 15*1000; // ms to wait before sending timeout
-  static const int kHttpWaitForDataDelay = 750; // ms to wait each time there's no data available
+  static const int kHttpWaitForDataDelay = 50; // Most ms to wait each time there's no data available
+  static const unsigned long kDnsCacheTtl = 10*60*1000UL; // ms to keep the collector's IP address for
+  static const unsigned long kMinPollDelay = 1; // ms to wait the first time there's no data available
+  static const size_t kReadBufferSize = 32; // Bytes of the response to read at a time
+  static const int kResponsePending = SnowPlowTransport::kResponsePending; // readResponse() hasn't reached a final status yet
+  static const size_t kMaxBatchSize = 64; // Most events to POST in one request
+  static const byte kMaxRetries = 3; // Times to retry a queued event
+  static const unsigned long kRetryBaseDelay = 1000; // ms to back off for after one failure
+  static const unsigned long kRetryMaxDelay = 60*1000; // Longest back-off in ms
+  static const byte kBreakerThreshold = 5; // Failures in a row to open the circuit breaker after
+  static const unsigned long kBreakerCoolOff = 60*1000; // ms the circuit breaker stays open
+  static const size_t kMacAddressLength = 18; // "00:01:0A:2E:05:0B\0"
+  static const size_t kQueueSize = 256; // Bytes setAsync() gives the queue, if setQueue() didn't
+  static const size_t kPriorityQueueSize = SNOWPLOW_MAX_EVENT_LENGTH + 1; // Likewise setPriority(): the longest event
+  static const size_t kMaxNumberLength = 25; // Longest stringified int or double
 
-  // Not possible to call _trackStructEvent directly (because aValue can't be any string)
-  int _trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const char *aValue) const;
+  // Event records are a run of fields, each a tag byte
+  // (type | key) followed by the value:
+  //   kFieldString:   [length][chars, not URL-encoded]
+  //   kFieldInt:      [int, in binary]
+  //   kFieldDouble:   [precision][double, in binary]
+  //   kFieldMillis:   [unsigned long, millis() when tracked]
+  //   kFieldUnixTime: [unsigned long, seconds since 1970, or 0 if unknown]
+  //   kFieldMetrics:  [SnowPlowMetrics::Snapshot, in binary]
+  //   kFieldSummary:  [SnowPlowAggregator::Statistics, in binary]
+  //                   then the category, action, label and
+  //                   property, each as [length][chars]
+  // The first field is kFieldCreated, as a kFieldMillis (or,
+  // once in the outbox, where millis() may not survive a
+  // reboot, a kFieldUnixTime)
+  static const byte kFieldString = 0x00;
+  static const byte kFieldInt = 0x10;
+  static const byte kFieldDouble = 0x20;
+  static const byte kFieldMillis = 0x30;
+  static const byte kFieldUnixTime = 0x40;
+  static const byte kFieldMetrics = 0x50;
+  static const byte kFieldSummary = 0x60;
+  static const byte kFieldTypeMask = 0xF0;
+  static const byte kFieldKeyMask = 0x0F;
+  // Field keys, indexing kFieldNames
+  static const byte kFieldEvent = 0;
+  static const byte kFieldCategory = 1;
+  static const byte kFieldAction = 2;
+  static const byte kFieldLabel = 3;
+  static const byte kFieldProperty = 4;
+  static const byte kFieldValue = 5;
+  static const byte kFieldCreated = 6;
+  static const byte kFieldUnstructEvent = 7;
+  static const byte kFieldCount = 8;
+  static const size_t kCreatedLength = 1 + sizeof(unsigned long); // Tag and time
+  // A metrics event: e=ue, and its counts as the ue_pr
+  static const size_t kMetricsLength = kCreatedLength + 2 + sizeof("ue") - 1 + 1 + sizeof(SnowPlowMetrics::Snapshot);
+  static_assert(kMetricsLength <= SNOWPLOW_MAX_EVENT_LENGTH, "Metrics events are too large for SNOWPLOW_MAX_EVENT_LENGTH");
+  // A summary event: e=ue, and its statistics as the ue_pr, before its strings
+  static const byte kSummaryStrings = 4;
+  static const size_t kMinSummaryLength = kCreatedLength + 2 + sizeof("ue") - 1 + 1 + sizeof(SnowPlowAggregator::Statistics) + kSummaryStrings;
+  static_assert(kMinSummaryLength <= SNOWPLOW_MAX_EVENT_LENGTH, "Summary events are too large for SNOWPLOW_MAX_EVENT_LENGTH");
 
-  // Struct to hold a querychar *name-value pair
-  typedef struct
+  // Not possible to call _trackStructEvent directly (because aValue must be an encoded field)
+  int _trackStructEvent(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const byte *aValue, const size_t aValueLength);
+
+  // The strings of an Event, and the size of its record
+  struct EventStrings
   {
-    char* name;
-    char* value;
-  } QuerystringPair;
+    constexpr EventStrings(const char *aCategory, const byte aCategoryLength, const char *aAction, const byte aActionLength,
+                           const char *aLabel, const byte aLabelLength, const char *aProperty, const byte aPropertyLength,
+                           const size_t aLength)
+      : category(aCategory), action(aAction), label(aLabel), property(aProperty),
+        categoryLength(aCategoryLength), actionLength(aActionLength), labelLength(aLabelLength), propertyLength(aPropertyLength),
+        length(aLength) {}
+    const char *category;
+    const char *action;
+    const char *label; // Or NULL
+    const char *property; // Or NULL
+    byte categoryLength;
+    byte actionLength;
+    byte labelLength;
+    byte propertyLength;
+    size_t length;
+  };
+
+  // Sizes (and encodes) the fields of an Event's record at compile time.
+  // N is the size of a string literal, with its '\0', or 0 for none
+  template <size_t N> struct StringField;
+  template <typename TValue> struct ValueField;
+  template <size_t NCategory, size_t NAction, size_t NLabel, size_t NProperty, typename TValue> struct EventRecord;
+
+  // Not possible to call _trackEvent directly (because aValue must be an encoded field)
+  int _trackEvent(const EventStrings &aEvent, const byte *aValue, const size_t aValueLength);
 
   // To track different HTTP statuses
   typedef enum {
@@ -125,33 +375,407 @@ class SnowPlowTracker
     eRequestSent,
     eReadingStatusCode,
     eStatusCodeRead,
-    eReadingContentLength,
+    eReadingHeader,
+    eReadingDate,
     eSkipToEndOfHeader,
     eLineStartingCRFound,
     eReadingBody
   } HttpState;
 
-  class EthernetClass* ethernet;
-  class EthernetClient* client;
+  // How events are written out: as a GET's querystring,
+  // or as objects in a batch POST's payload_data JSON
+  typedef enum {
+    eQuerystring,
+    eJson
+  } Encoding;
+
+  // Measures a request body without sending it
+  class ByteCounter : public Print
+  {
+   public:
+    ByteCounter() : count(0) {}
+    virtual size_t write(uint8_t aChar);
+    using Print::write;
+    size_t count;
+  };
+
+  // Encodes everything written through it on to another Print
+  class EncodingWriter : public Print
+  {
+   public:
+    EncodingWriter(Print &aOut, const Encoding aEncoding) : out(&aOut), encoding(aEncoding) {}
+    virtual size_t write(uint8_t aChar);
+    using Print::write;
+    Print *out;
+    Encoding encoding;
+  };
+
+  // Our built-in transport: HTTP to the collector
+  class HttpTransport : public SnowPlowTransport
+  {
+   public:
+    HttpTransport(SnowPlowTracker *aTracker) : tracker(aTracker) {}
+    virtual int startRequest(Records &aRecords, const size_t aCount);
+    virtual int readResponse();
+    virtual int getStatusCode() const;
+    virtual void endRequest(const int aStatus);
+    SnowPlowTracker *tracker;
+  };
+
+  // Hands a transport the records of the events being sent
+  class RecordReader : public SnowPlowTransport::Records
+  {
+   public:
+    RecordReader(SnowPlowTracker *aTracker) : tracker(aTracker) {}
+    virtual size_t get(const size_t aIndex, byte *aBuffer, const size_t aSize);
+    SnowPlowTracker *tracker;
+  };
+
+  // Gathers up a request so the client gets it in
+  // a few large writes rather than many tiny ones
+  class RequestWriter : public Print
+  {
+   public:
+    RequestWriter(byte *aBuffer, const size_t aSize, unsigned long *aWritten) : client(NULL), buffer(aBuffer), size(aSize), length(0), written(aWritten) {}
+    virtual size_t write(uint8_t aChar);
+    virtual size_t write(const uint8_t *aBuffer, size_t aSize);
+    using Print::write;
+    void flush();
+    Client *client;
+    byte *buffer;
+    size_t size;
+    size_t length;
+    unsigned long *written; // Counts the bytes sent on
+  };
+
+  // Writes into a fixed-size char buffer
+  class BufferWriter : public Print
+  {
+   public:
+    BufferWriter(char *aBuffer, const size_t aSize) : buffer(aBuffer), size(aSize), length(0), overflowed(false) {}
+    virtual size_t write(uint8_t aChar);
+    using Print::write;
+    int terminate();
+    char *buffer;
+    size_t size;
+    size_t length;
+    bool overflowed;
+  };
+
+  class EthernetClass* ethernet; // Or NULL for another kind of network
+  Client* client;
+
+  // What requests are sent through: http, unless initTransport() was called
+  SnowPlowTransport *transport;
+  HttpTransport http;
+  RecordReader records;
 
   byte* mac;
   char *appId;
   char *collectorHost;
-  char *macAddress;
+  int collectorPort;
+  IPAddress collectorIp; // Cached by resolve()
+  bool collectorResolved;
+  unsigned long resolvedAt;
+  unsigned long dnsCacheTtl;
+  unsigned long responseTimeout;
+  unsigned long pollBackoff;
+  char macAddress[kMacAddressLength];
   char *userId;
 
-  void init(const char *aHost);
-  int track(const QuerystringPair aEventPairs[]) const;
-  int getUri(const char *aHost, const int aPort, const char *aPath, const QuerystringPair aPairs[]) const;
-  int getResponseCode() const;
+  // The fixed parts of every request, encoded
+  // up front by encodeRequestParts()
+  char *encodedContext;
+  char *encodedJsonContext; // Only while batching
+  char *encodedHeaders;
+
+  bool async;
+  bool keepAlive;
+  TrackCallback callback;
+
+  // Record of the event being sent
+  byte eventRecord[SNOWPLOW_MAX_EVENT_LENGTH];
+  size_t eventLength;
+
+  // Encoded events waiting to be sent: high priority
+  // ones in priorityQueue, the rest in queue. Each
+  // has no buffer until it's needed (see setQueue)
+  SnowPlowEventQueue queue;
+  byte *queueAllocation; // Its buffer if we malloc()ed it, or NULL
+  OverflowPolicy overflowPolicy;
+  SnowPlowEventQueue priorityQueue;
+  byte *priorityQueueAllocation;
+  OverflowPolicy priorityOverflowPolicy;
+  Priority priority; // Of the events being tracked
+
+  // Counts and latencies, sent every metricsInterval ms (if not 0)
+  SnowPlowMetrics metrics;
+  unsigned long metricsInterval;
+  unsigned long metricsSentAt;
+
+  // The request being written
+  byte writeBuffer[SNOWPLOW_WRITE_BUFFER_SIZE];
+  RequestWriter out;
 
-  static char *getTransactionId();
-  static char *mac2Chars(const byte* aMac);
-  static char *int2Chars(const int aInt);
-  static char *double2Chars(const double aDbl, const int aPrecision);
+  // Batching (async mode only)
+  size_t batchSize;
+  unsigned long batchMaxAge;
+  unsigned long batchStarted;
+  size_t batchCount; // Events in the batch being sent, or 0 for a single GET
+  size_t batchPriorityCount; // How many of those (or the GET) come from priorityQueue
+  SnowPlowCompressor *compressor; // Gzips batch bodies, or NULL
+
+  // Duty cycling: the network is only powered up to send
+  PowerCallback powerCallback; // Or NULL to leave it up
+  size_t flushEvents;
+  unsigned long flushAge;
+  bool powered;
+  unsigned long poweredOnAt;
+  unsigned long poweredOffAt;
+
+  // Events with numeric values being summed up
+  SnowPlowAggregator *aggregator;
+
+  // Events waiting to be picked up from interrupt handlers
+  SnowPlowInterruptQueue *interruptQueue;
+  bool backdated; // Whether the event being tracked happened at backdatedTo
+  unsigned long backdatedTo; // Rather than now
+
+  // Turns the millis() events were tracked at into wall-clock time
+  SnowPlowClock clock;
+
+  // Events kept for when the collector is reachable again
+  SnowPlowOutbox *outbox;
+
+  // Where the event(s) in flight came from
+  typedef enum {
+    eFromCaller, // trackStructEvent(), in blocking mode
+    eFromQueue,
+    eFromOutbox
+  } RequestSource;
+  RequestSource requestSource;
+
+  // Retries and the circuit breaker
+  byte maxRetries;
+  unsigned long retryBaseDelay;
+  unsigned long retryMaxDelay;
+  byte breakerThreshold;
+  unsigned long breakerCoolOff;
+  byte attempts; // Failed attempts at the front of the queue so far
+  byte consecutiveFailures;
+  unsigned long backoffStart;
+  unsigned long backoffDelay; // Or 0 if we're not backing off
+
+  // Progress through the current request
+  HttpState httpState;
+  int statusCode;
+  const char *statusPtr;
+  const char *headerPtr;
+  long contentLength; // Or -1 if not given
+  bool responseComplete; // Whether we've read the whole response
+  unsigned long timeoutStart;
+  unsigned long requestSentAt; // millis() when the request was written
+  unsigned long requestStamp; // millis() the events in it are stamped as sent at
+
+  void init(const char *aHost, const int aPort);
+  int track(const byte *aRecord, const size_t aLength);
+  int enqueue(const byte *aRecord, const size_t aLength);
+  void allocateQueue(const Priority aPriority, const size_t aSize);
+  bool isSending(const SnowPlowEventQueue &aLane) const;
+  size_t peekQueued(byte *aBuffer, const size_t aSize, const size_t aIndex) const;
+  void drainInterruptQueue();
+  int aggregate(const char *aCategory, const char *aAction, const char *aLabel, const char *aProperty, const double aValue, const int aPrecision);
+  bool sendSummary(const bool aForce);
+  void sendMetrics();
+  bool dequeue(const bool aForce);
+  bool isFlushDue() const;
+  void powerUp();
+  void powerDown();
+  bool replay();
+  bool isBackingOff() const;
+  unsigned long getBackoffDelay() const;
+  void store(byte *aRecord, const size_t aLength);
+  bool sendNext();
+  int send();
+  int startRequest();
+  int startHttpRequest();
+  void finish(const int aStatus);
+  void writeEvent(Print &aOut, const int aTxnId, const byte *aRecord, const size_t aLength, const Encoding aEncoding) const;
+  size_t writeCreated(Print &aOut, const byte *aRecord, const size_t aLength, const Encoding aEncoding) const;
+  void writeBatch(Print &aOut, const int aFirstTxnId, const size_t aCount);
+  void writeBody(Print &aOut, const int aFirstTxnId, const size_t aCount);
+  void writeContext(Print &aOut, const Encoding aEncoding) const;
+  void encodeRequestParts();
+  void writeHeaders();
+  void writeHeaderBlock(Print &aOut) const;
+  bool resolve(const bool aForce);
+  bool connect(const int aPort);
+  void awaitResponse();
+  int getUri(const int aPort, const __FlashStringHelper *aPath, const int aTxnId, const byte *aRecord, const size_t aLength);
+  int postUri(const int aPort, const __FlashStringHelper *aPath, const int aFirstTxnId, const size_t aCount);
+  int readResponse();
+  void startHeaderLine();
+  int endHeaders();
+  int getFinalStatus() const;
+  int getResponseCode();
+
+  static int getTransactionId();
+  static char *mac2Chars(char *aBuffer, const byte* aMac);
+  static char *int2Chars(char *aBuffer, const int aInt);
+  static char *double2Chars(char *aBuffer, const double aDbl, const int aPrecision);
   static char char2Hex(const char aChar);
-  static int countPairs(const QuerystringPair aPairs[]);
-  static char *urlEncode(const char* aStr);
+  static void addField(BufferWriter &aRecord, const byte aKey, const char *aValue);
+  static void addField(BufferWriter &aRecord, const byte aKey, const __FlashStringHelper *aValue);
+  static void addField(BufferWriter &aRecord, const byte aKey, const int aValue);
+  static void addField(BufferWriter &aRecord, const byte aKey, const double aValue, const int aPrecision);
+  static void addString(BufferWriter &aRecord, const char *aValue);
+  static byte *putField(byte *aRecord, const byte aKey, const char *aValue, const byte aLength);
+  byte *putCreated(byte *aRecord) const;
+  static unsigned long getCreated(const byte *aRecord, const size_t aLength);
+  static void printFields(Print &aOut, const byte *aRecord, const size_t aLength, const Encoding aEncoding);
+  static size_t printField(Print &aOut, const byte *aField, const size_t aLength, const Encoding aEncoding);
+  static void printMetrics(Print &aOut, const SnowPlowMetrics::Snapshot &aSnapshot, const Encoding aEncoding);
+  static void printSummary(Print &aOut, const SnowPlowAggregator::Statistics &aStatistics, const byte *aStrings, const Encoding aEncoding);
+  static void printJsonNumber(Print &aOut, const __FlashStringHelper *aName, const double aValue, const byte aPrecision);
+  static void printName(Print &aOut, const __FlashStringHelper *aName, const Encoding aEncoding);
+  static void printValueEnd(Print &aOut, const Encoding aEncoding);
+  static void encode(Print &aOut, const char* aStr, const Encoding aEncoding);
+  static void encode(Print &aOut, const __FlashStringHelper* aStr, const Encoding aEncoding);
+  static void urlEncode(Print &aOut, const char* aStr);
+  static void urlEncode(Print &aOut, const char* aStr, const size_t aLength);
+  static void urlEncode(Print &aOut, const __FlashStringHelper* aStr);
+  static void encodeChar(Print &aOut, const char aChar);
+  static void jsonEscape(Print &aOut, const char* aStr, const size_t aLength);
+  static void escapeChar(Print &aOut, const char aChar);
 };
 
+/**
+ * An Event is a structured event whose
+ * category, action, label and property
+ * are string literals, fixed when the
+ * sketch is compiled, and whose value
+ * (if it has one) is a TValue: int,
+ * double or float, with TPrecision
+ * digits after the decimal point.
+ *
+ * The size of its record is worked out
+ * by the compiler, so an Event that
+ * can't fit in SNOWPLOW_MAX_EVENT_LENGTH
+ * (or has a string over 255 chars) is a
+ * compile error, and trackEvent() can
+ * encode it without any checks. E.g.
+ *
+ *   const SnowPlowTracker::Event<int> kPing("example", "ping", "age");
+ *   snowplow.trackEvent(kPing, 22);
+ */
+template <typename TValue, byte TPrecision>
+class SnowPlowTracker::Event : public SnowPlowTracker::EventStrings
+{
+ public:
+  typedef typename ValueField<TValue>::Value Value;
+
+  template <size_t NCategory, size_t NAction>
+  constexpr Event(const char (&aCategory)[NCategory], const char (&aAction)[NAction])
+    : EventStrings(aCategory, NCategory - 1, aAction, NAction - 1, NULL, 0, NULL, 0,
+                   EventRecord<NCategory, NAction, 0, 0, TValue>::kLength) {
+    static_assert(TPrecision <= SnowPlowNumber::kMaxPrecision, "Event precision is too high");
+  }
+
+  template <size_t NCategory, size_t NAction, size_t NLabel>
+  constexpr Event(const char (&aCategory)[NCategory], const char (&aAction)[NAction], const char (&aLabel)[NLabel])
+    : EventStrings(aCategory, NCategory - 1, aAction, NAction - 1, aLabel, NLabel - 1, NULL, 0,
+                   EventRecord<NCategory, NAction, NLabel, 0, TValue>::kLength) {
+    static_assert(TPrecision <= SnowPlowNumber::kMaxPrecision, "Event precision is too high");
+  }
+
+  template <size_t NCategory, size_t NAction, size_t NLabel, size_t NProperty>
+  constexpr Event(const char (&aCategory)[NCategory], const char (&aAction)[NAction], const char (&aLabel)[NLabel], const char (&aProperty)[NProperty])
+    : EventStrings(aCategory, NCategory - 1, aAction, NAction - 1, aLabel, NLabel - 1, aProperty, NProperty - 1,
+                   EventRecord<NCategory, NAction, NLabel, NProperty, TValue>::kLength) {
+    static_assert(TPrecision <= SnowPlowNumber::kMaxPrecision, "Event precision is too high");
+  }
+};
+
+// A string field: tag, length, chars
+template <size_t N>
+struct SnowPlowTracker::StringField
+{
+  static_assert(N <= 256, "Event strings can be at most 255 chars");
+  static const size_t kLength = (N == 0) ? 0 : 2 + (N - 1);
+};
+
+// No value field
+template <>
+struct SnowPlowTracker::ValueField<void>
+{
+  typedef void Value;
+  static const size_t kLength = 0;
+};
+
+// An int value field: tag, int
+template <>
+struct SnowPlowTracker::ValueField<int>
+{
+  typedef int Value;
+  static const size_t kLength = 1 + sizeof(int);
+  static void write(byte *aField, const int aValue, const byte aPrecision) {
+    aField[0] = kFieldValue | kFieldInt;
+    memcpy(aField + 1, &aValue, sizeof(aValue));
+  }
+};
+
+// A double value field: tag, precision, double
+template <>
+struct SnowPlowTracker::ValueField<double>
+{
+  typedef double Value;
+  static const size_t kLength = 2 + sizeof(double);
+  static void write(byte *aField, const double aValue, const byte aPrecision) {
+    aField[0] = kFieldValue | kFieldDouble;
+    aField[1] = aPrecision;
+    memcpy(aField + 2, &aValue, sizeof(aValue));
+  }
+};
+
+// Floats are sent as doubles
+template <>
+struct SnowPlowTracker::ValueField<float> : SnowPlowTracker::ValueField<double>
+{
+  typedef float Value;
+};
+
+// A whole event record: when it was created, then e=se
+template <size_t NCategory, size_t NAction, size_t NLabel, size_t NProperty, typename TValue>
+struct SnowPlowTracker::EventRecord
+{
+  static const size_t kLength = kCreatedLength + StringField<sizeof("se")>::kLength
+                              + StringField<NCategory>::kLength + StringField<NAction>::kLength
+                              + StringField<NLabel>::kLength + StringField<NProperty>::kLength
+                              + ValueField<TValue>::kLength;
+  static_assert(kLength <= SNOWPLOW_MAX_EVENT_LENGTH, "Event is too large for SNOWPLOW_MAX_EVENT_LENGTH");
+};
+
+/**
+ * Tracks an Event with a value. The
+ * value field is encoded here, into
+ * a buffer of exactly its size, and
+ * the rest by _trackEvent().
+ *
+ * @param aEvent The Event to track
+ * @param aValue Its value
+ * @return An integer indicating the success/failure
+ *         of logging the event to SnowPlow
+ */
+template <typename TValue, byte TPrecision>
+int SnowPlowTracker::trackEvent(const Event<TValue, TPrecision> &aEvent, const typename Event<TValue, TPrecision>::Value aValue) {
+
+  if ((this->aggregator != NULL) && (this->priority == eNormalPriority)) {
+    return this->aggregate(aEvent.category, aEvent.action, aEvent.label, aEvent.property, aValue, TPrecision);
+  }
+
+  byte value[ValueField<TValue>::kLength];
+  ValueField<TValue>::write(value, aValue, TPrecision);
+  return this->_trackEvent(aEvent, value, sizeof(value));
+}
+
 #endif
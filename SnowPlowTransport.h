@@ -0,0 +1,82 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef SnowPlowTransport_h
+#define SnowPlowTransport_h
+
+#include <stddef.h>
+#include <Arduino.h>
+
+/**
+ * SnowPlowTransport is the interface
+ * SnowPlowTracker sends its requests
+ * through. By default it uses its own
+ * HTTP transport (over an Ethernet
+ * shield, or any other Arduino Client);
+ * initTransport() swaps in another,
+ * such as SnowPlowSerialTransport.
+ *
+ * A request carries one event, or a
+ * batch of them, and is sent without
+ * blocking: startRequest() writes it
+ * out, readResponse() is then polled
+ * until it has the outcome, and
+ * endRequest() is always called last.
+ *
+ * Events are handed over as the
+ * tracker's binary event records (see
+ * SnowPlowTracker.h for their layout),
+ * and the fixed parts of every event
+ * as a querystring fragment (see
+ * setContext()).
+ */
+class SnowPlowTransport
+{
+ public:
+  // readResponse() hasn't got the outcome yet
+  static const int kResponsePending = 1;
+
+  // Fetches the records of the events in a request
+  class Records
+  {
+   public:
+    virtual ~Records() {}
+    // Copies record aIndex into aBuffer, returning its length (or 0)
+    virtual size_t get(const size_t aIndex, byte *aBuffer, const size_t aSize) = 0;
+  };
+
+  virtual ~SnowPlowTransport() {}
+
+  // The URL-encoded pairs sent with every event, like
+  // "&p=iot&mac=...&aid=...&tv=...". Stays put until the next call
+  virtual void setContext(const char *aContext) {}
+
+  // 0 if the request was sent, else an ERROR_* value
+  virtual int startRequest(Records &aRecords, const size_t aCount) = 0;
+  // An HTTP status code, an ERROR_* value or kResponsePending
+  virtual int readResponse() = 0;
+  // The status code behind an ERROR_HTTP_STATUS
+  virtual int getStatusCode() const = 0;
+  // Done with the request, which ended with aStatus
+  virtual void endRequest(const int aStatus) = 0;
+};
+
+#endif
@@ -0,0 +1,318 @@
+/* 
+ * SnowPlow Arduino Tracker: Benchmark Example
+ *
+ * @description Benchmark example for SnowPlow Arduino Tracker
+ * @version     0.0.1
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SPI.h>
+#include <Ethernet.h>
+#include <SnowPlowTracker.h>
+
+// MAC address of this Arduino. Update with your shield's MAC address.
+const byte mac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// SnowPlow collector to benchmark against. Update with your collector.
+const char *snowplowHost = "collector.example.com";
+
+// SnowPlow app name
+const char *snowplowAppName = "arduino-benchmark";
+
+// How many events to time for each trackStructEvent() overload
+const int eventsPerRun = 10;
+
+// How many numbers to format when timing SnowPlowNumber
+const int numbersPerRun = 1000;
+
+// How many batch bodies to compress when timing SnowPlowCompressor
+const int batchesPerRun = 10;
+
+// SnowPlow Tracker
+SnowPlowTracker snowplow(&Ethernet, mac, snowplowAppName);
+
+/*
+ * Returns the bytes of heap in use:
+ * everything malloc() has taken
+ * below __brkval, less the blocks
+ * on the free list. Unlike the gap
+ * to the stack this doesn't depend
+ * on how deep the caller is, and a
+ * freed block doesn't count. It
+ * can't see memory malloc()ed and
+ * freed again within a run; the
+ * host benchmark in extras/host
+ * counts every allocation.
+ */
+int heapInUse()
+{
+#ifdef __AVR__
+  extern char __heap_start, *__brkval;
+  struct __freelist {
+    size_t sz;
+    struct __freelist *nx;
+  };
+  extern struct __freelist *__flp;
+
+  const char *top = (__brkval == 0) ? &__heap_start : __brkval;
+  int inUse = top - &__heap_start;
+  for (struct __freelist *block = __flp; block != 0; block = block->nx) {
+    inUse -= block->sz + sizeof(size_t);
+  }
+  return inUse;
+#else
+  return 0;
+#endif
+}
+
+/*
+ * Tracks one event with the given
+ * overload of trackStructEvent().
+ */
+void trackOne(const int aOverload, const int aIndex)
+{
+  switch (aOverload) {
+  case 0:
+    snowplow.trackStructEvent("benchmark", "no value", "label", "property");
+    break;
+  case 1:
+    snowplow.trackStructEvent("benchmark", "int value", "label", "property", aIndex);
+    break;
+  case 2:
+    snowplow.trackStructEvent("benchmark", "double value", "label", "property", 3.14159 * aIndex, 5);
+    break;
+  case 3:
+    snowplow.trackStructEvent("benchmark", "float value", "label", "property", 2.71828f * aIndex, 2);
+    break;
+  }
+}
+
+/*
+ * Times a run of events with one
+ * overload, splitting each event
+ * into encoding it (as far as the
+ * queue) and sending it. Prints
+ * events/sec for each stage, bytes
+ * on the wire per event and any
+ * change in the heap in use.
+ */
+void benchmark(const char *aName, const int aOverload)
+{
+  const int memoryBefore = heapInUse();
+  const unsigned long bytesBefore = snowplow.getBytesWritten();
+  unsigned long encodeMicros = 0;
+  unsigned long sendMicros = 0;
+
+  snowplow.setAsync(true);
+  for (int i = 0; i < eventsPerRun; i++) {
+    // 1. Encoding: async mode, so the event only goes as far as the queue
+    unsigned long start = micros();
+    trackOne(aOverload, i);
+    encodeMicros += micros() - start;
+
+    // 2. Sending: drain the queue to the collector
+    start = micros();
+    snowplow.flush();
+    sendMicros += micros() - start;
+  }
+  snowplow.setAsync(false);
+
+  const unsigned long bytes = snowplow.getBytesWritten() - bytesBefore;
+
+  Serial.print(aName);
+  Serial.print(": encode ");
+  Serial.print(1000000.0 * eventsPerRun / encodeMicros);
+  Serial.print(" events/sec, send ");
+  Serial.print(1000000.0 * eventsPerRun / sendMicros);
+  Serial.print(" events/sec, ");
+  Serial.print(bytes / eventsPerRun);
+  Serial.print(" bytes/event, heap in use change ");
+  Serial.println(heapInUse() - memoryBefore);
+}
+
+/*
+ * Prints how long formatting one
+ * number took on average, given the
+ * total time for the run.
+ */
+void printRate(const char *aName, const unsigned long aMicros)
+{
+  Serial.print(aName);
+  Serial.print(": ");
+  Serial.print((float)aMicros / numbersPerRun);
+  Serial.println(" us/number");
+}
+
+/*
+ * Times SnowPlowNumber, which the
+ * tracker uses to write the numbers
+ * in each event, against the libc
+ * functions it replaces.
+ */
+void benchmarkFormatting()
+{
+  char buffer[SnowPlowNumber::kMaxLength];
+  volatile size_t sink = 0; // Stops the loops being optimized away
+  unsigned long start;
+
+  start = micros();
+  for (int i = 0; i < numbersPerRun; i++) {
+    sink += SnowPlowNumber::formatInt(buffer, -31 * i);
+  }
+  printRate("SnowPlowNumber::formatInt", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < numbersPerRun; i++) {
+    sink += snprintf(buffer, sizeof(buffer), "%d", -31 * i);
+  }
+  printRate("snprintf", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < numbersPerRun; i++) {
+    sink += SnowPlowNumber::formatDouble(buffer, 3.14159 * i, 2);
+  }
+  printRate("SnowPlowNumber::formatDouble", micros() - start);
+
+  start = micros();
+  for (int i = 0; i < numbersPerRun; i++) {
+    sink += strlen(dtostrf(3.14159 * i, 1, 2, buffer));
+  }
+  printRate("dtostrf", micros() - start);
+}
+
+/*
+ * A Print that just counts what's
+ * written to it, standing in for the
+ * network when timing compression.
+ */
+class CountingPrint : public Print
+{
+ public:
+  unsigned long count;
+
+  CountingPrint() : count(0) {}
+
+  virtual size_t write(uint8_t aByte) {
+    count++;
+    return 1;
+  }
+};
+
+/*
+ * Writes a body like the tracker's for
+ * a batch of 10 events: payload_data
+ * JSON, with the same keys and context
+ * repeated for each event.
+ */
+void writeSampleBatch(Print &aOut)
+{
+  aOut.print("{\"schema\":\"iglu:com.snowplowanalytics.snowplow/payload_data/jsonschema/1-0-4\",\"data\":[");
+  for (int i = 0; i < 10; i++) {
+    if (i > 0) {
+      aOut.print(',');
+    }
+    aOut.print("{\"tid\":\"");
+    aOut.print(4242 + i);
+    aOut.print("\",\"p\":\"iot\",\"mac\":\"90:A2:DA:00:F8:A0\",\"aid\":\"arduino-benchmark\",\"tv\":\"arduino-0.1.0\""
+               ",\"e\":\"se\",\"ev_ca\":\"benchmark\",\"ev_ac\":\"temperature\",\"ev_la\":\"sensor\",\"ev_pr\":\"celsius\",\"ev_va\":\"");
+    aOut.print(21.5 + i * 0.25, 2);
+    aOut.print("\"}");
+  }
+  aOut.print("]}");
+}
+
+/*
+ * Times gzipping batch bodies with
+ * SnowPlowCompressor, as setCompression()
+ * does, and prints the compression
+ * ratio and time per batch.
+ */
+void benchmarkCompression()
+{
+  SnowPlowCompressor *compressor = new SnowPlowCompressor();
+  if (compressor == NULL) {
+    Serial.println("SnowPlowCompressor: not enough RAM");
+    return;
+  }
+  CountingPrint plain;
+  CountingPrint compressed;
+
+  writeSampleBatch(plain);
+  const unsigned long start = micros();
+  for (int i = 0; i < batchesPerRun; i++) {
+    compressed.count = 0;
+    compressor->begin(compressed);
+    writeSampleBatch(*compressor);
+    compressor->end();
+  }
+  const unsigned long elapsed = micros() - start;
+  delete compressor;
+
+  Serial.print("SnowPlowCompressor: ");
+  Serial.print(plain.count);
+  Serial.print(" bytes to ");
+  Serial.print(compressed.count);
+  Serial.print(" (ratio ");
+  Serial.print((float)plain.count / compressed.count);
+  Serial.print("), ");
+  Serial.print((float)elapsed / batchesPerRun);
+  Serial.println(" us/batch");
+}
+
+/*
+ * setup() runs once when you turn your
+ * Arduino on: use it to initialize and
+ * set any initial values.
+ *
+ * We initialize the serial connection
+ * and the SnowPlow tracker, then run
+ * the benchmark once for each
+ * trackStructEvent() overload, and
+ * time our number formatting and
+ * batch compression.
+ */
+void setup()
+{
+  // Serial connection lets us see the results on the computer
+  Serial.begin(115200);
+
+  // Setup SnowPlow Arduino tracker
+  snowplow.initUrl(snowplowHost);
+  snowplow.setUserId("my-arduino");
+
+  benchmark("No value", 0);
+  benchmark("Int value", 1);
+  benchmark("Double value", 2);
+  benchmark("Float value", 3);
+
+  Serial.print("Events dropped: ");
+  Serial.println(snowplow.getDroppedEvents());
+  Serial.print("Metrics: ");
+  snowplow.getMetrics().print(Serial);
+  Serial.println();
+
+  benchmarkFormatting();
+  benchmarkCompression();
+}
+
+/*
+ * loop() runs over and over again.
+ * Nothing left to do here: the
+ * benchmark runs once in setup().
+ */
+void loop()
+{
+}
@@ -0,0 +1,146 @@
+/* 
+ * SnowPlow Arduino Tracker: Duty Cycle Ping Example
+ *
+ * @description Duty-cycled ping example for SnowPlow Arduino Tracker
+ * @version     0.0.1
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SPI.h>
+#include <Ethernet.h>
+#include <SnowPlowTracker.h>
+
+// MAC address of this Arduino. Update with your shield's MAC address.
+const byte mac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// SnowPlow CloudFront collector subdomain. Update with your collector.
+const char *snowplowCfSubdomain = "d3rkrsqld9gmqf";
+
+// SnowPlow app name
+const char *snowplowAppName = "arduino-ping-examples";
+
+// Pin switching the Ethernet shield's power (through a MOSFET, say)
+const int shieldPowerPin = 7;
+
+// Pin with an alarm button to ground
+const int alarmPin = 2;
+
+// Queue for alarms, which go at high priority: set aside
+// now, so there's never a shortage of RAM when one goes
+byte alarmQueue[64];
+
+// SnowPlow Tracker
+SnowPlowTracker snowplow(&Ethernet, mac, snowplowAppName);
+
+/*
+ * Called by the tracker to power the
+ * shield up before a burst of sends,
+ * and down again after. It has to be
+ * ready to use when we return, so we
+ * wait for it to boot and get its
+ * address again.
+ */
+void power(const bool aOn)
+{
+  if (aOn)
+  {
+    digitalWrite(shieldPowerPin, HIGH);
+    delay(1000);
+    Ethernet.begin((byte*)mac);
+  }
+  else
+  {
+    digitalWrite(shieldPowerPin, LOW);
+  }
+}
+
+/*
+ * setup() runs once when you turn your
+ * Arduino on: use it to initialize and
+ * set any initial values.
+ *
+ * We power the shield up for the
+ * tracker to initialize, then switch
+ * it to duty cycling: pings are sent
+ * ten at a time in one batch, or once
+ * the oldest has waited a minute.
+ * Alarms get a queue of their own.
+ */
+void setup()
+{
+  // Serial connection lets us debug on the computer
+  Serial.begin(9600);
+
+  pinMode(shieldPowerPin, OUTPUT);
+  digitalWrite(shieldPowerPin, HIGH);
+  pinMode(alarmPin, INPUT_PULLUP);
+
+  // Setup SnowPlow Arduino tracker
+  snowplow.initCf(snowplowCfSubdomain);
+  snowplow.setUserId("my-arduino");
+  snowplow.setQueue(alarmQueue, sizeof(alarmQueue), SnowPlowTracker::eHighPriority);
+  snowplow.setAsync(true);
+  snowplow.setBatching(10);
+  snowplow.setDutyCycle(power, 10, 60000);
+}
+
+/*
+ * loop() runs over and over again.
+ * An empty loop() takes just a few
+ * clock cycles to complete.
+ *
+ * Every 15 seconds, queue a 'ping'
+ * event for SnowPlow. An alarm goes
+ * at high priority, so the shield is
+ * powered up for it straightaway.
+ * Once a minute, print how long the
+ * shield has been up per event sent.
+ */
+void loop()
+{
+  // When did we run last? 
+  static unsigned long prevTime = 0;
+  static unsigned long prevReport = 0;
+  static bool alarmed = false;
+
+  if (millis() - prevTime >= (15000))
+  {
+    snowplow.trackStructEvent("example", "duty cycle ping");
+
+    prevTime = millis();
+  }
+
+  // Button pressed: raise the alarm once
+  const bool pressed = (digitalRead(alarmPin) == LOW);
+  if (pressed && !alarmed)
+  {
+    snowplow.setPriority(SnowPlowTracker::eHighPriority);
+    snowplow.trackStructEvent("example", "alarm");
+    snowplow.setPriority(SnowPlowTracker::eNormalPriority);
+  }
+  alarmed = pressed;
+
+  if (millis() - prevReport >= (60000))
+  {
+    Serial.print("Shield on per event (ms): ");
+    Serial.println(snowplow.getMetrics().getOnTimePerEvent());
+
+    prevReport = millis();
+  }
+
+  // Sends when a burst is due, powering the shield up and down
+  snowplow.update();
+}
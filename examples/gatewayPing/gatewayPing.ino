@@ -0,0 +1,102 @@
+/* 
+ * SnowPlow Arduino Tracker: Gateway Ping Example
+ *
+ * @description Gateway ping example for SnowPlow Arduino Tracker
+ * @version     0.0.1
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SPI.h>
+#include <Ethernet.h>
+#include <SnowPlowTracker.h>
+#include <SnowPlowSerialTransport.h>
+
+// MAC address of this Arduino. Sent with each event to identify it.
+const byte mac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// SnowPlow app name
+const char *snowplowAppName = "arduino-ping-examples";
+
+// Speed of the serial link to the gateway
+const unsigned long gatewayBaud = 1000000;
+
+// SnowPlow Tracker: no network of its own
+SnowPlowTracker snowplow((EthernetClass *)NULL, mac, snowplowAppName);
+
+// Sends events to a gateway on Serial1 (e.g. on a Mega or Leonardo),
+// which forwards them to the collector
+SnowPlowSerialTransport gateway(Serial1);
+
+/*
+ * Called by the tracker once each
+ * ping has been acked by the gateway
+ * (or has failed).
+ */
+void pingSent(const int aStatus)
+{
+  Serial.print("Ping sent with status: ");
+  Serial.println(aStatus);
+}
+
+/*
+ * setup() runs once when you turn your
+ * Arduino on: use it to initialize and
+ * set any initial values.
+ *
+ * We initialize the serial connection
+ * (for debugging) and the link to the
+ * gateway, and then the SnowPlow
+ * tracker, switching it to batched,
+ * asynchronous sending.
+ */
+void setup()
+{
+  // Serial connection lets us debug on the computer
+  Serial.begin(9600);
+  Serial1.begin(gatewayBaud);
+
+  // Setup SnowPlow Arduino tracker
+  snowplow.initTransport(&gateway);
+  snowplow.setUserId("my-arduino");
+  snowplow.setAsync(true);
+  snowplow.setBatching(10, 1000);
+  snowplow.setTrackCallback(pingSent);
+}
+
+/*
+ * loop() runs over and over again.
+ * An empty loop() takes just a few
+ * clock cycles to complete.
+ *
+ * Every 100ms, queue a 'ping' event
+ * for SnowPlow. The tracker sends
+ * them to the gateway ten at a time.
+ */
+void loop()
+{
+  // When did we run last? 
+  static unsigned long prevTime = 0;
+
+  if (millis() - prevTime >= 100)
+  {
+    snowplow.trackStructEvent("example", "gateway ping");
+
+    prevTime = millis();
+  }
+
+  // Let the tracker get on with sending
+  snowplow.update();
+}
@@ -0,0 +1,117 @@
+/* 
+ * SnowPlow Arduino Tracker: Interrupt Ping Example
+ *
+ * @description Interrupt ping example for SnowPlow Arduino Tracker
+ * @version     0.0.1
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SPI.h>
+#include <Ethernet.h>
+#include <SnowPlowTracker.h>
+
+// MAC address of this Arduino. Update with your shield's MAC address.
+const byte mac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// SnowPlow CloudFront collector subdomain. Update with your collector.
+const char *snowplowCfSubdomain = "d3rkrsqld9gmqf";
+
+// SnowPlow app name
+const char *snowplowAppName = "arduino-ping-examples";
+
+// Pin with a button (to ground) on it. Pin 2 is interrupt 0 on an Uno
+const int buttonPin = 2;
+
+// SnowPlow Tracker
+SnowPlowTracker snowplow(&Ethernet, mac, snowplowAppName);
+
+// Where the interrupt handler puts its events
+SnowPlowInterruptQueue interruptQueue;
+
+/*
+ * Called by the tracker once each
+ * ping has been sent (or has failed).
+ */
+void pingSent(const int aStatus)
+{
+  Serial.print("Ping sent with status: ");
+  Serial.println(aStatus);
+}
+
+/*
+ * Called every time the button is
+ * pressed. It can't send anything
+ * itself, so it just queues a ping
+ * (with the time it happened) for
+ * update() to pick up.
+ */
+void buttonPressed()
+{
+  interruptQueue.push("example", "interrupt ping", NULL, NULL, (int)(millis() / 1000));
+}
+
+/*
+ * setup() runs once when you turn your
+ * Arduino on: use it to initialize and
+ * set any initial values.
+ *
+ * We just initialize the serial
+ * connection (for debugging) and
+ * the SnowPlow tracker, switching
+ * it to asynchronous sending, and
+ * then start listening for button
+ * presses.
+ */
+void setup()
+{
+  // Serial connection lets us debug on the computer
+  Serial.begin(9600);
+
+  // Setup SnowPlow Arduino tracker
+  snowplow.initCf(snowplowCfSubdomain);
+  snowplow.setUserId("my-arduino");
+  snowplow.setAsync(true);
+  snowplow.setTrackCallback(pingSent);
+  snowplow.setInterruptQueue(&interruptQueue);
+
+  pinMode(buttonPin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(buttonPin), buttonPressed, FALLING);
+}
+
+/*
+ * loop() runs over and over again.
+ * An empty loop() takes just a few
+ * clock cycles to complete.
+ *
+ * All we need to do is let the
+ * tracker send the pings queued by
+ * buttonPressed(), and report any
+ * it had no room for.
+ */
+void loop()
+{
+  static unsigned int dropped = 0;
+
+  if (interruptQueue.getDroppedEvents() != dropped)
+  {
+    dropped = interruptQueue.getDroppedEvents();
+    Serial.print("Pings dropped so far: ");
+    Serial.println(dropped);
+  }
+
+  // Let the tracker get on with sending
+  snowplow.update();
+}
@@ -0,0 +1,115 @@
+/* 
+ * SnowPlow Arduino Tracker: Outbox Ping Example
+ *
+ * @description Outbox ping example for SnowPlow Arduino Tracker
+ * @version     0.0.1
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SPI.h>
+#include <Ethernet.h>
+#include <EEPROM.h>
+#include <SnowPlowTracker.h>
+#include <SnowPlowEepromStore.h>
+
+// MAC address of this Arduino. Update with your shield's MAC address.
+const byte mac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// SnowPlow CloudFront collector subdomain. Update with your collector.
+const char *snowplowCfSubdomain = "d3rkrsqld9gmqf";
+
+// SnowPlow app name
+const char *snowplowAppName = "arduino-ping-examples";
+
+// Keep unsent pings in the first 512 bytes of EEPROM
+SnowPlowEepromStore eepromStore(0, 512);
+SnowPlowOutbox outbox(&eepromStore);
+
+// SnowPlow Tracker
+SnowPlowTracker snowplow(&Ethernet, mac, snowplowAppName);
+
+/*
+ * Called by the tracker once each
+ * ping has been sent (or has failed).
+ */
+void pingSent(const int aStatus)
+{
+  Serial.print("Ping sent with status: ");
+  Serial.println(aStatus);
+}
+
+/*
+ * setup() runs once when you turn your
+ * Arduino on: use it to initialize and
+ * set any initial values.
+ *
+ * We just initialize the serial
+ * connection (for debugging) and
+ * the SnowPlow tracker, switching
+ * it to asynchronous sending. Pings
+ * that can't reach the collector go
+ * to the outbox in EEPROM, to be sent
+ * in batches of up to 4 once it's back -
+ * even if we've been rebooted since.
+ */
+void setup()
+{
+  // Serial connection lets us debug on the computer
+  Serial.begin(9600);
+
+#if defined(ESP8266) || defined(ESP32)
+  // These boards keep EEPROM in flash, read into RAM here
+  EEPROM.begin(512);
+#endif
+
+  // Setup SnowPlow Arduino tracker
+  snowplow.initCf(snowplowCfSubdomain);
+  snowplow.setUserId("my-arduino");
+  snowplow.setAsync(true);
+  snowplow.setBatching(4, 15000);
+  snowplow.setTrackCallback(pingSent);
+  snowplow.setOutbox(&outbox);
+
+  Serial.print("Pings left over from last time: ");
+  Serial.println(snowplow.getStoredEvents());
+}
+
+/*
+ * loop() runs over and over again.
+ * An empty loop() takes just a few
+ * clock cycles to complete.
+ *
+ * Every 15 seconds, queue a 'ping'
+ * event for SnowPlow. The tracker
+ * sends it a step at a time in
+ * update(), so loop() never stalls.
+ */
+void loop()
+{
+  // When did we run last? 
+  static unsigned long prevTime = 0;
+
+  if (millis() - prevTime >= (15000))
+  {
+    // Returns EVENT_QUEUED straightaway
+    snowplow.trackStructEvent("example", "outbox ping");
+
+    prevTime = millis();
+  }
+
+  // Let the tracker get on with sending
+  snowplow.update();
+}
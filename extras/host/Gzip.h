@@ -0,0 +1,116 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+
+#ifndef Gzip_h
+#define Gzip_h
+
+#include <string>
+#include <zlib.h>
+#include "Arduino.h"
+
+/**
+ * A Print that keeps everything written
+ * to it, e.g. SnowPlowCompressor's output.
+ */
+class StringPrint : public Print
+{
+ public:
+  virtual size_t write(uint8_t aByte) {
+    this->data += (char)aByte;
+    return 1;
+  }
+  using Print::write;
+
+  std::string data;
+};
+
+/**
+ * Gunzips a whole gzip stream with zlib,
+ * which checks its CRC and length too.
+ *
+ * @param aCompressed The stream
+ * @param aResult Set to what it holds
+ * @return true if it was a valid stream,
+ *         with nothing after it
+ */
+inline bool gunzip(const std::string &aCompressed, std::string &aResult) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+    return false;
+  }
+  stream.next_in = (Bytef *)aCompressed.data();
+  stream.avail_in = aCompressed.size();
+
+  aResult.clear();
+  int status;
+  do {
+    char buffer[4096];
+    stream.next_out = (Bytef *)buffer;
+    stream.avail_out = sizeof(buffer);
+    status = inflate(&stream, Z_NO_FLUSH);
+    aResult.append(buffer, sizeof(buffer) - stream.avail_out);
+  } while (status == Z_OK);
+  const bool valid = (status == Z_STREAM_END) && (stream.avail_in == 0);
+  inflateEnd(&stream);
+  return valid;
+}
+
+/**
+ * Gzips a string with zlib, for
+ * comparison.
+ *
+ * @param aData What to compress
+ * @param aLevel zlib's compression level
+ * @return the gzip stream
+ */
+inline std::string zlibGzip(const std::string &aData, const int aLevel) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  deflateInit2(&stream, aLevel, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  std::string result(deflateBound(&stream, aData.size()), '\0');
+  stream.next_in = (Bytef *)aData.data();
+  stream.avail_in = aData.size();
+  stream.next_out = (Bytef *)&result[0];
+  stream.avail_out = result.size();
+  deflate(&stream, Z_FINISH);
+  result.resize(result.size() - stream.avail_out);
+  deflateEnd(&stream);
+  return result;
+}
+
+// A body like the tracker's for a batch of aEvents events
+inline std::string sampleBatch(const int aEvents) {
+  std::string body = "{\"schema\":\"iglu:com.snowplowanalytics.snowplow/payload_data/jsonschema/1-0-4\",\"data\":[";
+  for (int i = 0; i < aEvents; i++) {
+    char event[320];
+    snprintf(event, sizeof(event),
+             "%s{\"tid\":\"%d.0\",\"p\":\"iot\",\"mac\":\"90:A2:DA:00:F8:A0\",\"aid\":\"test-app\","
+             "\"tv\":\"arduino-0.1.0\",\"dtm\":\"%ld\",\"stm\":\"1381316400000\",\"e\":\"se\",\"ev_ca\":\"sensor\","
+             "\"ev_ac\":\"temperature\",\"ev_la\":\"room %d\",\"ev_va\":\"%d.%02d\"}",
+             (i > 0) ? "," : "", 4242 + i, 1381316390000L + i * 250, i % 3, 18 + i % 5, (i * 37) % 100);
+    body += event;
+  }
+  return body + "]}";
+}
+
+#endif
@@ -0,0 +1,134 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <stdlib.h>
+#include <new>
+#include "HeapCounter.h"
+
+extern "C" {
+void *__real_malloc(size_t aSize);
+void *__real_calloc(size_t aCount, size_t aSize);
+void *__real_realloc(void *aPointer, size_t aSize);
+void __real_free(void *aPointer);
+}
+
+static thread_local unsigned long allocations = 0;
+static thread_local unsigned long frees = 0;
+static thread_local unsigned int paused = 0;
+
+static void countAllocation() {
+  if (paused == 0) {
+    allocations++;
+  }
+}
+
+static void countFree(void *aPointer) {
+  if ((aPointer != NULL) && (paused == 0)) {
+    frees++;
+  }
+}
+
+unsigned long HeapCounter::getAllocations() {
+  return allocations;
+}
+
+unsigned long HeapCounter::getFrees() {
+  return frees;
+}
+
+void HeapCounter::reset() {
+  allocations = 0;
+  frees = 0;
+}
+
+HeapCounter::Pause::Pause() {
+  paused++;
+}
+
+HeapCounter::Pause::~Pause() {
+  paused--;
+}
+
+extern "C" {
+
+void *__wrap_malloc(size_t aSize) {
+  countAllocation();
+  return __real_malloc(aSize);
+}
+
+void *__wrap_calloc(size_t aCount, size_t aSize) {
+  countAllocation();
+  return __real_calloc(aCount, aSize);
+}
+
+void *__wrap_realloc(void *aPointer, size_t aSize) {
+  countAllocation();
+  return __real_realloc(aPointer, aSize);
+}
+
+void __wrap_free(void *aPointer) {
+  countFree(aPointer);
+  __real_free(aPointer);
+}
+
+}
+
+// new and delete go straight to the real malloc() and free(),
+// so they're counted here rather than again by the wrappers
+
+void *operator new(size_t aSize) {
+  countAllocation();
+  void *pointer = __real_malloc(aSize ? aSize : 1);
+  if (pointer == NULL) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](size_t aSize) {
+  return operator new(aSize);
+}
+
+void *operator new(size_t aSize, const std::nothrow_t &) noexcept {
+  countAllocation();
+  return __real_malloc(aSize ? aSize : 1);
+}
+
+void *operator new[](size_t aSize, const std::nothrow_t &aTag) noexcept {
+  return operator new(aSize, aTag);
+}
+
+void operator delete(void *aPointer) noexcept {
+  countFree(aPointer);
+  __real_free(aPointer);
+}
+
+void operator delete[](void *aPointer) noexcept {
+  operator delete(aPointer);
+}
+
+void operator delete(void *aPointer, size_t) noexcept {
+  operator delete(aPointer);
+}
+
+void operator delete[](void *aPointer, size_t) noexcept {
+  operator delete(aPointer);
+}
@@ -0,0 +1,56 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef HeapCounter_h
+#define HeapCounter_h
+
+/**
+ * HeapCounter counts the heap allocations
+ * (malloc(), calloc(), realloc() and new)
+ * made on each thread, so tests can check
+ * that a code path doesn't allocate and
+ * benchmarks can report allocations per
+ * event. malloc() and friends are wrapped
+ * at link time (-Wl,--wrap=malloc etc), and
+ * operator new is replaced.
+ *
+ * The shim's networking stands in for
+ * hardware that doesn't allocate, so it
+ * holds a Pause while it works.
+ */
+class HeapCounter
+{
+ public:
+  // Allocations and frees on this thread since the last reset()
+  static unsigned long getAllocations();
+  static unsigned long getFrees();
+  static void reset();
+
+  // Allocations made while one is in scope (on this thread) aren't counted
+  class Pause
+  {
+   public:
+    Pause();
+    ~Pause();
+  };
+};
+
+#endif
@@ -0,0 +1,267 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include "LoopbackCollector.h"
+
+// How often the thread checks whether it should stop
+static const int kPollInterval = 20;
+
+/**
+ * Constructor for the LoopbackCollector
+ * class. Starts listening straightaway.
+ */
+LoopbackCollector::LoopbackCollector() {
+  this->response = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+  this->latency = 0;
+  this->chunkSize = 0;
+  this->chunkDelay = 0;
+  this->connections = 0;
+  this->stopping = false;
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0; // Any free port
+
+  socklen_t length = sizeof(address);
+  this->listener = socket(AF_INET, SOCK_STREAM, 0);
+  if ((this->listener < 0)
+      || (bind(this->listener, (sockaddr *)&address, sizeof(address)) != 0)
+      || (listen(this->listener, 4) != 0)
+      || (fcntl(this->listener, F_SETFL, O_NONBLOCK) != 0)
+      || (getsockname(this->listener, (sockaddr *)&address, &length) != 0)) {
+    perror("LoopbackCollector");
+    abort();
+  }
+  this->port = ntohs(address.sin_port);
+  this->thread = std::thread(&LoopbackCollector::serve, this);
+}
+
+/**
+ * Stops listening, closing any
+ * connection we have open.
+ */
+LoopbackCollector::~LoopbackCollector() {
+  this->stopping = true;
+  this->thread.join();
+  close(this->listener);
+}
+
+/**
+ * @return the port we're listening on
+ */
+uint16_t LoopbackCollector::getPort() const {
+  return this->port;
+}
+
+/**
+ * Sets what every request is answered
+ * with, once the queued responses have
+ * run out.
+ *
+ * @param aResponse The whole response
+ */
+void LoopbackCollector::setResponse(const char *aResponse) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->response = aResponse;
+}
+
+/**
+ * Queues a response to answer the next
+ * request with, after any already queued.
+ *
+ * @param aResponse The whole response
+ */
+void LoopbackCollector::queueResponse(const char *aResponse) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->queued.push_back(aResponse);
+}
+
+/**
+ * @param aLatency How long to wait (in
+ *        milliseconds) after a request
+ *        before starting to answer it
+ */
+void LoopbackCollector::setLatency(const unsigned long aLatency) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->latency = aLatency;
+}
+
+/**
+ * Has responses written a few bytes at
+ * a time, like a slow or congested link.
+ *
+ * @param aChunkSize How many bytes to
+ *        write at a time, or 0 to write
+ *        each response whole
+ * @param aChunkDelay How long to wait
+ *        (in milliseconds) between them
+ */
+void LoopbackCollector::setChunking(const size_t aChunkSize, const unsigned long aChunkDelay) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->chunkSize = aChunkSize;
+  this->chunkDelay = aChunkDelay;
+}
+
+/**
+ * @return the requests received so far
+ */
+std::vector<MockCollector::Request> LoopbackCollector::getRequests() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->requests;
+}
+
+/**
+ * Forgets the requests received so far.
+ */
+void LoopbackCollector::clearRequests() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->requests.clear();
+}
+
+/**
+ * @return how many connections we've
+ *         accepted
+ */
+unsigned long LoopbackCollector::getConnections() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->connections;
+}
+
+/**
+ * Waits for the socket to be readable,
+ * for a while.
+ *
+ * @param aSocket The socket
+ * @return true if we're to stop, false
+ *         once it's readable or the
+ *         wait is up
+ */
+bool LoopbackCollector::isStopping(const int aSocket) const {
+  pollfd poller;
+  poller.fd = aSocket;
+  poller.events = POLLIN;
+  poll(&poller, 1, kPollInterval);
+  return this->stopping;
+}
+
+/**
+ * The thread: accepts connections and
+ * serves each in turn until we stop.
+ */
+void LoopbackCollector::serve() {
+  while (!this->isStopping(this->listener)) {
+    const int client = accept(this->listener, NULL, NULL);
+    if (client < 0) {
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->connections++;
+    }
+    this->serveConnection(client);
+    close(client);
+  }
+}
+
+/**
+ * Reads requests from a connection and
+ * answers each, until the client closes
+ * it, asks us to, or we stop.
+ *
+ * @param aSocket The connection
+ */
+void LoopbackCollector::serveConnection(const int aSocket) {
+  std::string received;
+  char buffer[1024];
+
+  while (!this->isStopping(aSocket)) {
+    const ssize_t length = recv(aSocket, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (length == 0) {
+      return; // The client closed it
+    }
+    if (length < 0) {
+      continue; // Nothing yet
+    }
+    received.append(buffer, length);
+
+    MockCollector::Request request;
+    while (MockCollector::parseRequest(received, request)) {
+      std::string answer;
+      unsigned long latency;
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requests.push_back(request);
+        if (this->queued.empty()) {
+          answer = this->response;
+        } else {
+          answer = this->queued.front();
+          this->queued.pop_front();
+        }
+        latency = this->latency;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(latency));
+      if (!this->answer(aSocket, answer)
+          || (MockCollector::getHeader(request, "connection") == "close")) {
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * Writes a response, in chunks if
+ * we've been asked to.
+ *
+ * @param aSocket The connection
+ * @param aResponse The whole response
+ * @return true unless the write failed
+ */
+bool LoopbackCollector::answer(const int aSocket, const std::string &aResponse) {
+  size_t chunkSize;
+  unsigned long chunkDelay;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    chunkSize = (this->chunkSize > 0) ? this->chunkSize : aResponse.size();
+    chunkDelay = this->chunkDelay;
+  }
+
+  for (size_t written = 0; written < aResponse.size(); written += chunkSize) {
+    if (written > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(chunkDelay));
+    }
+    const size_t length = std::min(chunkSize, aResponse.size() - written);
+    if (send(aSocket, aResponse.data() + written, length, MSG_NOSIGNAL) != (ssize_t)length) {
+      return false;
+    }
+  }
+  return true;
+}
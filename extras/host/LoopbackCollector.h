@@ -0,0 +1,94 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+
+#ifndef LoopbackCollector_h
+#define LoopbackCollector_h
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MockCollector.h"
+
+/**
+ * LoopbackCollector is a SnowPlow collector
+ * listening on a real socket, on 127.0.0.1
+ * and a port of its own, served from a
+ * thread of its own. Outside the scope of
+ * any MockCollector, EthernetClient uses
+ * real sockets, so a tracker given
+ *
+ *   tracker.initUrl("localhost", collector.getPort());
+ *
+ * goes through the kernel's TCP stack to
+ * reach it. As well as scripted responses
+ * it can wait before answering, and
+ * dribble its answers out a few bytes
+ * at a time.
+ *
+ * It serves one connection at a time,
+ * as the tracker only ever has one open.
+ */
+class LoopbackCollector
+{
+ public:
+  LoopbackCollector();
+  ~LoopbackCollector();
+
+  uint16_t getPort() const;
+
+  // Scripting how it behaves
+  void setResponse(const char *aResponse);
+  void queueResponse(const char *aResponse);
+  void setLatency(const unsigned long aLatency);
+  void setChunking(const size_t aChunkSize, const unsigned long aChunkDelay);
+
+  // What it was sent
+  std::vector<MockCollector::Request> getRequests() const;
+  void clearRequests();
+  unsigned long getConnections() const;
+
+ private:
+  void serve();
+  void serveConnection(const int aSocket);
+  bool answer(const int aSocket, const std::string &aResponse);
+  bool isStopping(const int aSocket) const;
+
+  int listener;
+  uint16_t port;
+  std::atomic<bool> stopping;
+  std::thread thread;
+
+  // Everything below is shared with the thread
+  mutable std::mutex mutex;
+  std::string response;
+  std::deque<std::string> queued;
+  unsigned long latency;
+  size_t chunkSize; // Or 0 to write each response whole
+  unsigned long chunkDelay;
+  std::vector<MockCollector::Request> requests;
+  unsigned long connections;
+};
+
+#endif
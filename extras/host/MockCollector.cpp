@@ -0,0 +1,285 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "MockCollector.h"
+#include "HeapCounter.h"
+
+MockCollector *MockCollector::current = NULL;
+
+/**
+ * Constructor for the MockCollector
+ * class. It takes over from any other
+ * in scope until it's destroyed.
+ */
+MockCollector::MockCollector() {
+  this->previous = current;
+  current = this;
+
+  this->response = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+  this->refusing = false;
+  this->silent = false;
+  this->resolving = true;
+  this->address = IPAddress(127, 0, 0, 1);
+  this->connections = 0;
+  this->lookups = 0;
+  this->bytesReceived = 0;
+}
+
+MockCollector::~MockCollector() {
+  current = this->previous;
+}
+
+/**
+ * @return the MockCollector in scope,
+ *         or NULL if there isn't one
+ */
+MockCollector *MockCollector::getCurrent() {
+  return current;
+}
+
+/**
+ * Sets what every request is answered
+ * with, once the queued responses have
+ * run out.
+ *
+ * @param aResponse The whole response
+ */
+void MockCollector::setResponse(const char *aResponse) {
+  this->response = aResponse;
+}
+
+/**
+ * Queues a response to answer the next
+ * request with, after any already queued.
+ *
+ * @param aResponse The whole response
+ */
+void MockCollector::queueResponse(const char *aResponse) {
+  this->queued.push_back(aResponse);
+}
+
+/**
+ * @param aRefusing Whether to refuse
+ *        connections
+ */
+void MockCollector::setRefusing(const bool aRefusing) {
+  this->refusing = aRefusing;
+}
+
+/**
+ * @param aSilent Whether to take requests
+ *        without ever answering them
+ */
+void MockCollector::setSilent(const bool aSilent) {
+  this->silent = aSilent;
+}
+
+/**
+ * @param aResolving Whether hostnames
+ *        resolve (to us)
+ */
+void MockCollector::setResolving(const bool aResolving) {
+  this->resolving = aResolving;
+}
+
+/**
+ * Moves us to another address, as if
+ * the collector's host had changed IP:
+ * connections to the old one are
+ * refused from now on, and hostnames
+ * resolve to the new one.
+ *
+ * @param aAddress Our new address
+ */
+void MockCollector::setAddress(const IPAddress &aAddress) {
+  this->address = aAddress;
+}
+
+/**
+ * @return the requests received so far
+ */
+const std::vector<MockCollector::Request> &MockCollector::getRequests() const {
+  return this->requests;
+}
+
+/**
+ * Forgets the requests received so far.
+ */
+void MockCollector::clearRequests() {
+  this->requests.clear();
+}
+
+/**
+ * @return how many connections we've
+ *         accepted
+ */
+unsigned long MockCollector::getConnections() const {
+  return this->connections;
+}
+
+/**
+ * @return how many hostnames we've been
+ *         asked to look up, resolved or
+ *         not
+ */
+unsigned long MockCollector::getLookups() const {
+  return this->lookups;
+}
+
+/**
+ * @return how many bytes clients have
+ *         written to us
+ */
+unsigned long MockCollector::getBytesReceived() const {
+  return this->bytesReceived;
+}
+
+/**
+ * Looks a hostname up.
+ *
+ * @param aHost The hostname
+ * @param aIp Set to our address
+ * @return true unless we're not
+ *         resolving
+ */
+bool MockCollector::resolve(const char *aHost, IPAddress &aIp) {
+  this->lookups++;
+  if (!this->resolving) {
+    return false;
+  }
+  aIp = this->address;
+  return true;
+}
+
+/**
+ * Takes a new connection.
+ *
+ * @param aIp The address it's to
+ * @return true unless we're refusing
+ *         them, or it's not to our
+ *         address
+ */
+bool MockCollector::accept(const IPAddress &aIp) {
+  if (this->refusing || (aIp != this->address)) {
+    return false;
+  }
+  this->connections++;
+  return true;
+}
+
+/**
+ * Takes bytes written by a client. Each
+ * time they complete a request, it's
+ * kept and answered.
+ *
+ * @param aConnection The client's
+ *        connection
+ * @param aBuffer The bytes
+ * @param aSize How many
+ */
+void MockCollector::receive(MockConnection &aConnection, const uint8_t *aBuffer, const size_t aSize) {
+  HeapCounter::Pause pause;
+  aConnection.received.append((const char *)aBuffer, aSize);
+  this->bytesReceived += aSize;
+
+  Request request;
+  while (parseRequest(aConnection.received, request)) {
+    this->requests.push_back(request);
+
+    if (this->silent) {
+      continue;
+    }
+    if (this->queued.empty()) {
+      aConnection.response += this->response;
+    } else {
+      aConnection.response += this->queued.front();
+      this->queued.pop_front();
+    }
+    if (getHeader(request, "connection") == "close") {
+      aConnection.closing = true;
+    }
+  }
+}
+
+/**
+ * Takes the first request off the
+ * front of the bytes received, if
+ * they hold a whole one yet.
+ *
+ * @param aReceived The bytes received
+ * @param aRequest Set to the request
+ * @return true if there was one
+ */
+bool MockCollector::parseRequest(std::string &aReceived, Request &aRequest) {
+  const size_t headersEnd = aReceived.find("\r\n\r\n");
+  if (headersEnd == std::string::npos) {
+    return false;
+  }
+
+  const size_t lineEnd = aReceived.find("\r\n");
+  const std::string line = aReceived.substr(0, lineEnd);
+  const size_t targetStart = line.find(' ') + 1;
+  const size_t targetEnd = line.find(' ', targetStart);
+  aRequest.method = line.substr(0, targetStart - 1);
+  aRequest.target = line.substr(targetStart, targetEnd - targetStart);
+  aRequest.headers = aReceived.substr(lineEnd + 2, headersEnd + 2 - (lineEnd + 2));
+
+  const std::string length = getHeader(aRequest, "content-length");
+  const size_t bodyLength = length.empty() ? 0 : strtoul(length.c_str(), NULL, 10);
+  if (aReceived.size() < headersEnd + 4 + bodyLength) {
+    return false; // Wait for the rest of the body
+  }
+  aRequest.body = aReceived.substr(headersEnd + 4, bodyLength);
+  aReceived.erase(0, headersEnd + 4 + bodyLength);
+  return true;
+}
+
+/**
+ * Finds a header in a request.
+ *
+ * @param aRequest The request
+ * @param aName The header's name, in
+ *        lower case
+ * @return its value, trimmed and in
+ *         lower case, or "" if it
+ *         wasn't sent
+ */
+std::string MockCollector::getHeader(const Request &aRequest, const char *aName) {
+  std::string headers = aRequest.headers;
+  for (size_t i = 0; i < headers.size(); i++) {
+    headers[i] = tolower(headers[i]);
+  }
+
+  const std::string name = std::string(aName) + ":";
+  size_t start = 0;
+  while (start < headers.size()) {
+    const size_t end = headers.find("\r\n", start);
+    if (headers.compare(start, name.size(), name) == 0) {
+      size_t value = start + name.size();
+      while ((value < end) && (headers[value] == ' ')) {
+        value++;
+      }
+      return headers.substr(value, end - value);
+    }
+    start = end + 2;
+  }
+  return "";
+}
@@ -0,0 +1,115 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef MockCollector_h
+#define MockCollector_h
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+// The collector's end of one EthernetClient's connection
+class MockConnection
+{
+ public:
+  MockConnection() : read(0), closing(false) {}
+
+  std::string received; // Bytes of a request not yet complete
+  std::string response; // Bytes for the client to read
+  size_t read; // How many of them it has
+  bool closing; // Whether we close once they've all been read
+};
+
+/**
+ * MockCollector stands in for a SnowPlow
+ * collector, in memory. While one is in
+ * scope, every EthernetClient connects to
+ * it and every hostname resolves to it
+ * (to its address, which tests can move).
+ *
+ * It takes requests apart (using their
+ * Content-Length to find the end of any
+ * body) and keeps them for tests to look
+ * at, answering each straightaway with
+ * the next queued response, or else the
+ * default one: a 200 with no body. It
+ * closes the connection after answering
+ * a request with "Connection: close".
+ */
+class MockCollector
+{
+ public:
+  // A request as received
+  typedef struct
+  {
+    std::string method;
+    std::string target; // Path and querystring
+    std::string headers; // As sent, after the request line
+    std::string body;
+  } Request;
+
+  MockCollector();
+  ~MockCollector();
+
+  static MockCollector *getCurrent();
+
+  // Scripting how it behaves
+  void setResponse(const char *aResponse);
+  void queueResponse(const char *aResponse);
+  void setRefusing(const bool aRefusing);
+  void setSilent(const bool aSilent);
+  void setResolving(const bool aResolving);
+  void setAddress(const IPAddress &aAddress);
+
+  // What it was sent
+  const std::vector<Request> &getRequests() const;
+  void clearRequests();
+  unsigned long getConnections() const;
+  unsigned long getLookups() const;
+  unsigned long getBytesReceived() const;
+
+  // For EthernetClient and DNSClient
+  bool resolve(const char *aHost, IPAddress &aIp);
+  bool accept(const IPAddress &aIp);
+  void receive(MockConnection &aConnection, const uint8_t *aBuffer, const size_t aSize);
+
+  static bool parseRequest(std::string &aReceived, Request &aRequest);
+  static std::string getHeader(const Request &aRequest, const char *aName);
+
+ private:
+  static MockCollector *current;
+  MockCollector *previous;
+
+  std::string response;
+  std::deque<std::string> queued;
+  bool refusing;
+  bool silent;
+  bool resolving;
+  IPAddress address;
+
+  std::vector<Request> requests;
+  unsigned long connections;
+  unsigned long lookups;
+  unsigned long bytesReceived;
+};
+
+#endif
@@ -0,0 +1,145 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+/*
+ * Host benchmark for the tracker. For each
+ * trackStructEvent() overload, and for the
+ * blocking, async and batched send modes,
+ * reports events per second, bytes written
+ * per event and heap allocations per event,
+ * against an in-memory collector, or with
+ * "loopback", one reached over TCP.
+ *
+ * Usage: snowplow_benchmark [events] [loopback]
+ */
+
+#include <chrono>
+#include <SnowPlowTracker.h>
+#include "HeapCounter.h"
+#include "MockCollector.h"
+#include "LoopbackCollector.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// As many typical events as the default queue holds
+static const size_t kBatchSize = 4;
+
+enum Mode { eBlocking, eAsync, eBatched };
+static const char *const kModeNames[] = { "blocking", "async", "batched" };
+
+enum Overload { eNoValue, eInt, eDouble, eFloat, eTypedInt };
+static const char *const kOverloadNames[] = { "no value", "int", "double", "float", "Event<int>" };
+
+static const SnowPlowTracker::Event<int> kTypedEvent("benchmark", "typed", "label", "property");
+
+static void track(SnowPlowTracker &aTracker, const Overload aOverload, const int i) {
+  switch (aOverload) {
+    case eNoValue:  aTracker.trackStructEvent("benchmark", "none", "label", "property"); break;
+    case eInt:      aTracker.trackStructEvent("benchmark", "int", "label", "property", i); break;
+    case eDouble:   aTracker.trackStructEvent("benchmark", "double", "label", "property", i * 0.25, 2); break;
+    case eFloat:    aTracker.trackStructEvent("benchmark", "float", "label", "property", i * 0.25f, 2); break;
+    case eTypedInt: aTracker.trackEvent(kTypedEvent, i); break;
+  }
+}
+
+static void drain(SnowPlowTracker &aTracker) {
+  while (aTracker.isBusy()) {
+    aTracker.update();
+  }
+}
+
+// Whichever collector we're sending to
+static MockCollector *mockCollector = NULL;
+static LoopbackCollector *loopbackCollector = NULL;
+
+static void clearRequests() {
+  if (mockCollector != NULL) {
+    mockCollector->clearRequests();
+  } else {
+    loopbackCollector->clearRequests();
+  }
+}
+
+static void run(SnowPlowTracker &aTracker, const Mode aMode, const Overload aOverload, const int aEvents) {
+  // One untimed event so connection set up is out of the way
+  track(aTracker, aOverload, 0);
+  aTracker.flush();
+  drain(aTracker);
+
+  const unsigned long bytesBefore = aTracker.getBytesWritten();
+  const unsigned long sentBefore = aTracker.getMetrics().sent;
+  const unsigned long droppedBefore = aTracker.getDroppedEvents();
+  HeapCounter::reset();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < aEvents; i++) {
+    track(aTracker, aOverload, i);
+    // Send each event, or each full batch, before the next one
+    if ((aMode == eAsync) || ((aMode == eBatched) && ((i + 1) % kBatchSize == 0))) {
+      drain(aTracker);
+    }
+  }
+  aTracker.flush();
+  drain(aTracker);
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const unsigned long allocations = HeapCounter::getAllocations();
+  const unsigned long sent = (aMode == eBlocking)
+    ? aEvents : aTracker.getMetrics().sent - sentBefore;
+
+  const unsigned long dropped = aTracker.getDroppedEvents() - droppedBefore;
+
+  printf("%-11s %-9s %12.0f %12.1f %13.2f %8lu %8lu\n",
+         kOverloadNames[aOverload], kModeNames[aMode],
+         sent / seconds,
+         (double)(aTracker.getBytesWritten() - bytesBefore) / aEvents,
+         (double)allocations / aEvents,
+         sent, dropped);
+  clearRequests();
+}
+
+int main(int argc, char **argv) {
+  const int events = (argc > 1) ? atoi(argv[1]) : 20000;
+
+  const bool loopback = (argc > 2) && (strcmp(argv[2], "loopback") == 0);
+
+  static SnowPlowTracker tracker(&Ethernet, kMac, "benchmark");
+  if (loopback) {
+    loopbackCollector = new LoopbackCollector();
+    tracker.initUrl("localhost", loopbackCollector->getPort());
+  } else {
+    mockCollector = new MockCollector();
+    tracker.initUrl("collector.test");
+  }
+  tracker.setUserId("benchmark-user");
+  tracker.setKeepAlive(true);
+
+  printf("%-11s %-9s %12s %12s %13s %8s %8s\n",
+         "overload", "mode", "events/sec", "bytes/event", "allocs/event", "sent", "dropped");
+  for (int mode = eBlocking; mode <= eBatched; mode++) {
+    tracker.setAsync(mode != eBlocking);
+    tracker.setBatching((mode == eBatched) ? kBatchSize : 1);
+    for (int overload = eNoValue; overload <= eTypedInt; overload++) {
+      run(tracker, (Mode) mode, (Overload) overload, events);
+    }
+  }
+  return 0;
+}
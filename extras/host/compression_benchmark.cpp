@@ -0,0 +1,77 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+/*
+ * Host benchmark for SnowPlowCompressor:
+ * compression ratio and throughput on
+ * batch bodies like the tracker's, and on
+ * random bytes, next to zlib at its
+ * fastest and default levels.
+ *
+ * Usage: snowplow_compression_benchmark [repeats]
+ */
+
+#include <chrono>
+#include <SnowPlowCompressor.h>
+#include "Gzip.h"
+
+static SnowPlowCompressor compressor;
+
+static std::string randomBytes(const size_t aLength) {
+  std::string data;
+  unsigned long seed = 1;
+  for (size_t i = 0; i < aLength; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    data += (char)(seed >> 56);
+  }
+  return data;
+}
+
+static void run(const char *aName, const std::string &aData, const int aRepeats) {
+  StringPrint out;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < aRepeats; i++) {
+    out.data.clear();
+    compressor.begin(out);
+    compressor.write((const uint8_t *)aData.data(), aData.size());
+    compressor.end();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%-20s %8zu %8zu %7.2f %9.1f %9.2f %9.2f\n", aName, aData.size(), out.data.size(),
+         (double)aData.size() / out.data.size(),
+         aData.size() * (double)aRepeats / seconds / 1e6,
+         (double)aData.size() / zlibGzip(aData, 1).size(),
+         (double)aData.size() / zlibGzip(aData, 6).size());
+}
+
+int main(int argc, char **argv) {
+  const int repeats = (argc > 1) ? atoi(argv[1]) : 200;
+
+  printf("%-20s %8s %8s %7s %9s %9s %9s\n",
+         "input", "bytes", "gzipped", "ratio", "MB/s", "zlib -1", "zlib -6");
+  run("batch of 1", sampleBatch(1), repeats * 16);
+  run("batch of 4", sampleBatch(4), repeats * 4);
+  run("batch of 10", sampleBatch(10), repeats * 2);
+  run("batch of 64", sampleBatch(64), repeats);
+  run("random bytes", randomBytes(16384), repeats);
+  return 0;
+}
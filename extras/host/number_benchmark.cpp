@@ -0,0 +1,82 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+/*
+ * Host microbenchmark for SnowPlowNumber:
+ * ns per call of formatInt() and
+ * formatDouble(), next to snprintf() and
+ * dtostrf() formatting the same values.
+ * Only the ratios mean much: on AVR both
+ * sides are far slower, and printf()'s
+ * float support costs flash as well.
+ *
+ * Usage: snowplow_number_benchmark [calls]
+ */
+
+#include <chrono>
+#include <SnowPlowNumber.h>
+
+static const int kValues = 1024;
+static long ints[kValues];
+static double doubles[kValues];
+static volatile size_t sink; // So no call is optimized away
+
+template <typename TFormat>
+static void run(const char *aName, const int aCalls, TFormat aFormat) {
+  char buffer[64];
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < aCalls; i++) {
+    sink = aFormat(buffer, i % kValues);
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%-28s %8.1f ns/call\n", aName, seconds * 1e9 / aCalls);
+}
+
+int main(int argc, char **argv) {
+  const int calls = (argc > 1) ? atoi(argv[1]) : 2000000;
+
+  unsigned long seed = 42;
+  for (int i = 0; i < kValues; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    ints[i] = (long)(seed >> 33) - (1L << 30); // Like the readings tracked on AVR
+    doubles[i] = (double)ints[i] / 1000;
+  }
+
+  run("formatInt", calls, [](char *aBuffer, int i) {
+    return SnowPlowNumber::formatInt(aBuffer, ints[i]);
+  });
+  run("snprintf(\"%ld\")", calls, [](char *aBuffer, int i) {
+    return (size_t)snprintf(aBuffer, 64, "%ld", ints[i]);
+  });
+  run("formatDouble, 2 places", calls, [](char *aBuffer, int i) {
+    return SnowPlowNumber::formatDouble(aBuffer, doubles[i], 2);
+  });
+  run("dtostrf, 2 places", calls, [](char *aBuffer, int i) {
+    return strlen(dtostrf(doubles[i], 1, 2, aBuffer));
+  });
+  run("formatDouble, 6 places", calls, [](char *aBuffer, int i) {
+    return SnowPlowNumber::formatDouble(aBuffer, doubles[i], 6);
+  });
+  run("dtostrf, 6 places", calls, [](char *aBuffer, int i) {
+    return strlen(dtostrf(doubles[i], 1, 6, aBuffer));
+  });
+  return 0;
+}
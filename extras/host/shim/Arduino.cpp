@@ -0,0 +1,167 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "Arduino.h"
+#include "HostClock.h"
+
+HardwareSerial Serial;
+
+// Time
+static bool virtualTime = false;
+static unsigned long long virtualMicros = 0;
+
+/**
+ * @return microseconds on the host's
+ *         monotonic clock, from the first
+ *         time it was read
+ */
+static unsigned long long realMicros() {
+  static unsigned long long start = 0;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const unsigned long long micros = (unsigned long long)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+  if (start == 0) {
+    start = micros;
+  }
+  return micros - start;
+}
+
+unsigned long millis() {
+  return (unsigned long)((virtualTime ? virtualMicros : realMicros()) / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)(virtualTime ? virtualMicros : realMicros());
+}
+
+void delay(unsigned long aMs) {
+  if (virtualTime) {
+    virtualMicros += aMs * 1000ULL;
+    return;
+  }
+  struct timespec wait;
+  wait.tv_sec = aMs / 1000;
+  wait.tv_nsec = (aMs % 1000) * 1000000L;
+  nanosleep(&wait, NULL);
+}
+
+void delayMicroseconds(unsigned int aUs) {
+  if (virtualTime) {
+    virtualMicros += aUs;
+    return;
+  }
+  struct timespec wait;
+  wait.tv_sec = 0;
+  wait.tv_nsec = aUs * 1000L;
+  nanosleep(&wait, NULL);
+}
+
+/**
+ * Switches millis() and friends to a
+ * virtual clock.
+ *
+ * @param aStart What millis() reads now
+ */
+void HostClock::useVirtualTime(const unsigned long aStart) {
+  virtualTime = true;
+  virtualMicros = aStart * 1000ULL;
+}
+
+/**
+ * Switches millis() and friends back
+ * to the host's clock.
+ */
+void HostClock::useRealTime() {
+  virtualTime = false;
+}
+
+/**
+ * @return true if the virtual clock
+ *         is in use
+ */
+bool HostClock::isVirtual() {
+  return virtualTime;
+}
+
+/**
+ * Moves the virtual clock on, as if
+ * aMs had gone by. Does nothing to
+ * the real one.
+ *
+ * @param aMs How far to move it
+ */
+void HostClock::advance(const unsigned long aMs) {
+  if (virtualTime) {
+    virtualMicros += aMs * 1000ULL;
+  }
+}
+
+// Random numbers: xorshift32, so runs can be repeated
+static uint32_t randomState = 2463534242UL;
+
+long random(long aMax) {
+  if (aMax <= 0) {
+    return 0;
+  }
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return (long)(randomState % (unsigned long)aMax);
+}
+
+long random(long aMin, long aMax) {
+  if (aMin >= aMax) {
+    return aMin;
+  }
+  return aMin + random(aMax - aMin);
+}
+
+void randomSeed(unsigned long aSeed) {
+  if (aSeed != 0) {
+    randomState = (uint32_t)aSeed;
+  }
+}
+
+char *dtostrf(double aValue, signed char aWidth, unsigned char aPrecision, char *aBuffer) {
+  sprintf(aBuffer, "%*.*f", aWidth, aPrecision, aValue);
+  return aBuffer;
+}
+
+// Serial
+size_t HardwareSerial::write(uint8_t aByte) {
+  if (this->begun) {
+    putchar(aByte);
+  }
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *aBuffer, size_t aSize) {
+  if (this->begun) {
+    fwrite(aBuffer, 1, aSize, stdout);
+  }
+  return aSize;
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
@@ -0,0 +1,72 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+// Just enough of the Arduino core to build the
+// tracker on a Linux host. Time comes from the
+// host's clock, or from a virtual one that only
+// moves when told to (see HostClock.h)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+class __FlashStringHelper;
+#define F(aString) (reinterpret_cast<const __FlashStringHelper *>(PSTR(aString)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long aMs);
+void delayMicroseconds(unsigned int aUs);
+
+long random(long aMax);
+long random(long aMin, long aMax);
+void randomSeed(unsigned long aSeed);
+
+char *dtostrf(double aValue, signed char aWidth, unsigned char aPrecision, char *aBuffer);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void pinMode(uint8_t aPin, uint8_t aMode) {}
+inline void digitalWrite(uint8_t aPin, uint8_t aValue) {}
+inline int digitalRead(uint8_t aPin) { return LOW; }
+
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "HardwareSerial.h"
+
+#endif
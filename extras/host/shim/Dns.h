@@ -0,0 +1,40 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef Dns_h
+#define Dns_h
+
+#include "Arduino.h"
+
+/**
+ * Looks hostnames up, as the Ethernet
+ * library's DNSClient does. Names resolve
+ * to the MockCollector in scope, if there
+ * is one, or else are looked up for real.
+ */
+class DNSClient
+{
+ public:
+  void begin(const IPAddress &aDnsServer) {}
+  int getHostByName(const char *aHostname, IPAddress &aResult);
+};
+
+#endif
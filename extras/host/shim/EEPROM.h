@@ -0,0 +1,70 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include "Arduino.h"
+
+/**
+ * An Uno's 1 KB of EEPROM, erased (all
+ * 0xFF) to start with. It lives as long
+ * as the program, so a test can "reboot"
+ * by making a new tracker over it.
+ * commit() (as on the ESP8266 and ESP32,
+ * where it writes the RAM copy to flash)
+ * just counts calls.
+ */
+class EEPROMClass
+{
+ public:
+  static const uint16_t kSize = 1024;
+
+  unsigned long commits;
+
+  EEPROMClass() : commits(0) {
+    memset(this->cells, 0xFF, sizeof(this->cells));
+  }
+
+  uint8_t read(int aAddress) {
+    return this->cells[aAddress];
+  }
+  void write(int aAddress, uint8_t aValue) {
+    this->cells[aAddress] = aValue;
+  }
+  void update(int aAddress, uint8_t aValue) {
+    this->cells[aAddress] = aValue;
+  }
+  uint16_t length() {
+    return kSize;
+  }
+  bool commit() {
+    this->commits++;
+    return true;
+  }
+
+ private:
+  uint8_t cells[kSize];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
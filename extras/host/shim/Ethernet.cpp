@@ -0,0 +1,274 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Ethernet.h"
+#include "Dns.h"
+#include "MockCollector.h"
+#include "HeapCounter.h"
+
+EthernetClass Ethernet;
+
+/**
+ * Constructor for the EthernetClient
+ * class.
+ */
+EthernetClient::EthernetClient() {
+  this->connection = NULL;
+  this->socket = -1;
+  this->peerClosed = false;
+}
+
+EthernetClient::~EthernetClient() {
+  this->stop();
+}
+
+/**
+ * Connects to the MockCollector in
+ * scope, if there is one and it
+ * isn't refusing connections, or
+ * else over TCP.
+ *
+ * @param aIp The address to connect to
+ *        (ignored by a MockCollector)
+ * @param aPort The port (likewise)
+ * @return 1 if we connected, else 0
+ */
+int EthernetClient::connect(IPAddress aIp, uint16_t aPort) {
+  HeapCounter::Pause pause;
+  this->stop();
+  MockCollector *collector = MockCollector::getCurrent();
+  if (collector == NULL) {
+    return this->connectSocket(aIp, aPort);
+  }
+  if (!collector->accept(aIp)) {
+    return 0;
+  }
+  this->connection = new MockConnection();
+  return 1;
+}
+
+/**
+ * Opens a TCP connection. It's left
+ * blocking for writes, which on
+ * loopback don't block for long, but
+ * reads never wait.
+ *
+ * @param aIp The address to connect to
+ * @param aPort The port
+ * @return 1 if we connected, else 0
+ */
+int EthernetClient::connectSocket(IPAddress aIp, uint16_t aPort) {
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(aPort);
+  const uint8_t ip[4] = { aIp[0], aIp[1], aIp[2], aIp[3] };
+  memcpy(&address.sin_addr, ip, sizeof(ip));
+
+  this->socket = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (this->socket < 0) {
+    return 0;
+  }
+  if (::connect(this->socket, (sockaddr *)&address, sizeof(address)) != 0) {
+    this->stop();
+    return 0;
+  }
+  // Send each write straightaway, as the shield does
+  const int noDelay = 1;
+  setsockopt(this->socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  this->peerClosed = false;
+  return 1;
+}
+
+/**
+ * Looks the host up, then connects
+ * to it.
+ *
+ * @param aHost The hostname
+ * @param aPort The port
+ * @return 1 if we connected, else 0
+ */
+int EthernetClient::connect(const char *aHost, uint16_t aPort) {
+  IPAddress ip;
+  DNSClient dns;
+  if (dns.getHostByName(aHost, ip) != 1) {
+    return 0;
+  }
+  return this->connect(ip, aPort);
+}
+
+size_t EthernetClient::write(uint8_t aByte) {
+  return this->write(&aByte, 1);
+}
+
+size_t EthernetClient::write(const uint8_t *aBuffer, size_t aSize) {
+  if (this->socket >= 0) {
+    size_t written = 0;
+    while (written < aSize) {
+      const ssize_t sent = send(this->socket, aBuffer + written, aSize - written, MSG_NOSIGNAL);
+      if (sent <= 0) {
+        break;
+      }
+      written += sent;
+    }
+    return written;
+  }
+
+  MockCollector *collector = MockCollector::getCurrent();
+  if ((this->connection == NULL) || this->connection->closing || (collector == NULL)) {
+    return 0;
+  }
+  collector->receive(*this->connection, aBuffer, aSize);
+  return aSize;
+}
+
+int EthernetClient::available() {
+  if (this->socket >= 0) {
+    int available = 0;
+    if ((ioctl(this->socket, FIONREAD, &available) != 0) || (available < 0)) {
+      return 0;
+    }
+    if (available == 0) {
+      // Nothing to read: is that because the other end has closed?
+      uint8_t c;
+      if (recv(this->socket, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+        this->peerClosed = true;
+      }
+    }
+    return available;
+  }
+
+  if (this->connection == NULL) {
+    return 0;
+  }
+  return (int)(this->connection->response.size() - this->connection->read);
+}
+
+int EthernetClient::read() {
+  uint8_t c;
+  return (this->read(&c, 1) == 1) ? c : -1;
+}
+
+int EthernetClient::read(uint8_t *aBuffer, size_t aSize) {
+  if (this->socket >= 0) {
+    const ssize_t length = recv(this->socket, aBuffer, aSize, MSG_DONTWAIT);
+    if (length == 0) {
+      this->peerClosed = true;
+    }
+    return (length > 0) ? (int)length : -1;
+  }
+
+  const int available = this->available();
+  if (available <= 0) {
+    return -1;
+  }
+  const size_t length = (aSize < (size_t)available) ? aSize : (size_t)available;
+  memcpy(aBuffer, this->connection->response.data() + this->connection->read, length);
+  this->connection->read += length;
+  return (int)length;
+}
+
+int EthernetClient::peek() {
+  if (this->socket >= 0) {
+    uint8_t c;
+    return (recv(this->socket, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1) ? c : -1;
+  }
+
+  if (this->available() <= 0) {
+    return -1;
+  }
+  return (uint8_t)this->connection->response[this->connection->read];
+}
+
+void EthernetClient::flush() {
+}
+
+/**
+ * Closes the connection, dropping
+ * anything left unread.
+ */
+void EthernetClient::stop() {
+  HeapCounter::Pause pause;
+  if (this->socket >= 0) {
+    close(this->socket);
+    this->socket = -1;
+  }
+  delete this->connection;
+  this->connection = NULL;
+}
+
+/**
+ * @return 1 while the connection is
+ *         open, or there's still some
+ *         of the response to read
+ */
+uint8_t EthernetClient::connected() {
+  if (this->socket >= 0) {
+    const int available = this->available();
+    return !this->peerClosed || (available > 0);
+  }
+
+  if (this->connection == NULL) {
+    return 0;
+  }
+  return !this->connection->closing || (this->available() > 0);
+}
+
+EthernetClient::operator bool() {
+  return (this->connection != NULL) || (this->socket >= 0);
+}
+
+/**
+ * Looks a hostname up, through the
+ * MockCollector in scope, or if there
+ * isn't one, the host's resolver.
+ *
+ * @param aHostname The hostname
+ * @param aResult Set to its address
+ * @return 1 if it was found, else -1
+ */
+int DNSClient::getHostByName(const char *aHostname, IPAddress &aResult) {
+  MockCollector *collector = MockCollector::getCurrent();
+  if (collector != NULL) {
+    return collector->resolve(aHostname, aResult) ? 1 : -1;
+  }
+
+  HeapCounter::Pause pause;
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *found;
+  if (getaddrinfo(aHostname, NULL, &hints, &found) != 0) {
+    return -1;
+  }
+  const uint8_t *ip = (const uint8_t *)&((sockaddr_in *)found->ai_addr)->sin_addr;
+  aResult = IPAddress(ip[0], ip[1], ip[2], ip[3]);
+  freeaddrinfo(found);
+  return 1;
+}
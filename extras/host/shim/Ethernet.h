@@ -0,0 +1,54 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef Ethernet_h
+#define Ethernet_h
+
+#include "Arduino.h"
+#include "Client.h"
+#include "EthernetClient.h"
+
+/**
+ * The Ethernet shield. There's nothing to
+ * bring up on a host: begin() always
+ * succeeds, and we're at 127.0.0.1.
+ */
+class EthernetClass
+{
+ public:
+  int begin(uint8_t *aMac) {
+    return 1;
+  }
+  void begin(uint8_t *aMac, IPAddress aIp) {}
+  int maintain() {
+    return 0;
+  }
+  IPAddress localIP() {
+    return IPAddress(127, 0, 0, 1);
+  }
+  IPAddress dnsServerIP() {
+    return IPAddress(127, 0, 0, 53);
+  }
+};
+
+extern EthernetClass Ethernet;
+
+#endif
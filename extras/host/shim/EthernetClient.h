@@ -0,0 +1,65 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef EthernetClient_h
+#define EthernetClient_h
+
+#include "Arduino.h"
+#include "Client.h"
+
+class MockConnection;
+
+/**
+ * A connection through the Ethernet shield,
+ * made to the MockCollector (see
+ * MockCollector.h) that's in scope, or if
+ * there isn't one, a real TCP connection
+ * (see LoopbackCollector.h).
+ */
+class EthernetClient : public Client
+{
+ public:
+  EthernetClient();
+  virtual ~EthernetClient();
+
+  virtual int connect(IPAddress aIp, uint16_t aPort);
+  virtual int connect(const char *aHost, uint16_t aPort);
+  virtual size_t write(uint8_t aByte);
+  virtual size_t write(const uint8_t *aBuffer, size_t aSize);
+  using Print::write;
+  virtual int available();
+  virtual int read();
+  virtual int read(uint8_t *aBuffer, size_t aSize);
+  virtual int peek();
+  virtual void flush();
+  virtual void stop();
+  virtual uint8_t connected();
+  virtual operator bool();
+
+ private:
+  int connectSocket(IPAddress aIp, uint16_t aPort);
+
+  MockConnection *connection; // Or NULL when not connected to a MockCollector
+  int socket; // Or -1 when not connected over TCP
+  bool peerClosed; // Whether the other end has closed the socket
+};
+
+#endif
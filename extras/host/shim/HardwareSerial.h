@@ -0,0 +1,61 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include "Stream.h"
+
+/**
+ * The Serial port: what's written to it
+ * goes to stdout once begin() has been
+ * called (and is dropped before, as on a
+ * board), and nothing is ever read.
+ */
+class HardwareSerial : public Stream
+{
+ public:
+  HardwareSerial() : begun(false) {}
+
+  void begin(unsigned long aBaud) {
+    this->begun = true;
+  }
+  void end() {
+    this->begun = false;
+  }
+
+  virtual size_t write(uint8_t aByte);
+  virtual size_t write(const uint8_t *aBuffer, size_t aSize);
+  using Print::write;
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+  virtual void flush();
+
+  operator bool() const { return true; }
+
+ private:
+  bool begun;
+};
+
+extern HardwareSerial Serial;
+
+#endif
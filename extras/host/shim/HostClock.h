@@ -0,0 +1,44 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef HostClock_h
+#define HostClock_h
+
+/**
+ * HostClock picks what millis(), micros()
+ * and delay() run on. By default that's
+ * the host's own clock, so delay() really
+ * sleeps; tests can switch to a virtual
+ * clock that only moves when delay() or
+ * advance() move it, so that timeouts
+ * and back-offs take no time at all and
+ * come out the same on every run.
+ */
+class HostClock
+{
+ public:
+  static void useVirtualTime(const unsigned long aStart = 0);
+  static void useRealTime();
+  static bool isVirtual();
+  static void advance(const unsigned long aMs);
+};
+
+#endif
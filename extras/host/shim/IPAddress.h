@@ -0,0 +1,67 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdint.h>
+#include <string.h>
+#include "Printable.h"
+
+/**
+ * An IPv4 address, as in the Arduino core.
+ */
+class IPAddress : public Printable
+{
+ public:
+  IPAddress() {
+    memset(this->bytes, 0, sizeof(this->bytes));
+  }
+  IPAddress(uint8_t aFirst, uint8_t aSecond, uint8_t aThird, uint8_t aFourth) {
+    this->bytes[0] = aFirst;
+    this->bytes[1] = aSecond;
+    this->bytes[2] = aThird;
+    this->bytes[3] = aFourth;
+  }
+  IPAddress(const uint8_t *aAddress) {
+    memcpy(this->bytes, aAddress, sizeof(this->bytes));
+  }
+
+  bool operator==(const IPAddress &aOther) const {
+    return memcmp(this->bytes, aOther.bytes, sizeof(this->bytes)) == 0;
+  }
+  bool operator!=(const IPAddress &aOther) const {
+    return !(*this == aOther);
+  }
+  uint8_t operator[](int aIndex) const {
+    return this->bytes[aIndex];
+  }
+  uint8_t &operator[](int aIndex) {
+    return this->bytes[aIndex];
+  }
+
+  virtual size_t printTo(Print &aOut) const;
+
+ private:
+  uint8_t bytes[4];
+};
+
+#endif
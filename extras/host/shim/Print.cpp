@@ -0,0 +1,234 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include "Arduino.h"
+#include "Printable.h"
+
+/**
+ * Writes a buffer a byte at a time.
+ * Subclasses that can do better
+ * override it.
+ *
+ * @param aBuffer The bytes to write
+ * @param aSize How many
+ * @return how many were written
+ */
+size_t Print::write(const uint8_t *aBuffer, size_t aSize) {
+  size_t written = 0;
+  while (aSize-- > 0) {
+    if (this->write(*aBuffer++) == 0) {
+      break;
+    }
+    written++;
+  }
+  return written;
+}
+
+size_t Print::print(const __FlashStringHelper *aString) {
+  return this->write((const char *)aString);
+}
+
+size_t Print::print(const char aString[]) {
+  return this->write(aString);
+}
+
+size_t Print::print(char aChar) {
+  return this->write((uint8_t)aChar);
+}
+
+size_t Print::print(unsigned char aNumber, int aBase) {
+  return this->print((unsigned long)aNumber, aBase);
+}
+
+size_t Print::print(int aNumber, int aBase) {
+  return this->print((long)aNumber, aBase);
+}
+
+size_t Print::print(unsigned int aNumber, int aBase) {
+  return this->print((unsigned long)aNumber, aBase);
+}
+
+size_t Print::print(long aNumber, int aBase) {
+  if (aBase == 0) {
+    return this->write((uint8_t)aNumber);
+  }
+  if ((aBase == 10) && (aNumber < 0)) {
+    const size_t sign = this->print('-');
+    return sign + this->printNumber(0UL - (unsigned long)aNumber, 10);
+  }
+  return this->printNumber((unsigned long)aNumber, aBase);
+}
+
+size_t Print::print(unsigned long aNumber, int aBase) {
+  if (aBase == 0) {
+    return this->write((uint8_t)aNumber);
+  }
+  return this->printNumber(aNumber, aBase);
+}
+
+size_t Print::print(double aNumber, int aDigits) {
+  return this->printFloat(aNumber, aDigits);
+}
+
+size_t Print::print(const Printable &aPrintable) {
+  return aPrintable.printTo(*this);
+}
+
+size_t Print::println(const __FlashStringHelper *aString) {
+  const size_t length = this->print(aString);
+  return length + this->println();
+}
+
+size_t Print::println(const char aString[]) {
+  const size_t length = this->print(aString);
+  return length + this->println();
+}
+
+size_t Print::println(char aChar) {
+  const size_t length = this->print(aChar);
+  return length + this->println();
+}
+
+size_t Print::println(unsigned char aNumber, int aBase) {
+  const size_t length = this->print(aNumber, aBase);
+  return length + this->println();
+}
+
+size_t Print::println(int aNumber, int aBase) {
+  const size_t length = this->print(aNumber, aBase);
+  return length + this->println();
+}
+
+size_t Print::println(unsigned int aNumber, int aBase) {
+  const size_t length = this->print(aNumber, aBase);
+  return length + this->println();
+}
+
+size_t Print::println(long aNumber, int aBase) {
+  const size_t length = this->print(aNumber, aBase);
+  return length + this->println();
+}
+
+size_t Print::println(unsigned long aNumber, int aBase) {
+  const size_t length = this->print(aNumber, aBase);
+  return length + this->println();
+}
+
+size_t Print::println(double aNumber, int aDigits) {
+  const size_t length = this->print(aNumber, aDigits);
+  return length + this->println();
+}
+
+size_t Print::println(const Printable &aPrintable) {
+  const size_t length = this->print(aPrintable);
+  return length + this->println();
+}
+
+size_t Print::println() {
+  return this->write("\r\n");
+}
+
+/**
+ * Writes an unsigned number in the
+ * given base, as the core does.
+ *
+ * @param aNumber The number
+ * @param aBase Its base, 2 to 36
+ * @return how many chars were written
+ */
+size_t Print::printNumber(unsigned long aNumber, uint8_t aBase) {
+  char buffer[8 * sizeof(long) + 1];
+  char *digit = &buffer[sizeof(buffer) - 1];
+  *digit = '\0';
+  if (aBase < 2) {
+    aBase = 10;
+  }
+  do {
+    const char value = aNumber % aBase;
+    aNumber /= aBase;
+    *--digit = (value < 10) ? value + '0' : value + 'A' - 10;
+  } while (aNumber > 0);
+  return this->write(digit);
+}
+
+/**
+ * Writes a double with aDigits digits
+ * after the decimal point, as the core
+ * does: rounded, then a digit at a time.
+ *
+ * @param aNumber The number
+ * @param aDigits Digits after the point
+ * @return how many chars were written
+ */
+size_t Print::printFloat(double aNumber, uint8_t aDigits) {
+  if (isnan(aNumber)) {
+    return this->print("nan");
+  }
+  if (isinf(aNumber)) {
+    return this->print("inf");
+  }
+  if ((aNumber > 4294967040.0) || (aNumber < -4294967040.0)) {
+    return this->print("ovf");
+  }
+
+  size_t length = 0;
+  if (aNumber < 0.0) {
+    length += this->print('-');
+    aNumber = -aNumber;
+  }
+
+  double rounding = 0.5;
+  for (uint8_t i = 0; i < aDigits; i++) {
+    rounding /= 10.0;
+  }
+  aNumber += rounding;
+
+  const unsigned long whole = (unsigned long)aNumber;
+  double remainder = aNumber - (double)whole;
+  length += this->print(whole);
+  if (aDigits > 0) {
+    length += this->print('.');
+  }
+  while (aDigits-- > 0) {
+    remainder *= 10.0;
+    const unsigned int digit = (unsigned int)remainder;
+    length += this->print(digit);
+    remainder -= digit;
+  }
+  return length;
+}
+
+/**
+ * Prints the address in dotted form.
+ *
+ * @param aOut Where to print it
+ * @return how many chars were written
+ */
+size_t IPAddress::printTo(Print &aOut) const {
+  size_t length = 0;
+  for (int i = 0; i < 4; i++) {
+    if (i > 0) {
+      length += aOut.print('.');
+    }
+    length += aOut.print(this->bytes[i], DEC);
+  }
+  return length;
+}
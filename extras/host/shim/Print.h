@@ -0,0 +1,86 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef Print_h
+#define Print_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class __FlashStringHelper;
+class Printable;
+
+/**
+ * Print as in the Arduino core: subclasses
+ * write a byte at a time (and, if they can
+ * do better, a buffer at a time), and get
+ * print() and println() for free.
+ */
+class Print
+{
+ public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t aByte) = 0;
+  virtual size_t write(const uint8_t *aBuffer, size_t aSize);
+  size_t write(const char *aString) {
+    return (aString == NULL) ? 0 : this->write((const uint8_t *)aString, strlen(aString));
+  }
+  size_t write(const char *aBuffer, size_t aSize) {
+    return this->write((const uint8_t *)aBuffer, aSize);
+  }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *aString);
+  size_t print(const char aString[]);
+  size_t print(char aChar);
+  size_t print(unsigned char aNumber, int aBase = DEC);
+  size_t print(int aNumber, int aBase = DEC);
+  size_t print(unsigned int aNumber, int aBase = DEC);
+  size_t print(long aNumber, int aBase = DEC);
+  size_t print(unsigned long aNumber, int aBase = DEC);
+  size_t print(double aNumber, int aDigits = 2);
+  size_t print(const Printable &aPrintable);
+
+  size_t println(const __FlashStringHelper *aString);
+  size_t println(const char aString[]);
+  size_t println(char aChar);
+  size_t println(unsigned char aNumber, int aBase = DEC);
+  size_t println(int aNumber, int aBase = DEC);
+  size_t println(unsigned int aNumber, int aBase = DEC);
+  size_t println(long aNumber, int aBase = DEC);
+  size_t println(unsigned long aNumber, int aBase = DEC);
+  size_t println(double aNumber, int aDigits = 2);
+  size_t println(const Printable &aPrintable);
+  size_t println();
+
+ private:
+  size_t printNumber(unsigned long aNumber, uint8_t aBase);
+  size_t printFloat(double aNumber, uint8_t aDigits);
+};
+
+#endif
@@ -0,0 +1,63 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef pgmspace_h
+#define pgmspace_h
+
+// A host has one address space, so "flash"
+// is just memory. Words and dwords are read
+// as 16 and 32 bits, as on the ESP cores
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(aString) (aString)
+
+#define pgm_read_byte(aAddress) (*(const uint8_t *)(aAddress))
+#define pgm_read_word(aAddress) pgm_read_word_host((const void *)(aAddress))
+#define pgm_read_dword(aAddress) pgm_read_dword_host((const void *)(aAddress))
+#define pgm_read_ptr(aAddress) (*(void * const *)(aAddress))
+
+inline uint16_t pgm_read_word_host(const void *aAddress) {
+  uint16_t word;
+  memcpy(&word, aAddress, sizeof(word));
+  return word;
+}
+
+inline uint32_t pgm_read_dword_host(const void *aAddress) {
+  uint32_t dword;
+  memcpy(&dword, aAddress, sizeof(dword));
+  return dword;
+}
+
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcat_P strcat
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+
+#endif
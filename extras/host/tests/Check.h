@@ -0,0 +1,88 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#ifndef Check_h
+#define Check_h
+
+#include <stdio.h>
+#include <string>
+
+// Just enough of a test framework: each test is a program
+// that runs its checks, reports any that fail, and exits
+// with the number of failures
+
+static int checkFailures = 0;
+
+#define CHECK(aCondition) \
+  do { \
+    if (!(aCondition)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #aCondition); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQUAL(aExpected, aActual) \
+  do { \
+    if (!((aExpected) == (aActual))) { \
+      fprintf(stderr, "%s:%d: CHECK_EQUAL(%s, %s) failed: got %s\n", __FILE__, __LINE__, #aExpected, #aActual, \
+              checkString(aActual).c_str()); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_CONTAINS(aString, aPart) \
+  do { \
+    if (std::string(aString).find(aPart) == std::string::npos) { \
+      fprintf(stderr, "%s:%d: CHECK_CONTAINS(%s, %s) failed: got %s\n", __FILE__, __LINE__, #aString, #aPart, \
+              std::string(aString).c_str()); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+inline std::string checkString(const std::string &aValue) { return "\"" + aValue + "\""; }
+inline std::string checkString(const char *aValue) { return (aValue == NULL) ? "NULL" : checkString(std::string(aValue)); }
+inline std::string checkString(long long aValue) { return std::to_string(aValue); }
+inline std::string checkString(unsigned long long aValue) { return std::to_string(aValue); }
+inline std::string checkString(int aValue) { return std::to_string(aValue); }
+inline std::string checkString(unsigned int aValue) { return std::to_string(aValue); }
+inline std::string checkString(long aValue) { return std::to_string(aValue); }
+inline std::string checkString(unsigned long aValue) { return std::to_string(aValue); }
+inline std::string checkString(bool aValue) { return aValue ? "true" : "false"; }
+inline std::string checkString(double aValue) { return std::to_string(aValue); }
+
+// Runs one test function, naming it in any failure
+#define RUN_TEST(aTest) \
+  do { \
+    const int before = checkFailures; \
+    aTest(); \
+    if (checkFailures != before) { \
+      fprintf(stderr, "  in %s\n", #aTest); \
+    } \
+  } while (0)
+
+inline int checkResult() {
+  if (checkFailures > 0) {
+    fprintf(stderr, "%d check(s) failed\n", checkFailures);
+  }
+  return (checkFailures > 0) ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,250 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <cmath>
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+static const char kSummaryStart[] =
+  "{\"schema\":\"iglu:com.snowplowanalytics.snowplow/unstruct_event/jsonschema/1-0-0\","
+  "\"data\":{\"schema\":\"iglu:com.snowplowanalytics.arduino/event_summary/jsonschema/1-0-0\",\"data\":";
+
+// Undoes the tracker's URL-encoding of a querystring value
+static std::string urlDecode(const std::string &aValue) {
+  std::string decoded;
+  for (size_t i = 0; i < aValue.size(); i++) {
+    if ((aValue[i] == '%') && (i + 2 < aValue.size())) {
+      decoded += (char)strtol(aValue.substr(i + 1, 2).c_str(), NULL, 16);
+      i += 2;
+    } else {
+      decoded += aValue[i];
+    }
+  }
+  return decoded;
+}
+
+// The event_summary data a GET carried, or "" if none
+static std::string summaryOf(const MockCollector::Request &aRequest) {
+  const size_t start = aRequest.target.find("&e=ue&ue_pr=");
+  if (start == std::string::npos) {
+    return "";
+  }
+  const std::string json = urlDecode(aRequest.target.substr(start + 12));
+  CHECK_EQUAL(0u, json.find(kSummaryStart));
+  CHECK_EQUAL(json.size() - 2, json.rfind("}}"));
+  return json.substr(sizeof(kSummaryStart) - 1, json.size() - sizeof(kSummaryStart) - 1);
+}
+
+/*
+ * Values are summed up until their
+ * event's window is over, then sent
+ * as one summary event, whose ue_pr
+ * holds the event's strings and the
+ * statistics of its values.
+ */
+static void testWindow() {
+  MockCollector collector;
+  SnowPlowAggregator aggregator(1000);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAggregator(&aggregator);
+
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("env", "temp", "room", "celsius", 21.5, 2));
+  HostClock::advance(400);
+  tracker.trackStructEvent("env", "temp", "room", "celsius", 19.25, 2);
+  HostClock::advance(400);
+  tracker.trackStructEvent("env", "temp", "room", "celsius", 23.0, 2);
+  HostClock::advance(199);
+  tracker.update();
+  CHECK_EQUAL(0u, collector.getRequests().size());
+
+  HostClock::advance(1);
+  tracker.update();
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  const MockCollector::Request &request = collector.getRequests()[0];
+  CHECK(request.target.find("ev_") == std::string::npos);
+  CHECK_EQUAL(std::string("{\"category\":\"env\",\"action\":\"temp\",\"label\":\"room\",\"property\":\"celsius\","
+                          "\"count\":3,\"min\":19.25,\"max\":23.00,\"mean\":21.25,\"sum\":63.75,\"last\":23.00}"),
+              summaryOf(request));
+
+  // The window is over, so the next value starts a new one
+  tracker.trackStructEvent("env", "temp", "room", "celsius", 7);
+  tracker.update();
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  HostClock::advance(1000);
+  tracker.trackStructEvent("env", "temp", "room", "celsius", 8);
+  CHECK_EQUAL(2u, collector.getRequests().size());
+  CHECK_EQUAL(std::string("{\"category\":\"env\",\"action\":\"temp\",\"label\":\"room\",\"property\":\"celsius\","
+                          "\"count\":1,\"min\":7.00,\"max\":7.00,\"mean\":7.00,\"sum\":7.00,\"last\":7.00}"),
+              summaryOf(collector.getRequests()[1]));
+  CHECK(!aggregator.isEmpty());
+}
+
+/*
+ * flush() sends every summary straight
+ * away; events told apart by their
+ * strings get one each. A label or
+ * property that isn't there is left
+ * out, and strings are escaped.
+ */
+static void testFlush() {
+  MockCollector collector;
+  SnowPlowAggregator aggregator(60000);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAggregator(&aggregator);
+
+  tracker.trackStructEvent("env", "temp", NULL, NULL, 1.5, 1);
+  HostClock::advance(10);
+  tracker.trackStructEvent("env", "hum\"id", "a&b", NULL, -2);
+  tracker.trackStructEvent("env", "temp", NULL, NULL, 2.5, 1);
+  tracker.update();
+  CHECK_EQUAL(0u, collector.getRequests().size());
+
+  tracker.flush();
+  CHECK(aggregator.isEmpty());
+  CHECK_EQUAL(2u, collector.getRequests().size());
+  // Oldest first
+  CHECK_EQUAL(std::string("{\"category\":\"env\",\"action\":\"temp\","
+                          "\"count\":2,\"min\":1.5,\"max\":2.5,\"mean\":2.0,\"sum\":4.0,\"last\":2.5}"),
+              summaryOf(collector.getRequests()[0]));
+  CHECK_EQUAL(std::string("{\"category\":\"env\",\"action\":\"hum\\\"id\",\"label\":\"a&b\","
+                          "\"count\":1,\"min\":-2.00,\"max\":-2.00,\"mean\":-2.00,\"sum\":-2.00,\"last\":-2.00}"),
+              summaryOf(collector.getRequests()[1]));
+}
+
+/*
+ * With every slot in use, a new event
+ * sends the oldest summary early to
+ * make room.
+ */
+static void testSlotsFull() {
+  MockCollector collector;
+  SnowPlowAggregator aggregator(60000);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAggregator(&aggregator);
+
+  static const char *const kActions[] = { "a0", "a1", "a2", "a3", "a4" };
+  for (size_t i = 0; i < SNOWPLOW_AGGREGATE_SLOTS; i++) {
+    tracker.trackStructEvent("cat", kActions[i], NULL, NULL, (int)i);
+    HostClock::advance(1);
+  }
+  CHECK_EQUAL(0u, collector.getRequests().size());
+  tracker.trackStructEvent("cat", kActions[SNOWPLOW_AGGREGATE_SLOTS], NULL, NULL, 9);
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  CHECK_CONTAINS(summaryOf(collector.getRequests()[0]), "{\"category\":\"cat\",\"action\":\"a0\",\"count\":1,");
+}
+
+/*
+ * A summary whose strings leave no
+ * room for its statistics is dropped
+ * and counted as failed, rather than
+ * sent cut short.
+ */
+static void testTooLarge() {
+  MockCollector collector;
+  SnowPlowAggregator aggregator(1000);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAggregator(&aggregator);
+
+  const std::string label(100, 'l');
+  const std::string property(100, 'p');
+  tracker.trackStructEvent("cat", "act", label.c_str(), property.c_str(), 1);
+  tracker.flush();
+  CHECK_EQUAL(0u, collector.getRequests().size());
+  CHECK_EQUAL(1ul, tracker.getMetrics().getFailed(SnowPlowTracker::ERROR_EVENT_TOO_LARGE));
+  CHECK(aggregator.isEmpty());
+
+  // Long, but with room to spare
+  const std::string shorter(60, 'p');
+  tracker.trackStructEvent("cat", "act", NULL, shorter.c_str(), 1);
+  tracker.flush();
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  CHECK_CONTAINS(summaryOf(collector.getRequests()[0]), "\"property\":\"" + shorter + "\",\"count\":1,");
+}
+
+/*
+ * A NaN or infinite value is sent on
+ * its own, without its value, rather
+ * than spoil the statistics; a sum
+ * that overflows goes out as null.
+ */
+static void testNotNumbers() {
+  MockCollector collector;
+  SnowPlowAggregator aggregator(1000);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAggregator(&aggregator);
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, NAN, 2);
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  CHECK_CONTAINS(collector.getRequests()[0].target, "&e=se&ev_ca=cat&ev_ac=act");
+  CHECK(collector.getRequests()[0].target.find("ev_va") == std::string::npos);
+  CHECK(aggregator.isEmpty());
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 1e308, 0);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 1e308, 0);
+  tracker.flush();
+  CHECK_EQUAL(2u, collector.getRequests().size());
+  CHECK_EQUAL(std::string("{\"category\":\"cat\",\"action\":\"act\","
+                          "\"count\":2,\"min\":1e308,\"max\":1e308,\"mean\":null,\"sum\":null,\"last\":1e308}"),
+              summaryOf(collector.getRequests()[1]));
+}
+
+/*
+ * In a batch the summary's ue_pr is a
+ * JSON string like any other value.
+ */
+static void testBatch() {
+  MockCollector collector;
+  SnowPlowAggregator aggregator(1000);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setBatching(2);
+  tracker.setAggregator(&aggregator);
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 3);
+  tracker.trackStructEvent("cat", "other");
+  tracker.flush();
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  const std::string &body = collector.getRequests()[0].body;
+  CHECK_CONTAINS(body, "\"e\":\"se\",\"ev_ca\":\"cat\",\"ev_ac\":\"other\"}");
+  CHECK_CONTAINS(body, ",\"e\":\"ue\",\"ue_pr\":\"{\\\"schema\\\":\\\"iglu:com.snowplowanalytics.snowplow/unstruct_event/jsonschema/1-0-0\\\",");
+  CHECK_CONTAINS(body, "\\\"data\\\":{\\\"category\\\":\\\"cat\\\",\\\"action\\\":\\\"act\\\",\\\"count\\\":1,"
+                       "\\\"min\\\":3.00,\\\"max\\\":3.00,\\\"mean\\\":3.00,\\\"sum\\\":3.00,\\\"last\\\":3.00}}}\"}");
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testWindow);
+  RUN_TEST(testFlush);
+  RUN_TEST(testSlotsFull);
+  RUN_TEST(testTooLarge);
+  RUN_TEST(testNotNumbers);
+  RUN_TEST(testBatch);
+  return checkResult();
+}
@@ -0,0 +1,135 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SnowPlowTracker.h>
+#include "HeapCounter.h"
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+// Checks that sending events never touches the heap.
+//
+// This only covers the send path: tracking events and
+// sending them, blocking, async and batched. Setting the
+// tracker up does allocate, and isn't counted: initUrl(),
+// setUserId(), setKeepAlive() and setBatching() malloc()
+// the encoded context and headers in encodeRequestParts(),
+// init() news the EthernetClient, and setCompression() the
+// SnowPlowCompressor. The shim's networking doesn't count
+// either (see HeapCounter.h)
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+static const int kEvents = 200;
+static const SnowPlowTracker::Event<double, 1> kEvent("cat", "typed", "label", "property");
+
+static void trackEvents(SnowPlowTracker &aTracker) {
+  for (int i = 0; i < kEvents; i++) {
+    switch (i % 5) {
+      case 0: aTracker.trackStructEvent("cat", "act"); break;
+      case 1: aTracker.trackStructEvent("cat", "act", "label", "property", i); break;
+      case 2: aTracker.trackStructEvent("cat", "act", "label", NULL, i * 0.5, 1); break;
+      case 3: aTracker.trackStructEvent("cat", "act", NULL, "property", i * 0.5f, 3); break;
+      case 4: aTracker.trackEvent(kEvent, i * 0.5); break;
+    }
+    // Send it (or, batching, just let the batch fill up)
+    for (int j = 0; (j < 10) && aTracker.isBusy(); j++) {
+      aTracker.update();
+    }
+  }
+  aTracker.flush();
+  for (int i = 0; (i < 1000) && aTracker.isBusy(); i++) {
+    aTracker.update();
+  }
+}
+
+// Runs kEvents through a tracker set up by aSetUp, and
+// returns how many heap allocations sending them made
+static unsigned long countAllocations(void (*aSetUp)(SnowPlowTracker &), const bool aKeepAlive) {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setUserId("test-user");
+  tracker.setKeepAlive(aKeepAlive);
+  aSetUp(tracker);
+
+  HeapCounter::reset();
+  trackEvents(tracker);
+  const unsigned long allocations = HeapCounter::getAllocations();
+
+  CHECK(collector.getRequests().size() > 0);
+  CHECK_EQUAL((unsigned long)kEvents, tracker.getMetrics().sent);
+  return allocations;
+}
+
+static void blocking(SnowPlowTracker &aTracker) {
+}
+
+static void async(SnowPlowTracker &aTracker) {
+  aTracker.setAsync(true);
+}
+
+static void batched(SnowPlowTracker &aTracker) {
+  aTracker.setAsync(true);
+  aTracker.setBatching(4);
+}
+
+static void compressed(SnowPlowTracker &aTracker) {
+  batched(aTracker);
+  aTracker.setCompression(true);
+}
+
+static void testBlocking() {
+  CHECK_EQUAL(0ul, countAllocations(blocking, false));
+  CHECK_EQUAL(0ul, countAllocations(blocking, true));
+}
+
+static void testAsync() {
+  CHECK_EQUAL(0ul, countAllocations(async, false));
+  CHECK_EQUAL(0ul, countAllocations(async, true));
+}
+
+static void testBatched() {
+  CHECK_EQUAL(0ul, countAllocations(batched, false));
+  CHECK_EQUAL(0ul, countAllocations(batched, true));
+  CHECK_EQUAL(0ul, countAllocations(compressed, true));
+}
+
+/*
+ * Check the counting itself works.
+ */
+static void testCounter() {
+  HeapCounter::reset();
+  // volatile, so the compiler can't leave them out
+  void *volatile block = malloc(16);
+  free(block);
+  int *volatile value = new int(1);
+  delete value;
+  CHECK_EQUAL(2ul, HeapCounter::getAllocations());
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testCounter);
+  RUN_TEST(testBlocking);
+  RUN_TEST(testAsync);
+  RUN_TEST(testBatched);
+  return checkResult();
+}
@@ -0,0 +1,189 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <time.h>
+#include <limits.h>
+#include <string>
+#include <SnowPlowTracker.h>
+#include <SnowPlowClock.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// Collects what's printed to it
+class StringPrint : public Print
+{
+ public:
+  virtual size_t write(uint8_t aChar) {
+    this->text += (char)aChar;
+    return 1;
+  }
+  using Print::write;
+  std::string text;
+};
+
+// Feeds a Date header's value through the parser, read at aAt
+static bool parse(SnowPlowClock &aClock, const char *aDate, const unsigned long aAt) {
+  aClock.startDate();
+  for (const char *c = aDate; *c != '\0'; c++) {
+    aClock.parseDate(*c);
+  }
+  return aClock.endDate(aAt);
+}
+
+/*
+ * Dates from 1970 on parse to the same
+ * Unix time as timegm() gives, taken
+ * to be half way through the second.
+ */
+static void testParseDate() {
+  randomSeed(7);
+  int mismatches = 0;
+  for (int i = 0; i < 20000; i++) {
+    // Up to 2100, and including the edges
+    time_t time = (i == 0) ? 0 : (i == 1) ? 951782400 : (time_t)random(4102444800L);
+    char date[40];
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", gmtime(&time));
+
+    SnowPlowClock clock;
+    if (!parse(clock, date, 100000) || (clock.getUnixTime(99500, 100000) != (unsigned long)time)) {
+      if (mismatches++ < 5) {
+        fprintf(stderr, "%s parsed as %lu\n", date, clock.getUnixTime(99500, 100000));
+      }
+    }
+  }
+  CHECK_EQUAL(0, mismatches);
+}
+
+/*
+ * Dates that don't make sense leave
+ * the clock as it was.
+ */
+static void testBadDates() {
+  const char *bad[] = {
+    "",
+    "garbage",
+    "Sun, 06 Nov 1994",
+    "Sun, 06 Nov 1994 08:49",
+    "Sun, 06 Foo 1994 08:49:37 GMT",
+    "Sun, 32 Nov 1994 08:49:37 GMT",
+    "Sun, 00 Nov 1994 08:49:37 GMT",
+    "Sun, 06 Nov 1969 08:49:37 GMT",
+    "Sun, 06 Nov 1994 24:49:37 GMT",
+    "Sun, 06 Nov 1994 08:60:37 GMT",
+    "Sun, 06 Nov 1994 08:49:61 GMT",
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    SnowPlowClock clock;
+    CHECK(!parse(clock, bad[i], 1000));
+    CHECK(!clock.isSet());
+  }
+
+  // A leap second is fine
+  SnowPlowClock clock;
+  CHECK(parse(clock, "Sat, 31 Dec 2016 23:59:60 GMT", 1000));
+}
+
+/*
+ * An exact time from set() wins over
+ * any Date header, before or after.
+ */
+static void testSetWins() {
+  SnowPlowClock clock;
+  CHECK(!clock.isSet());
+  CHECK(clock.wantsDate());
+  CHECK(parse(clock, "Sun, 06 Nov 1994 08:49:37 GMT", 1500));
+  CHECK(clock.isSet());
+  CHECK(clock.wantsDate());
+  CHECK_EQUAL(784111777ul, clock.getUnixTime(1000, 1500));
+
+  clock.set(1381316400, 2000);
+  CHECK(!clock.wantsDate());
+  CHECK(parse(clock, "Sun, 06 Nov 1994 08:49:37 GMT", 3000));
+  CHECK_EQUAL(1381316401ul, clock.getUnixTime(3000, 3000));
+}
+
+/*
+ * Times print as ms since 1970 (or
+ * boot), and come out right across
+ * millis() rolling over.
+ */
+static void testPrintTime() {
+  SnowPlowClock clock;
+  StringPrint unset;
+  clock.printTime(unset, 1234, 5000);
+  CHECK_EQUAL(std::string("1234"), unset.text);
+
+  // Set 4s before millis() rolls over; the event is 1.5s after, sent 10s after
+  clock.set(1381316400, ULONG_MAX - 3999);
+  StringPrint created;
+  clock.printTime(created, ULONG_MAX - 2499, 10000);
+  CHECK_EQUAL(std::string("1381316401500"), created.text);
+  StringPrint sent;
+  clock.printTime(sent, 10000, 10000);
+  CHECK_EQUAL(std::string("1381316414000"), sent.text);
+  CHECK_EQUAL(1381316401ul, clock.getUnixTime(ULONG_MAX - 2499, 10000));
+
+  // Leading zeros in the ms
+  StringPrint zeros;
+  clock.printTime(zeros, ULONG_MAX - 3999 + 7, 10000);
+  CHECK_EQUAL(std::string("1381316400007"), zeros.text);
+}
+
+/*
+ * The tracker sets its clock from the
+ * collector's Date header, then dates
+ * events by when they were tracked,
+ * however long they wait to be sent.
+ */
+static void testTrackerDates() {
+  HostClock::useVirtualTime(1000);
+  MockCollector collector;
+  collector.setResponse("HTTP/1.1 200 OK\r\nDate: Wed, 09 Oct 2013 11:00:00 GMT\r\nContent-Length: 0\r\n\r\n");
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+
+  // Before the first response, times count from boot
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_CONTAINS(collector.getRequests()[0].target, "&dtm=1000&stm=1000&");
+  CHECK_EQUAL(1381316400ul, tracker.getUnixTime());
+
+  tracker.setAsync(true);
+  HostClock::advance(10000);
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  HostClock::advance(50000);
+  for (int i = 0; (i < 10) && tracker.isBusy(); i++) {
+    tracker.update();
+  }
+  CHECK_EQUAL(2u, collector.getRequests().size());
+  CHECK_CONTAINS(collector.getRequests()[1].target, "&dtm=1381316410500&stm=1381316460500&");
+}
+
+int main() {
+  RUN_TEST(testParseDate);
+  RUN_TEST(testBadDates);
+  RUN_TEST(testSetWins);
+  RUN_TEST(testPrintTime);
+  RUN_TEST(testTrackerDates);
+  return checkResult();
+}
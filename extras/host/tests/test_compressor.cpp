@@ -0,0 +1,146 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SnowPlowCompressor.h>
+#include <SnowPlowTracker.h>
+#include "Gzip.h"
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+// SnowPlowCompressor's output, inflated again by zlib
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+static std::string compress(const std::string &aData) {
+  static SnowPlowCompressor compressor;
+  StringPrint out;
+  compressor.begin(out);
+  compressor.write((const uint8_t *)aData.data(), aData.size());
+  compressor.end();
+  return out.data;
+}
+
+static void checkRoundTrip(const std::string &aData) {
+  const std::string compressed = compress(aData);
+  std::string inflated;
+  CHECK(gunzip(compressed, inflated));
+  if (inflated != aData) {
+    fprintf(stderr, "Round trip of %zu bytes failed\n", aData.size());
+    checkFailures++;
+  }
+}
+
+static std::string randomBytes(const size_t aLength, unsigned long aSeed) {
+  std::string data;
+  for (size_t i = 0; i < aLength; i++) {
+    aSeed = aSeed * 6364136223846793005UL + 1442695040888963407UL;
+    data += (char)(aSeed >> 56);
+  }
+  return data;
+}
+
+static void testEdgeCases() {
+  checkRoundTrip("");
+  checkRoundTrip("a");
+  checkRoundTrip("ab");
+  checkRoundTrip("abc");
+  checkRoundTrip("abcabcabcabc");
+  checkRoundTrip(std::string(1, '\0'));
+}
+
+static void testRuns() {
+  // Runs longer than the longest match, and than the window
+  checkRoundTrip(std::string(63, 'x'));
+  checkRoundTrip(std::string(64, 'x'));
+  checkRoundTrip(std::string(65, 'x'));
+  checkRoundTrip(std::string(SNOWPLOW_COMPRESS_WINDOW * 10 + 3, 'x'));
+  checkRoundTrip(std::string(1000, 'x') + std::string(1000, 'y') + std::string(1000, 'x'));
+}
+
+static void testRandom() {
+  // Incompressible, and around window boundaries
+  const size_t lengths[] = { 100, 191, 192, 193, 255, 256, 257, 511, 512, 4096, 100000 };
+  for (size_t i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++) {
+    checkRoundTrip(randomBytes(lengths[i], i));
+  }
+  // Every byte value, in a repeating pattern that matches at every distance
+  std::string pattern;
+  for (int i = 0; i < 5000; i++) {
+    pattern += (char)((i * i) % 251);
+  }
+  checkRoundTrip(pattern);
+}
+
+static void testBatches() {
+  for (int events = 1; events <= 64; events *= 2) {
+    const std::string batch = sampleBatch(events);
+    checkRoundTrip(batch);
+    if (events >= 8) {
+      // Events only match the one before when the window holds them
+      if (SNOWPLOW_COMPRESS_WINDOW >= 512) {
+        CHECK(compress(batch).size() * 3 < batch.size());
+      } else {
+        CHECK(compress(batch).size() * 4 < batch.size() * 3);
+      }
+    }
+  }
+}
+
+/*
+ * A tracker's compressed batch POST
+ * inflates to the JSON it'd send
+ * uncompressed.
+ */
+static void testTrackerBody() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setBatching(4);
+  tracker.setCompression(true);
+
+  for (int i = 0; i < 4; i++) {
+    tracker.trackStructEvent("sensor", "temperature", "room", NULL, 20.5 + i, 1);
+  }
+  for (int i = 0; (i < 100) && tracker.isBusy(); i++) {
+    tracker.update();
+  }
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  const MockCollector::Request &request = collector.getRequests()[0];
+  CHECK_EQUAL(std::string("gzip"), MockCollector::getHeader(request, "content-encoding"));
+  CHECK_EQUAL(std::to_string(request.body.size()), MockCollector::getHeader(request, "content-length"));
+
+  std::string body;
+  CHECK(gunzip(request.body, body));
+  CHECK_EQUAL(0u, body.find("{\"schema\":\"iglu:com.snowplowanalytics.snowplow/payload_data/jsonschema/1-0-4\",\"data\":[{"));
+  CHECK_CONTAINS(body, "\"ev_la\":\"room\",\"ev_va\":\"23.5\"}]}");
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testEdgeCases);
+  RUN_TEST(testRuns);
+  RUN_TEST(testRandom);
+  RUN_TEST(testBatches);
+  RUN_TEST(testTrackerBody);
+  return checkResult();
+}
@@ -0,0 +1,151 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+// How often the tracker looks the collector's hostname up, counted
+// by MockCollector
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+static void init(SnowPlowTracker &aTracker) {
+  aTracker.initUrl("collector.test");
+}
+
+/*
+ * One lookup serves every connection
+ * until the default TTL of 10 minutes
+ * is up.
+ */
+static void testCacheHits() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+
+  for (int i = 0; i < 3; i++) {
+    CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+    HostClock::advance(60*1000UL);
+  }
+  CHECK_EQUAL(3ul, collector.getConnections());
+  CHECK_EQUAL(1ul, collector.getLookups());
+
+  HostClock::advance(10*60*1000UL);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+}
+
+/*
+ * setDnsCacheTtl() changes how long
+ * the address is kept, dropping the
+ * one we have; 0 looks it up for
+ * every connection.
+ */
+static void testTtl() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(1ul, collector.getLookups());
+
+  tracker.setDnsCacheTtl(1000);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+  HostClock::advance(999);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+  HostClock::advance(1);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(3ul, collector.getLookups());
+
+  tracker.setDnsCacheTtl(0);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(5ul, collector.getLookups());
+}
+
+/*
+ * When the cached address refuses us
+ * we look the hostname up again,
+ * and if it's moved, connect to where
+ * it's gone within the same send.
+ */
+static void testMoved() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(1ul, collector.getLookups());
+
+  collector.setAddress(IPAddress(127, 0, 0, 2));
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+  CHECK_EQUAL(2ul, collector.getConnections());
+  CHECK_EQUAL(2u, collector.getRequests().size());
+
+  // The new address is cached in turn
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+}
+
+/*
+ * A refused connection still looks
+ * the hostname up again, but when the
+ * address is the same there's no point
+ * retrying it. Nor is a failed lookup
+ * cached.
+ */
+static void testConnectFailed() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+
+  collector.setRefusing(true);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+  collector.setRefusing(false);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(2ul, collector.getLookups());
+
+  collector.setResolving(false);
+  tracker.setDnsCacheTtl(0);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(3ul, collector.getLookups());
+  collector.setResolving(true);
+  tracker.setDnsCacheTtl(1000);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(4ul, collector.getLookups());
+  CHECK_EQUAL(3u, collector.getRequests().size());
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testCacheHits);
+  RUN_TEST(testTtl);
+  RUN_TEST(testMoved);
+  RUN_TEST(testConnectFailed);
+  return checkResult();
+}
@@ -0,0 +1,188 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <vector>
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// What the tracker asked of the network, and when
+static std::vector<std::pair<unsigned long, bool> > powerCalls;
+
+static void power(const bool aOn) {
+  powerCalls.push_back(std::make_pair(millis(), aOn));
+}
+
+/*
+ * Calls update() a ms of virtual time
+ * at a time for aMs ms, noting the time
+ * each request reaches the collector.
+ */
+static std::vector<unsigned long> run(SnowPlowTracker &aTracker, const MockCollector &aCollector, const unsigned long aMs) {
+  std::vector<unsigned long> times;
+  for (unsigned long i = 0; i < aMs; i++) {
+    const size_t before = aCollector.getRequests().size();
+    aTracker.update();
+    if (aCollector.getRequests().size() > before) {
+      times.push_back(millis());
+    }
+    HostClock::advance(1);
+  }
+  return times;
+}
+
+/*
+ * A burst starts once aMaxEvents events
+ * are queued: the network is powered
+ * up, everything waiting is sent and
+ * it's powered down again.
+ */
+static void testMaxEvents() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setDutyCycle(power, 3, 0);
+  powerCalls.clear();
+  const unsigned long start = millis();
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 1);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 2);
+  run(tracker, collector, 100000);
+  CHECK_EQUAL(0u, collector.getRequests().size());
+  CHECK(powerCalls.empty());
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 3);
+  run(tracker, collector, 100);
+  CHECK_EQUAL(3u, collector.getRequests().size());
+  CHECK_EQUAL(2u, powerCalls.size());
+  if (powerCalls.size() == 2) {
+    CHECK(powerCalls[0].second);
+    CHECK_EQUAL(start + 100000, powerCalls[0].first);
+    CHECK(!powerCalls[1].second);
+  }
+  CHECK_EQUAL(1ul, tracker.getMetrics().wakes);
+  CHECK(!tracker.isBusy());
+}
+
+/*
+ * By default, or with no limit set on
+ * either the count or the age, events
+ * still go out after kDutyCycleMaxAge
+ * rather than wait for flush().
+ */
+static void testDefaultAge() {
+  for (int limits = 0; limits < 2; limits++) {
+    MockCollector collector;
+    SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+    tracker.initUrl("collector.test");
+    tracker.setAsync(true);
+    if (limits == 0) {
+      tracker.setDutyCycle(power);
+    } else {
+      tracker.setDutyCycle(power, 0, 0);
+    }
+    powerCalls.clear();
+    const unsigned long start = millis();
+
+    tracker.trackStructEvent("cat", "act");
+    HostClock::advance(SnowPlowTracker::kDutyCycleMaxAge / 2);
+    tracker.trackStructEvent("cat", "act");
+    const std::vector<unsigned long> times = run(tracker, collector, SnowPlowTracker::kDutyCycleMaxAge);
+    CHECK_EQUAL(2u, times.size());
+    if (times.size() == 2) {
+      CHECK_EQUAL(start + SnowPlowTracker::kDutyCycleMaxAge, times[0]);
+    }
+    CHECK_EQUAL(2u, powerCalls.size());
+  }
+}
+
+/*
+ * A high priority event starts a burst
+ * straight away, taking the normal
+ * events waiting with it.
+ */
+static void testHighPriority() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setDutyCycle(power, 10, 60000);
+  powerCalls.clear();
+
+  tracker.trackStructEvent("cat", "routine");
+  run(tracker, collector, 100);
+  CHECK_EQUAL(0u, collector.getRequests().size());
+  tracker.setPriority(SnowPlowTracker::eHighPriority);
+  tracker.trackStructEvent("cat", "alarm");
+  tracker.setPriority(SnowPlowTracker::eNormalPriority);
+  run(tracker, collector, 10);
+  CHECK_EQUAL(2u, collector.getRequests().size());
+  if (collector.getRequests().size() == 2) {
+    CHECK_CONTAINS(collector.getRequests()[0].target, "&ev_ac=alarm");
+    CHECK_CONTAINS(collector.getRequests()[1].target, "&ev_ac=routine");
+  }
+  CHECK_EQUAL(2u, powerCalls.size());
+}
+
+/*
+ * Events left waiting after a batch is
+ * sent are aged from when they were
+ * tracked, not from when that batch
+ * finished.
+ */
+static void testAgeFromOldest() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setBatching(2, 1000);
+  const unsigned long start = millis();
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 1);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 2);
+  tracker.update(); // Sends the batch
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  HostClock::advance(100);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 3);
+  HostClock::advance(800);
+  tracker.update(); // Reads the batch's response
+  CHECK_EQUAL(1u, tracker.getQueuedEvents());
+
+  const std::vector<unsigned long> times = run(tracker, collector, 2000);
+  CHECK_EQUAL(1u, times.size());
+  if (times.size() == 1) {
+    CHECK_EQUAL(start + 1100, times[0]);
+  }
+  CHECK_CONTAINS(collector.getRequests()[1].body, "\"ev_va\":\"3.0\"}]}");
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testMaxEvents);
+  RUN_TEST(testDefaultAge);
+  RUN_TEST(testHighPriority);
+  RUN_TEST(testAgeFromOldest);
+  return checkResult();
+}
@@ -0,0 +1,135 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <thread>
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+static const char kCategory[] = "isr";
+static const char kAction[] = "tick";
+
+/*
+ * The ring holds one less than its
+ * size, first in first out, and counts
+ * what it has to turn away.
+ */
+static void testRing() {
+  HostClock::useVirtualTime(1234);
+  SnowPlowInterruptQueue queue;
+  CHECK(queue.isEmpty());
+  for (int i = 0; i < SNOWPLOW_INTERRUPT_QUEUE_SIZE - 1; i++) {
+    CHECK(queue.push(kCategory, kAction, NULL, NULL, i));
+  }
+  CHECK(!queue.push(kCategory, kAction));
+  CHECK_EQUAL(1u, queue.getDroppedEvents());
+
+  SnowPlowInterruptQueue::Entry entry;
+  for (int i = 0; i < SNOWPLOW_INTERRUPT_QUEUE_SIZE - 1; i++) {
+    CHECK(queue.pop(entry));
+    CHECK_EQUAL(i, entry.intValue);
+    CHECK_EQUAL(1234ul, entry.created);
+  }
+  CHECK(!queue.pop(entry));
+  CHECK(queue.isEmpty());
+
+  // And round again, past the end of the entries
+  CHECK(queue.push(kCategory, kAction, "label", NULL, 2.5, 1));
+  CHECK(queue.pop(entry));
+  CHECK_EQUAL((int)SnowPlowInterruptQueue::eDoubleValue, (int)entry.valueType);
+  CHECK_EQUAL(2.5, entry.doubleValue);
+  CHECK_EQUAL(std::string("label"), std::string(entry.label));
+}
+
+/*
+ * With the producer on a thread (a
+ * core) of its own, every entry the
+ * consumer pops is whole and in order.
+ */
+static void testThreads() {
+  HostClock::useVirtualTime(1234);
+  static const int kEvents = 100000;
+  SnowPlowInterruptQueue queue;
+
+  std::thread producer([&queue]() {
+    for (int i = 0; i < kEvents; i++) {
+      if (i % 2 == 0) {
+        while (!queue.push(kCategory, kAction, NULL, NULL, i)) {
+          std::this_thread::yield();
+        }
+      } else {
+        while (!queue.push(kCategory, kAction, kCategory, NULL, (double)i, 3)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  });
+
+  int popped = 0;
+  int wrong = 0;
+  SnowPlowInterruptQueue::Entry entry;
+  while (popped < kEvents) {
+    if (!queue.pop(entry)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const bool isInt = (popped % 2 == 0);
+    if ((entry.category != kCategory) || (entry.action != kAction) || (entry.created != 1234) ||
+        (entry.valueType != (isInt ? SnowPlowInterruptQueue::eIntValue : SnowPlowInterruptQueue::eDoubleValue)) ||
+        (isInt ? (entry.intValue != popped) : ((entry.doubleValue != popped) || (entry.label != kCategory) || (entry.valuePrecision != 3)))) {
+      wrong++;
+    }
+    popped++;
+  }
+  producer.join();
+  CHECK_EQUAL(0, wrong);
+  CHECK(queue.isEmpty());
+}
+
+/*
+ * update() picks events up and sends
+ * them as if tracked from loop().
+ */
+static void testTracker() {
+  HostClock::useVirtualTime(1234);
+  MockCollector collector;
+  SnowPlowInterruptQueue queue;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setInterruptQueue(&queue);
+
+  CHECK(queue.push(kCategory, kAction, NULL, NULL, 7));
+  tracker.update();
+  CHECK(queue.isEmpty());
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  if (collector.getRequests().size() == 1) {
+    CHECK_CONTAINS(collector.getRequests()[0].target, "&e=se&ev_ca=isr&ev_ac=tick&ev_va=7.0");
+  }
+}
+
+int main() {
+  RUN_TEST(testRing);
+  RUN_TEST(testThreads);
+  RUN_TEST(testTracker);
+  return checkResult();
+}
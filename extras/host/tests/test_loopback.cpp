@@ -0,0 +1,172 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "LoopbackCollector.h"
+#include "Check.h"
+
+// End to end through real sockets: each tracker connects
+// to a LoopbackCollector over the host's TCP stack
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+static void init(SnowPlowTracker &aTracker, const LoopbackCollector &aCollector) {
+  aTracker.initUrl("localhost", aCollector.getPort());
+  aTracker.setClock(1381316400); // So it doesn't wait for the Date
+  aTracker.setResponseTimeout(2000);
+}
+
+/*
+ * One event, start to finish.
+ */
+static void testRequest() {
+  LoopbackCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker, collector);
+
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act", "lab", "prop", 42));
+  const std::vector<MockCollector::Request> requests = collector.getRequests();
+  CHECK_EQUAL(1u, requests.size());
+  CHECK_EQUAL(1ul, collector.getConnections());
+  CHECK_EQUAL(std::string("GET"), requests[0].method);
+  CHECK_CONTAINS(requests[0].target, "&e=se&ev_ca=cat&ev_ac=act&ev_la=lab&ev_pr=prop&ev_va=42.0");
+  CHECK_EQUAL("localhost:" + std::to_string(collector.getPort()), MockCollector::getHeader(requests[0], "host"));
+}
+
+/*
+ * With keep-alive, one connection
+ * carries every request.
+ */
+static void testKeepAlive() {
+  LoopbackCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker, collector);
+  tracker.setKeepAlive(true);
+
+  for (int i = 0; i < 5; i++) {
+    CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+  }
+  CHECK_EQUAL(5u, collector.getRequests().size());
+  CHECK_EQUAL(1ul, collector.getConnections());
+}
+
+/*
+ * A slow collector is waited for, up
+ * to the response timeout.
+ */
+static void testLatency() {
+  LoopbackCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker, collector);
+
+  collector.setLatency(100);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+
+  tracker.setResponseTimeout(30);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_TIMED_OUT, tracker.trackStructEvent("cat", "act"));
+}
+
+/*
+ * A response dribbled out a byte at a
+ * time still reads right, the timeout
+ * restarting with each byte.
+ */
+static void testSlowResponse() {
+  LoopbackCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker, collector);
+  tracker.setKeepAlive(true);
+  tracker.setResponseTimeout(50);
+
+  collector.setChunking(1, 5);
+  collector.setResponse("HTTP/1.1 200 OK\r\nContent-Length: 2\r\nDate: Wed, 09 Oct 2013 11:00:00 GMT\r\n\r\nok");
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(1ul, collector.getConnections());
+}
+
+/*
+ * Informational (1xx) responses are
+ * skipped over.
+ */
+static void testInformational() {
+  LoopbackCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker, collector);
+
+  collector.queueResponse("HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 102 Processing\r\nX-Why: testing\r\n\r\n"
+                          "HTTP/1.1 204 No Content\r\n\r\n");
+  CHECK_EQUAL(204, tracker.trackStructEvent("cat", "act"));
+}
+
+/*
+ * Malformed status lines fail straight
+ * away, rather than at the timeout.
+ */
+static void testMalformedStatus() {
+  LoopbackCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker, collector);
+  tracker.setResponseTimeout(10000);
+
+  const char *const malformed[] = {
+    "HTTP/1.1 2OO OK\r\n\r\n",
+    "HTTP/1.1 20 OK\r\n\r\n",
+    "HTTP/1.1 \r\n\r\n",
+    "HTTX/1.1 200 OK\r\n\r\n",
+    "<html>\r\n\r\n"
+  };
+  for (size_t i = 0; i < sizeof(malformed)/sizeof(malformed[0]); i++) {
+    collector.queueResponse(malformed[i]);
+    const unsigned long start = millis();
+    CHECK_EQUAL(SnowPlowTracker::ERROR_INVALID_RESPONSE, tracker.trackStructEvent("cat", "act"));
+    CHECK(millis() - start < 1000);
+  }
+}
+
+/*
+ * With nothing listening, the
+ * connection is refused.
+ */
+static void testRefused() {
+  uint16_t port;
+  {
+    LoopbackCollector closed;
+    port = closed.getPort();
+  }
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("localhost", port);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act"));
+}
+
+int main() {
+  // The collector runs in real time, so we do too
+  HostClock::useRealTime();
+  RUN_TEST(testRefused);
+  RUN_TEST(testRequest);
+  RUN_TEST(testKeepAlive);
+  RUN_TEST(testLatency);
+  RUN_TEST(testSlowResponse);
+  RUN_TEST(testInformational);
+  RUN_TEST(testMalformedStatus);
+  return checkResult();
+}
@@ -0,0 +1,224 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <SnowPlowNumber.h>
+#include "Check.h"
+
+// SnowPlowNumber against tables of expected strings, and
+// against printf() (which the shim's dtostrf() uses)
+
+typedef struct {
+  long value;
+  const char *expected;
+} IntCase;
+
+typedef struct {
+  double value;
+  byte precision;
+  const char *expected;
+} DoubleCase;
+
+static std::string formatInt(const long aValue) {
+  char buffer[SnowPlowNumber::kMaxLength];
+  const size_t length = SnowPlowNumber::formatInt(buffer, aValue);
+  CHECK_EQUAL(strlen(buffer), length);
+  return buffer;
+}
+
+static std::string formatDouble(const double aValue, const byte aPrecision) {
+  char buffer[SnowPlowNumber::kMaxLength];
+  const size_t length = SnowPlowNumber::formatDouble(buffer, aValue, aPrecision);
+  CHECK_EQUAL(strlen(buffer), length);
+  return buffer;
+}
+
+static std::string printfLong(const long aValue) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%ld", aValue);
+  return buffer;
+}
+
+static std::string printfDouble(const double aValue, const byte aPrecision) {
+  char buffer[400];
+  dtostrf(aValue, 1, aPrecision, buffer);
+  return buffer;
+}
+
+static void testIntTable() {
+  static const IntCase cases[] = {
+    { 0, "0" },
+    { 1, "1" },
+    { -1, "-1" },
+    { 9, "9" },
+    { 10, "10" },
+    { -10, "-10" },
+    { 1000000, "1000000" },
+    { 32767, "32767" },     // INT_MAX on AVR
+    { -32768, "-32768" },   // INT_MIN on AVR
+    { 2147483647L, "2147483647" },
+    { -2147483647L - 1, "-2147483648" }  // LONG_MIN on AVR, INT_MIN here
+  };
+  for (size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+    CHECK_EQUAL(std::string(cases[i].expected), formatInt(cases[i].value));
+  }
+
+  // This host's own extremes
+  CHECK_EQUAL(printfLong(INT_MIN), formatInt(INT_MIN));
+  CHECK_EQUAL(printfLong(INT_MAX), formatInt(INT_MAX));
+  CHECK_EQUAL(printfLong(LONG_MIN), formatInt(LONG_MIN));
+  CHECK_EQUAL(printfLong(LONG_MAX), formatInt(LONG_MAX));
+  CHECK(formatInt(LONG_MIN).size() < SnowPlowNumber::kMaxLength);
+}
+
+static void testIntsAgainstPrintf() {
+  unsigned long seed = 12345;
+  for (int i = 0; i < 100000; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    // Every magnitude, from 0 to LONG_MAX, either sign
+    const long value = (long)(seed >> (seed % 64));
+    CHECK_EQUAL(printfLong(value), formatInt(value));
+  }
+}
+
+static void testDoubleTable() {
+  static const DoubleCase cases[] = {
+    { 0.0, 2, "0.00" },
+    { 0.0, 0, "0" },
+    { -0.0, 2, "0.00" },        // printf() gives "-0.00"
+    { 1.5, 0, "2" },
+    { 2.5, 0, "3" },            // printf() rounds ties to even: "2"
+    { -2.5, 0, "-3" },
+    { 0.125, 2, "0.13" },       // Likewise "0.12"
+    { -1.25, 1, "-1.3" },
+    { 3.14159, 2, "3.14" },
+    { -3.14159, 4, "-3.1416" },
+    { -0.001, 2, "-0.00" },
+    { 0.5, 9, "0.500000000" },
+    { 1.0 / 3, 12, "0.333333333" }, // Precision is capped at 9
+    // The fraction rounding up carries into the whole part
+    { 9.9996, 3, "10.000" },
+    { 99.996, 2, "100.00" },
+    { 0.9999999, 2, "1.00" },
+    { -9.96, 1, "-10.0" },
+    { 9.995, 2, "9.99" },       // It's 9.99499999... in binary
+    // Very large values
+    { 4294967294.0, 1, "4294967294.0" },
+    { 4294967294.999, 2, "4294967295.00" },
+    // Too big for an unsigned long: exponent form
+    { 4294967295.0, 2, "4.294967295e9" },
+    { 4294967296.0, 0, "4.294967296e9" },
+    { 12345678901.0, 2, "1.23456789e10" }, // 1.2345678901e10 to ten digits
+    { 1e20, 2, "1e20" },
+    { -1e20, 2, "-1e20" },
+    { 1.5e20, 2, "1.5e20" },
+    { 9.9999999999e20, 2, "1e21" },        // Rounding carries into the exponent
+    { 1e300, 0, "1e300" },
+    { DBL_MAX, 2, "1.797693135e308" },
+    { -DBL_MAX, 2, "-1.797693135e308" },
+    { FLT_MAX, 2, "3.402823466e38" },     // As big as it gets on AVR
+    // Very small ones
+    { 1e-10, 9, "0.000000000" },
+    { 5e-10, 9, "0.000000001" },
+    { -1e-300, 2, "-0.00" },
+    // Not numbers: nothing is written
+    { NAN, 2, "" },
+    { INFINITY, 2, "" },
+    { -INFINITY, 2, "" }
+  };
+  for (size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+    const std::string actual = formatDouble(cases[i].value, cases[i].precision);
+    if (actual != cases[i].expected) {
+      fprintf(stderr, "formatDouble(%.17g, %d): expected %s, got %s\n",
+              cases[i].value, cases[i].precision, cases[i].expected, actual.c_str());
+      checkFailures++;
+    }
+  }
+}
+
+// Whether the digits after aPrecision are a tie: 5, then only 0s
+static bool isTie(const double aValue, const byte aPrecision) {
+  const std::string exact = printfDouble(aValue, 60);
+  const size_t next = exact.find('.') + 1 + aPrecision;
+  return (exact[next] == '5') && (exact.find_first_not_of('0', next + 1) == std::string::npos);
+}
+
+static void testDoublesAgainstPrintf() {
+  unsigned long seed = 54321;
+  int compared = 0;
+  for (int i = 0; i < 100000; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    const byte precision = (seed >> 8) % (SnowPlowNumber::kMaxPrecision + 1);
+    const double magnitude = pow(10.0, (double)((seed >> 16) % 15) - 5); // 1e-5 to 1e9
+    const double value = ((seed >> 11) * (1.0 / 9007199254740992.0) - 0.5) * 2 * magnitude;
+    if (isTie(value, precision)) {
+      continue; // We round ties away from zero, printf() to even
+    }
+
+    const std::string expected = printfDouble(value, precision);
+    const std::string actual = formatDouble(value, precision);
+    compared++;
+    if (expected != actual) {
+      fprintf(stderr, "formatDouble(%.17g, %d): printf() gives %s, we give %s\n",
+              value, precision, expected.c_str(), actual.c_str());
+      checkFailures++;
+    }
+  }
+  CHECK(compared > 90000);
+}
+
+/*
+ * Values too big for an unsigned long
+ * read back as what was formatted, to
+ * ten significant digits.
+ */
+static void testLargeDoublesReadBack() {
+  unsigned long seed = 98765;
+  for (int i = 0; i < 100000; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    const double magnitude = pow(10.0, (double)((seed >> 16) % 300) + 10); // 1e10 to 1e309
+    const double value = ((seed >> 11) * (1.0 / 9007199254740992.0) + 0.43) * magnitude;
+    if (isinf(value)) {
+      continue;
+    }
+
+    const std::string actual = formatDouble(value, 2);
+    char *end;
+    const double parsed = strtod(actual.c_str(), &end);
+    if ((*end != '\0') || (fabs(parsed - value) > value * 6e-10) || (actual.find('e') == std::string::npos)) {
+      fprintf(stderr, "formatDouble(%.17g, 2): gave %s\n", value, actual.c_str());
+      checkFailures++;
+    }
+    CHECK(actual.size() < SnowPlowNumber::kMaxLength);
+  }
+}
+
+int main() {
+  RUN_TEST(testIntTable);
+  RUN_TEST(testIntsAgainstPrintf);
+  RUN_TEST(testDoubleTable);
+  RUN_TEST(testDoublesAgainstPrintf);
+  RUN_TEST(testLargeDoublesReadBack);
+  return checkResult();
+}
@@ -0,0 +1,255 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <SnowPlowTracker.h>
+#include <SnowPlowEepromStore.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// Storage that loses power after a given number of writes:
+// every write after that is lost, as if the board went down
+class PowerCutStore : public SnowPlowStore
+{
+ public:
+  PowerCutStore(const size_t aSize) : cells(aSize, 0xFF), writesLeft(-1) {}
+
+  size_t size() const { return this->cells.size(); }
+  byte read(const size_t aAddress) { return this->cells[aAddress]; }
+  void write(const size_t aAddress, const byte aValue) {
+    if (this->writesLeft != 0) {
+      this->cells[aAddress] = aValue;
+      if (this->writesLeft > 0) {
+        this->writesLeft--;
+      }
+    }
+  }
+
+  // Power goes after aWrites more writes, or never if -1
+  void cutAfter(const long aWrites) { this->writesLeft = aWrites; }
+
+  std::vector<byte> cells;
+  long writesLeft;
+};
+
+static std::string event(const int aNumber, const size_t aLength) {
+  std::string data(aLength, (char)('a' + aNumber % 26));
+  data[0] = (char)aNumber;
+  return data;
+}
+
+static bool push(SnowPlowOutbox &aOutbox, const std::string &aData) {
+  return aOutbox.push((const byte*)aData.data(), aData.size());
+}
+
+// What a fresh outbox finds in the store, as after a reboot
+static std::deque<std::string> rescan(SnowPlowStore &aStore, const size_t aBlockSize) {
+  SnowPlowOutbox outbox(&aStore, aBlockSize);
+  outbox.begin();
+  std::deque<std::string> found;
+  byte buffer[256];
+  for (size_t i = 0; i < outbox.count(); i++) {
+    const size_t length = outbox.peek(buffer, sizeof(buffer), i);
+    found.push_back(std::string((const char*)buffer, length));
+  }
+  return found;
+}
+
+/*
+ * Through many rounds of pushes and
+ * pops of every size, wrapping round
+ * the store again and again, a reboot
+ * at any point finds exactly the
+ * events still pending, in order.
+ */
+static void testRescan() {
+  static const size_t kBlockSize = 16;
+  PowerCutStore store(512);
+  SnowPlowOutbox outbox(&store, kBlockSize);
+  outbox.begin();
+  std::deque<std::string> pending;
+
+  randomSeed(42);
+  int mismatches = 0;
+  for (int i = 0; i < 5000; i++) {
+    if ((random(3) > 0) || pending.empty()) {
+      const std::string data = event(i, 1 + random(80));
+      if (push(outbox, data)) {
+        pending.push_back(data);
+      }
+    } else {
+      CHECK(outbox.pop());
+      pending.pop_front();
+    }
+    CHECK_EQUAL(pending.size(), outbox.count());
+
+    if (rescan(store, kBlockSize) != pending) {
+      mismatches++;
+    }
+    if (i % 7 == 0) {
+      // Carry on as the rebooted board would
+      outbox.begin();
+    }
+  }
+  CHECK_EQUAL(0, mismatches);
+}
+
+/*
+ * Power lost part way through a push
+ * leaves either the events there were
+ * or those and the new one: never a
+ * half-written event. Likewise a pop.
+ */
+static void testPowerLoss() {
+  static const size_t kBlockSize = 16;
+  int mismatches = 0;
+  for (int round = 0; round < 40; round++) {
+    PowerCutStore store(256);
+    SnowPlowOutbox outbox(&store, kBlockSize);
+    outbox.begin();
+    std::deque<std::string> pending;
+    for (int i = 0; i < round; i++) {
+      const std::string data = event(i, 5 + (i * 11) % 40);
+      if (!push(outbox, data)) {
+        outbox.pop();
+        pending.pop_front();
+        continue;
+      }
+      pending.push_back(data);
+    }
+
+    const std::vector<byte> before = store.cells;
+    const std::string data = event(round, 30);
+    for (long writes = 0; writes < 40; writes++) {
+      store.cells = before;
+      store.cutAfter(writes);
+      SnowPlowOutbox cut(&store, kBlockSize);
+      cut.begin();
+      const bool pushed = push(cut, data);
+      store.cutAfter(-1);
+
+      std::deque<std::string> after = pending;
+      const std::deque<std::string> found = rescan(store, kBlockSize);
+      if (found != after) {
+        after.push_back(data);
+        if (!pushed || (found != after)) {
+          mismatches++;
+        }
+      }
+    }
+
+    if (!pending.empty()) {
+      store.cells = before;
+      store.cutAfter(0);
+      SnowPlowOutbox cut(&store, kBlockSize);
+      cut.begin();
+      cut.pop();
+      store.cutAfter(-1);
+      CHECK(rescan(store, kBlockSize) == pending);
+    }
+  }
+  CHECK_EQUAL(0, mismatches);
+}
+
+/*
+ * Events the collector couldn't take
+ * are still there after a reboot, and
+ * are sent with the time they were
+ * tracked once it's back.
+ */
+static void testReplayAfterReboot() {
+  HostClock::useVirtualTime(1000);
+  SnowPlowEepromStore store(0, 256);
+  {
+    MockCollector collector;
+    collector.setRefusing(true);
+    SnowPlowOutbox outbox(&store);
+    SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+    tracker.initUrl("collector.test");
+    tracker.setOutbox(&outbox);
+    tracker.setClock(1381316400);
+    for (int i = 0; i < 3; i++) {
+      CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+      HostClock::advance(2000);
+    }
+    CHECK_EQUAL(3u, tracker.getStoredEvents());
+  }
+
+  // Reboot: millis() starts again, and the clock isn't set yet
+  HostClock::useVirtualTime(0);
+  MockCollector collector;
+  SnowPlowOutbox outbox(&store);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setOutbox(&outbox);
+  CHECK_EQUAL(3u, tracker.getStoredEvents());
+
+  tracker.flush();
+  CHECK_EQUAL(0u, tracker.getStoredEvents());
+  CHECK_EQUAL(3u, collector.getRequests().size());
+  for (size_t i = 0; i < collector.getRequests().size(); i++) {
+    const std::string &target = collector.getRequests()[i].target;
+    char expected[64];
+    snprintf(expected, sizeof(expected), "&dtm=%lu000&", 1381316400ul + 2 * i);
+    CHECK_CONTAINS(target, expected);
+    snprintf(expected, sizeof(expected), "&e=se&ev_ca=cat&ev_ac=act&ev_va=%d.0", (int)i);
+    CHECK_CONTAINS(target, expected);
+  }
+  CHECK_EQUAL(0u, rescan(store, 16).size());
+}
+
+/*
+ * On cores that keep EEPROM in flash,
+ * the store commits each change to
+ * the outbox; elsewhere there's
+ * nothing to commit.
+ */
+static void testEepromCommit() {
+  MockCollector collector;
+  collector.setRefusing(true);
+  SnowPlowEepromStore store(512, 256);
+  SnowPlowOutbox outbox(&store);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setOutbox(&outbox);
+
+  const unsigned long before = EEPROM.commits;
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL(1u, tracker.getStoredEvents());
+#if defined(ESP8266) || defined(ESP32)
+  CHECK(EEPROM.commits > before);
+#else
+  CHECK_EQUAL(before, EEPROM.commits);
+#endif
+}
+
+int main() {
+  RUN_TEST(testRescan);
+  RUN_TEST(testPowerLoss);
+  RUN_TEST(testReplayAfterReboot);
+  RUN_TEST(testEepromCommit);
+  return checkResult();
+}
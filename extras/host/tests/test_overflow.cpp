@@ -0,0 +1,237 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <SnowPlowTracker.h>
+#include "HeapCounter.h"
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+// Queues small enough to fill with a few events: the
+// queue holds 4 of the events tracked here, the
+// priority queue 1
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+static const int kQueueEvents = 4;
+static byte queueBuffer[128];
+static byte priorityQueueBuffer[48];
+
+static void init(SnowPlowTracker &aTracker) {
+  aTracker.initUrl("collector.test");
+  aTracker.setQueue(queueBuffer, sizeof(queueBuffer));
+  aTracker.setQueue(priorityQueueBuffer, sizeof(priorityQueueBuffer), SnowPlowTracker::eHighPriority);
+  aTracker.setAsync(true);
+}
+
+static void drain(SnowPlowTracker &aTracker) {
+  for (int i = 0; (i < 1000) && aTracker.isBusy(); i++) {
+    aTracker.update();
+  }
+  CHECK(!aTracker.isBusy());
+}
+
+// The ev_va values the collector was sent, in order
+static std::string sentValues(const MockCollector &aCollector) {
+  std::string values;
+  for (size_t i = 0; i < aCollector.getRequests().size(); i++) {
+    const std::string &target = aCollector.getRequests()[i].target;
+    const size_t value = target.find("&ev_va=");
+    values += (value == std::string::npos) ? std::string("-") : target.substr(value + 7, target.find('.', value) - value - 7);
+    values += " ";
+  }
+  return values;
+}
+
+/*
+ * eDropOldest (the default) makes room
+ * by dropping the oldest events.
+ */
+static void testDropOldest() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+
+  for (int i = 0; i < kQueueEvents + 2; i++) {
+    CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+  }
+  CHECK_EQUAL((size_t)kQueueEvents, tracker.getQueuedEvents());
+  CHECK_EQUAL(2ul, tracker.getDroppedEvents());
+  drain(tracker);
+  CHECK_EQUAL(std::string("2 3 4 5 "), sentValues(collector));
+}
+
+/*
+ * eDropNewest turns new events away.
+ */
+static void testDropNewest() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+  tracker.setOverflowPolicy(SnowPlowTracker::eDropNewest);
+
+  for (int i = 0; i < kQueueEvents + 2; i++) {
+    CHECK_EQUAL((i < kQueueEvents) ? SnowPlowTracker::EVENT_QUEUED : SnowPlowTracker::ERROR_BUSY,
+                tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+  }
+  CHECK_EQUAL(2ul, tracker.getDroppedEvents());
+  drain(tracker);
+  CHECK_EQUAL(std::string("0 1 2 3 "), sentValues(collector));
+}
+
+/*
+ * eBlock sends the oldest events there
+ * and then to make room, dropping none.
+ */
+static void testBlock() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+  tracker.setOverflowPolicy(SnowPlowTracker::eBlock);
+
+  for (int i = 0; i < kQueueEvents + 2; i++) {
+    CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+  }
+  CHECK_EQUAL(std::string("0 1 "), sentValues(collector));
+  CHECK_EQUAL(0ul, tracker.getDroppedEvents());
+  drain(tracker);
+  CHECK_EQUAL(std::string("0 1 2 3 4 5 "), sentValues(collector));
+}
+
+/*
+ * An event too big for even an empty
+ * queue fails straight away, whatever
+ * the policy, without dropping or
+ * sending the events already queued.
+ */
+static void testTooLarge() {
+  // Fits SNOWPLOW_MAX_EVENT_LENGTH, but not the queue
+  const std::string label(110, 'x');
+  const SnowPlowTracker::OverflowPolicy policies[] = {
+    SnowPlowTracker::eDropOldest, SnowPlowTracker::eDropNewest, SnowPlowTracker::eBlock
+  };
+
+  for (size_t i = 0; i < sizeof(policies)/sizeof(policies[0]); i++) {
+    MockCollector collector;
+    SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+    init(tracker);
+    tracker.setOverflowPolicy(policies[i]);
+
+    tracker.trackStructEvent("cat", "act", NULL, NULL, 0);
+    tracker.trackStructEvent("cat", "act", NULL, NULL, 1);
+    CHECK_EQUAL(SnowPlowTracker::ERROR_EVENT_TOO_LARGE, tracker.trackStructEvent("cat", "act", label.c_str()));
+    CHECK_EQUAL(2u, tracker.getQueuedEvents());
+    CHECK_EQUAL(0ul, tracker.getDroppedEvents());
+    CHECK_EQUAL(0u, collector.getRequests().size());
+  }
+}
+
+/*
+ * Likewise for the priority queue,
+ * which is smaller.
+ */
+static void testPriorityTooLarge() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  init(tracker);
+  tracker.setOverflowPolicy(SnowPlowTracker::eDropOldest, SnowPlowTracker::eHighPriority);
+
+  tracker.setPriority(SnowPlowTracker::eHighPriority);
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, 0));
+  CHECK_EQUAL(SnowPlowTracker::ERROR_EVENT_TOO_LARGE, tracker.trackStructEvent("cat", "act", "a label too long for the priority queue"));
+  CHECK_EQUAL(1u, tracker.getQueuedEvents());
+  CHECK_EQUAL(0ul, tracker.getDroppedEvents());
+
+  // But the next that fits takes the oldest's place
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, 1));
+  CHECK_EQUAL(1ul, tracker.getDroppedEvents());
+  drain(tracker);
+  CHECK_EQUAL(std::string("1 "), sentValues(collector));
+}
+
+/*
+ * Queues only take RAM when they're
+ * used: the queue from setAsync(true),
+ * the priority queue from the first
+ * setPriority(eHighPriority), and
+ * neither if the sketch gave them
+ * buffers of its own.
+ */
+static void testQueueBuffers() {
+  MockCollector collector;
+  {
+    HeapCounter::reset();
+    SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+    tracker.initUrl("collector.test");
+    tracker.setPriority(SnowPlowTracker::eNormalPriority);
+    HeapCounter::reset();
+    tracker.trackStructEvent("cat", "act", NULL, NULL, 0);
+    CHECK_EQUAL(0ul, HeapCounter::getAllocations());
+
+    tracker.setAsync(true);
+    CHECK_EQUAL(1ul, HeapCounter::getAllocations());
+    tracker.setAsync(false);
+    tracker.setAsync(true);
+    CHECK_EQUAL(1ul, HeapCounter::getAllocations());
+    tracker.setPriority(SnowPlowTracker::eHighPriority);
+    tracker.setPriority(SnowPlowTracker::eNormalPriority);
+    tracker.setPriority(SnowPlowTracker::eHighPriority);
+    CHECK_EQUAL(2ul, HeapCounter::getAllocations());
+    CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, 1));
+    tracker.setPriority(SnowPlowTracker::eNormalPriority);
+
+    // Swapping in the sketch's own frees ours, dropping what it held
+    CHECK_EQUAL(0ul, HeapCounter::getFrees());
+    tracker.setQueue(priorityQueueBuffer, sizeof(priorityQueueBuffer), SnowPlowTracker::eHighPriority);
+    CHECK_EQUAL(1ul, HeapCounter::getFrees());
+    CHECK_EQUAL(1ul, tracker.getDroppedEvents());
+    CHECK_EQUAL(0u, tracker.getQueuedEvents());
+  }
+  {
+    // Given buffers of the sketch's own first, it takes none
+    SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+    tracker.initUrl("collector.test");
+    HeapCounter::reset();
+    tracker.setQueue(queueBuffer, sizeof(queueBuffer));
+    tracker.setQueue(priorityQueueBuffer, sizeof(priorityQueueBuffer), SnowPlowTracker::eHighPriority);
+    tracker.setAsync(true);
+    tracker.setPriority(SnowPlowTracker::eHighPriority);
+    CHECK_EQUAL(0ul, HeapCounter::getAllocations());
+  }
+  {
+    // With no queue at all, events are turned away
+    SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+    init(tracker);
+    tracker.setQueue(NULL, 0);
+    CHECK_EQUAL(SnowPlowTracker::ERROR_BUSY, tracker.trackStructEvent("cat", "act"));
+    CHECK_EQUAL(1ul, tracker.getDroppedEvents());
+  }
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testDropOldest);
+  RUN_TEST(testDropNewest);
+  RUN_TEST(testBlock);
+  RUN_TEST(testTooLarge);
+  RUN_TEST(testPriorityTooLarge);
+  RUN_TEST(testQueueBuffers);
+  return checkResult();
+}
@@ -0,0 +1,252 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <vector>
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+static const char kUnavailable[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+static const char kOk[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+/*
+ * Calls update() a ms of virtual time
+ * at a time for aMs ms, noting the time
+ * each request reaches the collector.
+ */
+static std::vector<unsigned long> run(SnowPlowTracker &aTracker, const MockCollector &aCollector, const unsigned long aMs) {
+  std::vector<unsigned long> times;
+  for (unsigned long i = 0; i < aMs; i++) {
+    const size_t before = aCollector.getRequests().size();
+    aTracker.update();
+    if (aCollector.getRequests().size() > before) {
+      times.push_back(millis());
+    }
+    HostClock::advance(1);
+  }
+  return times;
+}
+
+/*
+ * Checks the wait between request
+ * aIndex and the one before it was
+ * picked from the top half of aWait
+ * (give or take the ms run() steps).
+ */
+static void checkWait(const std::vector<unsigned long> &aTimes, const size_t aIndex, const unsigned long aWait) {
+  CHECK(aIndex < aTimes.size());
+  if (aIndex < aTimes.size()) {
+    const unsigned long wait = aTimes[aIndex] - aTimes[aIndex - 1];
+    CHECK(wait >= aWait / 2);
+    CHECK(wait <= aWait + 2);
+  }
+}
+
+/*
+ * A queued event the collector fails
+ * on is retried aMaxRetries times,
+ * doubling the back-off each time up
+ * to aMaxDelay, then given up on.
+ */
+static void testRetries() {
+  HostClock::useVirtualTime(1000);
+  MockCollector collector;
+  collector.setResponse(kUnavailable);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setRetryPolicy(4, 1000, 4000);
+  tracker.setCircuitBreaker(0);
+
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  const std::vector<unsigned long> times = run(tracker, collector, 30000);
+  CHECK_EQUAL((size_t)5, times.size());
+  checkWait(times, 1, 1000);
+  checkWait(times, 2, 2000);
+  checkWait(times, 3, 4000);
+  checkWait(times, 4, 4000); // Capped
+
+  CHECK(!tracker.isBusy());
+  CHECK_EQUAL(4ul, tracker.getMetrics().retries);
+  CHECK_EQUAL(5ul, tracker.getMetrics().getFailed(SnowPlowTracker::ERROR_HTTP_STATUS));
+  CHECK_EQUAL(0ul, tracker.getMetrics().sent);
+}
+
+/*
+ * A success ends the back-off and
+ * starts the next failure's over from
+ * the base delay.
+ */
+static void testRecovery() {
+  HostClock::useVirtualTime(1000);
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setRetryPolicy(3, 1000, 60000);
+  tracker.setCircuitBreaker(0);
+
+  collector.queueResponse(kUnavailable);
+  collector.queueResponse(kUnavailable);
+  collector.queueResponse(kOk);
+  collector.queueResponse(kUnavailable);
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, 1));
+  std::vector<unsigned long> times = run(tracker, collector, 10000);
+  CHECK_EQUAL((size_t)3, times.size());
+  CHECK_EQUAL(1ul, tracker.getMetrics().sent);
+
+  // The next event goes straight away, and its retry after the base delay
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, 2));
+  times = run(tracker, collector, 10000);
+  CHECK_EQUAL((size_t)2, times.size());
+  checkWait(times, 1, 1000);
+  CHECK_EQUAL(2ul, tracker.getMetrics().sent);
+  CHECK(!tracker.isBusy());
+}
+
+/*
+ * flush() waits out the back-off left
+ * (and no longer) before trying again.
+ */
+static void testFlushWaits() {
+  HostClock::useVirtualTime(1000);
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setRetryPolicy(3, 1000, 60000);
+  tracker.setCircuitBreaker(0);
+
+  collector.queueResponse(kUnavailable);
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  run(tracker, collector, 100);
+  CHECK_EQUAL((size_t)1, collector.getRequests().size());
+  CHECK(tracker.isBusy());
+
+  const unsigned long start = millis();
+  tracker.flush();
+  const unsigned long waited = millis() - start;
+  CHECK_EQUAL((size_t)2, collector.getRequests().size());
+  CHECK(waited >= 500 - 100);
+  CHECK(waited <= 1000 - 100);
+  CHECK(!tracker.isBusy());
+
+  // With no back-off left, it doesn't wait at all
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  const unsigned long now = millis();
+  tracker.flush();
+  CHECK_EQUAL(now, millis());
+  CHECK_EQUAL((size_t)3, collector.getRequests().size());
+}
+
+/*
+ * After aThreshold failures in a row
+ * the circuit breaker opens: blocking
+ * events fail straightaway without
+ * trying the collector. After the
+ * cooling-off period one request is let
+ * through; a failure opens it again,
+ * a success closes it.
+ */
+static void testCircuitBreaker() {
+  HostClock::useVirtualTime(1000);
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setCircuitBreaker(3, 60000);
+
+  collector.setRefusing(true);
+  for (int i = 0; i < 3; i++) {
+    CHECK(!tracker.isCircuitOpen());
+    CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act"));
+  }
+  CHECK(tracker.isCircuitOpen());
+
+  // Open: nothing reaches the collector, even once it's back
+  collector.setRefusing(false);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CIRCUIT_OPEN, tracker.trackStructEvent("cat", "act"));
+  HostClock::advance(59000);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CIRCUIT_OPEN, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL((size_t)0, collector.getRequests().size());
+  CHECK_EQUAL(2ul, tracker.getMetrics().getFailed(SnowPlowTracker::ERROR_CIRCUIT_OPEN));
+
+  // Half open: one failure opens it for another cooling-off period
+  HostClock::advance(1000);
+  CHECK(!tracker.isCircuitOpen());
+  collector.queueResponse(kUnavailable);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_HTTP_STATUS, tracker.trackStructEvent("cat", "act"));
+  CHECK(tracker.isCircuitOpen());
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CIRCUIT_OPEN, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL((size_t)1, collector.getRequests().size());
+
+  // And one success closes it
+  HostClock::advance(60000);
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK(!tracker.isCircuitOpen());
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act"));
+  CHECK_EQUAL((size_t)3, collector.getRequests().size());
+}
+
+/*
+ * In async mode an open breaker holds
+ * queued events rather than failing
+ * them, and flush() doesn't sit out
+ * the cooling-off period.
+ */
+static void testCircuitBreakerQueued() {
+  HostClock::useVirtualTime(1000);
+  MockCollector collector;
+  collector.setResponse(kUnavailable);
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setRetryPolicy(10, 100, 100);
+  tracker.setCircuitBreaker(2, 60000);
+
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  run(tracker, collector, 1000);
+  CHECK(tracker.isCircuitOpen());
+  CHECK_EQUAL((size_t)2, collector.getRequests().size());
+  CHECK_EQUAL((size_t)1, tracker.getQueuedEvents());
+
+  const unsigned long start = millis();
+  tracker.flush();
+  CHECK_EQUAL(start, millis());
+  CHECK_EQUAL((size_t)2, collector.getRequests().size());
+
+  // Once it's cooled off, the event goes
+  collector.setResponse(kOk);
+  run(tracker, collector, 60000);
+  CHECK_EQUAL((size_t)3, collector.getRequests().size());
+  CHECK(!tracker.isBusy());
+  CHECK_EQUAL(1ul, tracker.getMetrics().sent);
+}
+
+int main() {
+  RUN_TEST(testRetries);
+  RUN_TEST(testRecovery);
+  RUN_TEST(testFlushWaits);
+  RUN_TEST(testCircuitBreaker);
+  RUN_TEST(testCircuitBreakerQueued);
+  return checkResult();
+}
@@ -0,0 +1,226 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <string>
+#include <vector>
+#include <SnowPlowTracker.h>
+#include <SnowPlowSerialTransport.h>
+#include "HostClock.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+// Both ends of a serial link: what the transport wrote, and what it's yet to read
+class LinkStream : public Stream
+{
+ public:
+  LinkStream() : readAt(0) {}
+
+  virtual size_t write(uint8_t aByte) {
+    this->written += (char)aByte;
+    return 1;
+  }
+  using Print::write;
+  virtual int available() { return (int)(this->toRead.size() - this->readAt); }
+  virtual int read() { return (available() > 0) ? (byte)this->toRead[this->readAt++] : -1; }
+  virtual int peek() { return (available() > 0) ? (byte)this->toRead[this->readAt] : -1; }
+
+  std::string written;
+  std::string toRead;
+  size_t readAt;
+};
+
+// The gateway's end of the framing
+static byte crc8(const std::string &aBytes) {
+  byte crc = 0;
+  for (size_t i = 0; i < aBytes.size(); i++) {
+    crc ^= (byte)aBytes[i];
+    for (byte j = 0; j < 8; j++) {
+      crc = (crc & 0x80) ? (byte)((crc << 1) ^ 0x07) : (byte)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static std::string frame(const std::string &aBody) {
+  const std::string unescaped = aBody + (char)crc8(aBody);
+  std::string framed(1, (char)0x7E);
+  for (size_t i = 0; i < unescaped.size(); i++) {
+    const byte c = (byte)unescaped[i];
+    if ((c == 0x7E) || (c == 0x7D)) {
+      framed += (char)0x7D;
+      framed += (char)(c ^ 0x20);
+    } else {
+      framed += (char)c;
+    }
+  }
+  return framed;
+}
+
+static std::string ack(const byte aSequence, const int aStatus) {
+  std::string body = "A";
+  body += (char)aSequence;
+  body += (char)(aStatus & 0xFF);
+  body += (char)(aStatus >> 8);
+  return frame(body);
+}
+
+// Splits what was written into frames, unescaped, checking each one's CRC
+static std::vector<std::string> frames(const std::string &aWritten) {
+  std::vector<std::string> result;
+  for (size_t i = 0; i < aWritten.size(); i++) {
+    if ((byte)aWritten[i] == 0x7E) {
+      result.push_back(std::string());
+    } else if (result.empty()) {
+      CHECK(!"bytes before the first 0x7E");
+    } else if ((byte)aWritten[i] == 0x7D) {
+      CHECK(i + 1 < aWritten.size());
+      i++;
+      result.back() += (char)(aWritten[i] ^ 0x20);
+    } else {
+      result.back() += aWritten[i];
+    }
+  }
+  for (size_t i = 0; i < result.size(); i++) {
+    CHECK(result[i].size() >= 3);
+    CHECK_EQUAL((int)crc8(result[i].substr(0, result[i].size() - 1)), (int)(byte)result[i][result[i].size() - 1]);
+  }
+  return result;
+}
+
+static int lastStatus = 0;
+
+static void trackCallback(const int aStatus) {
+  lastStatus = aStatus;
+}
+
+static void init(SnowPlowTracker &aTracker, SnowPlowSerialTransport &aGateway) {
+  aTracker.initTransport(&aGateway);
+  aTracker.setAsync(true);
+  aTracker.setTrackCallback(trackCallback);
+  lastStatus = 0;
+}
+
+/*
+ * Bytes that would be taken for a
+ * frame's start (0x7E, '~') or an
+ * escape (0x7D, '}') are escaped
+ * wherever they turn up, and come out
+ * of the frame as they went in.
+ */
+static void testEscaping() {
+  LinkStream link;
+  SnowPlowSerialTransport gateway(link);
+  SnowPlowTracker tracker((EthernetClass *)NULL, kMac, "test-app");
+  init(tracker, gateway);
+  tracker.setUserId("user~}");
+
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", "~}~", "}}"));
+  tracker.update();
+  const std::vector<std::string> written = frames(link.written);
+  CHECK_EQUAL((size_t)2, written.size());
+  if (written.size() == 2) {
+    CHECK_EQUAL('C', written[0][0]);
+    CHECK_CONTAINS(written[0], "uid=user~%7d");
+    CHECK_EQUAL('E', written[1][0]);
+    CHECK_CONTAINS(written[1], "~}~");
+    CHECK_CONTAINS(written[1], "}}");
+  }
+  CHECK_EQUAL((unsigned long)link.written.size(), gateway.getBytesWritten());
+}
+
+/*
+ * Acks are unescaped as they're read,
+ * whatever the sequence number and CRC
+ * come to: run the sequence numbers
+ * all the way round.
+ */
+static void testAcks() {
+  LinkStream link;
+  SnowPlowSerialTransport gateway(link);
+  SnowPlowTracker tracker((EthernetClass *)NULL, kMac, "test-app");
+  init(tracker, gateway);
+
+  int escaped = 0;
+  for (int i = 0; i < 300; i++) {
+    link.written.clear();
+    CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+    tracker.update();
+    const std::vector<std::string> written = frames(link.written);
+    CHECK(!written.empty());
+    if (written.empty()) {
+      return;
+    }
+    const byte sequence = (byte)written.back()[1];
+    const std::string reply = ack(sequence, 200 + i % 7);
+    escaped += (reply.find((char)0x7D) != std::string::npos) ? 1 : 0;
+    link.toRead += reply;
+    tracker.update();
+    CHECK_EQUAL(200 + i % 7, lastStatus);
+    CHECK(!tracker.isBusy());
+  }
+  CHECK(escaped > 0);
+}
+
+/*
+ * After losing part of a frame, the
+ * reader picks up at the next 0x7E,
+ * and ignores acks that don't check
+ * out or aren't ours.
+ */
+static void testResync() {
+  HostClock::useVirtualTime(1000);
+  LinkStream link;
+  SnowPlowSerialTransport gateway(link, 1000);
+  SnowPlowTracker tracker((EthernetClass *)NULL, kMac, "test-app");
+  init(tracker, gateway);
+  tracker.setRetryPolicy(0);
+
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  tracker.update();
+  const byte sequence = (byte)frames(link.written).back()[1];
+
+  // The start of an ack cut short, one with a bad CRC and one for another request
+  std::string bad = ack(sequence, 200);
+  bad[bad.size() - 1] ^= 0x01;
+  link.toRead = ack(sequence, 200).substr(0, 3) + bad + ack(sequence + 1, 200) + "noise";
+  tracker.update();
+  CHECK(tracker.isBusy());
+
+  link.toRead += ack(sequence, 201);
+  tracker.update();
+  CHECK_EQUAL(201, lastStatus);
+
+  // And with no ack at all, it times out
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act"));
+  tracker.update();
+  HostClock::advance(1000);
+  tracker.update();
+  CHECK_EQUAL(SnowPlowTracker::ERROR_TIMED_OUT, lastStatus);
+  HostClock::useRealTime();
+}
+
+int main() {
+  RUN_TEST(testEscaping);
+  RUN_TEST(testAcks);
+  RUN_TEST(testResync);
+  return checkResult();
+}
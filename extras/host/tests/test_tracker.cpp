@@ -0,0 +1,273 @@
+/* 
+ * SnowPlow Arduino Tracker
+ *
+ * @description Arduino tracker for SnowPlow
+ * @version     0.1.0
+ * @author      Alex Dean
+ * @copyright   SnowPlow Analytics Ltd
+ * @license     Apache License Version 2.0
+ *
+ * Copyright (c) 2012-2013 SnowPlow Analytics Ltd. All rights reserved.
+ *
+ * This program is licensed to you under the Apache License Version 2.0,
+ * and you may not use this file except in compliance with the Apache License Version 2.0.
+ * You may obtain a copy of the Apache License Version 2.0 at http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the Apache License Version 2.0 is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Apache License Version 2.0 for the specific language governing permissions and limitations there under.
+ */
+
+#include <cmath>
+#include <SnowPlowTracker.h>
+#include "HostClock.h"
+#include "MockCollector.h"
+#include "Check.h"
+
+static const byte kMac[] = { 0x90, 0xA2, 0xDA, 0x00, 0xF8, 0xA0 };
+
+/*
+ * A blocking trackStructEvent() sends a
+ * GET to /i with the event and our
+ * context on the querystring, and
+ * returns the collector's status.
+ */
+static void testBlockingGet() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setUserId("test-user");
+
+  CHECK_EQUAL(200, tracker.trackStructEvent("cat", "act", "lab", "prop", 42));
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  const MockCollector::Request &request = collector.getRequests()[0];
+  CHECK_EQUAL(std::string("GET"), request.method);
+  CHECK_CONTAINS(request.target, "/i?tid=");
+  CHECK_CONTAINS(request.target, "&p=iot&mac=90%3aA2%3aDA%3a00%3aF8%3aA0&uid=test-user&aid=test-app&tv=arduino-0.1.0");
+  CHECK_CONTAINS(request.target, "&e=se&ev_ca=cat&ev_ac=act&ev_la=lab&ev_pr=prop&ev_va=42.0");
+  CHECK_EQUAL(std::string("collector.test"), MockCollector::getHeader(request, "host"));
+  CHECK_EQUAL(std::string("close"), MockCollector::getHeader(request, "connection"));
+  CHECK_EQUAL(collector.getBytesReceived(), tracker.getBytesWritten());
+}
+
+/*
+ * Each overload writes its value the
+ * way the collector expects.
+ */
+static void testValues() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+
+  tracker.trackStructEvent("cat", "act");
+  tracker.trackStructEvent("cat", "act", NULL, NULL, -7);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 2.5, 3);
+  tracker.trackStructEvent("cat", "act", "a b&c", NULL, 0.125f, 1);
+  CHECK_EQUAL(4u, collector.getRequests().size());
+  CHECK(collector.getRequests()[0].target.find("ev_va") == std::string::npos);
+  CHECK_CONTAINS(collector.getRequests()[1].target, "&ev_va=-7.0");
+  CHECK_CONTAINS(collector.getRequests()[2].target, "&ev_va=2.500");
+  CHECK_CONTAINS(collector.getRequests()[3].target, "&ev_la=a%20b%26c&ev_va=0.1");
+}
+
+/*
+ * Values too big for an unsigned long
+ * keep their digits, and NaN or infinity
+ * leave ev_va out rather than send
+ * something the collector can't read.
+ */
+static void testUnusualValues() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 6.02e23, 2);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, -5e9f, 0);
+  tracker.trackStructEvent("cat", "act", "nan", NULL, NAN, 2);
+  tracker.trackStructEvent("cat", "act", "inf", NULL, -INFINITY, 2);
+  CHECK_EQUAL(4u, collector.getRequests().size());
+  CHECK_CONTAINS(collector.getRequests()[0].target, "&ev_ac=act&ev_va=6.02e23");
+  CHECK_CONTAINS(collector.getRequests()[1].target, "&ev_ac=act&ev_va=-5e9");
+  CHECK_CONTAINS(collector.getRequests()[2].target, "&ev_ac=act&ev_la=nan");
+  CHECK_CONTAINS(collector.getRequests()[3].target, "&ev_ac=act&ev_la=inf");
+  for (size_t i = 2; i < 4; i++) {
+    CHECK(collector.getRequests()[i].target.find("ev_va") == std::string::npos);
+  }
+}
+
+/*
+ * In async mode events are queued, and
+ * update() sends them one at a time.
+ */
+static void testAsync() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+
+  for (int i = 0; i < 3; i++) {
+    CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", NULL, NULL, i));
+  }
+  CHECK_EQUAL(3u, tracker.getQueuedEvents());
+  CHECK_EQUAL(0u, collector.getRequests().size());
+
+  for (int i = 0; (i < 100) && tracker.isBusy(); i++) {
+    tracker.update();
+  }
+  CHECK(!tracker.isBusy());
+  CHECK_EQUAL(3u, collector.getRequests().size());
+  CHECK_EQUAL(3ul, tracker.getMetrics().sent);
+}
+
+/*
+ * By default the priority queue holds
+ * the longest event, and tracking into
+ * a full one drops rather than sends.
+ */
+static void testPriorityDefaults() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setPriority(SnowPlowTracker::eHighPriority);
+
+  const std::string label(150, 'x');
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", label.c_str()));
+  CHECK_EQUAL(SnowPlowTracker::EVENT_QUEUED, tracker.trackStructEvent("cat", "act", label.c_str()));
+  CHECK_EQUAL(1u, tracker.getQueuedEvents());
+  CHECK_EQUAL(1ul, tracker.getDroppedEvents());
+  CHECK_EQUAL(0u, collector.getRequests().size());
+}
+
+/*
+ * Batches are POSTed to tp2 as
+ * payload_data JSON, every value a
+ * string.
+ */
+static void testBatchPost() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setAsync(true);
+  tracker.setBatching(3);
+
+  tracker.trackStructEvent("cat", "act", "say \"hi\"\\\n", NULL, 1);
+  tracker.trackStructEvent("cat", "act", NULL, NULL, 2.5, 1);
+  tracker.trackStructEvent("cat", "act", "a&b=c", "prop");
+  for (int i = 0; (i < 100) && tracker.isBusy(); i++) {
+    tracker.update();
+  }
+  CHECK_EQUAL(1u, collector.getRequests().size());
+  const MockCollector::Request &request = collector.getRequests()[0];
+  CHECK_EQUAL(std::string("POST"), request.method);
+  CHECK_EQUAL(std::string("/com.snowplowanalytics.snowplow/tp2"), request.target);
+  CHECK_EQUAL(std::string("application/json; charset=utf-8"), MockCollector::getHeader(request, "content-type"));
+
+  const std::string &body = request.body;
+  CHECK_EQUAL(0u, body.find("{\"schema\":\"iglu:com.snowplowanalytics.snowplow/payload_data/jsonschema/1-0-4\",\"data\":[{\"tid\":\""));
+  CHECK_EQUAL(body.size() - 4, body.rfind("\"}]}"));
+  CHECK_CONTAINS(body, "\",\"p\":\"iot\",\"mac\":\"90:A2:DA:00:F8:A0\",\"aid\":\"test-app\",\"tv\":\"arduino-0.1.0\",\"dtm\":\"");
+  CHECK_CONTAINS(body, "\",\"e\":\"se\",\"ev_ca\":\"cat\",\"ev_ac\":\"act\",\"ev_la\":\"say \\\"hi\\\"\\\\\\u000a\",\"ev_va\":\"1.0\"},{\"tid\":\"");
+  CHECK_CONTAINS(body, "\"ev_va\":\"2.5\"},{");
+  CHECK_CONTAINS(body, "\"ev_la\":\"a&b=c\",\"ev_pr\":\"prop\"}]}");
+}
+
+// Undoes the tracker's URL-encoding of a querystring value
+static std::string urlDecode(const std::string &aValue) {
+  std::string decoded;
+  for (size_t i = 0; i < aValue.size(); i++) {
+    if ((aValue[i] == '%') && (i + 2 < aValue.size())) {
+      decoded += (char)strtol(aValue.substr(i + 1, 2).c_str(), NULL, 16);
+      i += 2;
+    } else {
+      decoded += aValue[i];
+    }
+  }
+  return decoded;
+}
+
+/*
+ * Metrics go as an unstructured event,
+ * its ue_pr a self-describing JSON of
+ * the counts as they were when it was
+ * tracked: URL-encoded in a GET, a
+ * JSON string in a batch.
+ */
+static void testMetrics() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+  tracker.setMetricsInterval(1000);
+
+  collector.queueResponse("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+  tracker.trackStructEvent("cat", "act");
+  tracker.trackStructEvent("cat", "act");
+  HostClock::advance(1000);
+  tracker.update();
+  CHECK_EQUAL(3u, collector.getRequests().size());
+  const std::string &target = collector.getRequests()[2].target;
+  CHECK_CONTAINS(target, "&e=ue&ue_pr=");
+  CHECK(target.find("ev_ca") == std::string::npos);
+
+  const std::string json = urlDecode(target.substr(target.find("&ue_pr=") + 7));
+  CHECK_EQUAL(0u, json.find("{\"schema\":\"iglu:com.snowplowanalytics.snowplow/unstruct_event/jsonschema/1-0-0\","
+                            "\"data\":{\"schema\":\"iglu:com.snowplowanalytics.arduino/tracker_metrics/jsonschema/1-0-0\","
+                            "\"data\":{\"tracked\":2,\"sent\":1,\"failed\":[0,0,0,0,1,0,0,0],\"retries\":0,\"dropped\":0,"
+                            "\"bytesWritten\":"));
+  CHECK_CONTAINS(json, ",\"wakes\":0,\"onTimePerEvent\":0,\"connect\":{\"mean\":");
+  CHECK_CONTAINS(json, "},\"response\":{\"mean\":");
+  CHECK_EQUAL(json.size() - 4, json.rfind("}}}}"));
+
+  // In a batch, the same JSON as a string
+  tracker.setAsync(true);
+  tracker.setBatching(2);
+  tracker.trackStructEvent("cat", "act");
+  HostClock::advance(1000);
+  for (int i = 0; (i < 100) && tracker.isBusy(); i++) {
+    tracker.update();
+  }
+  CHECK_EQUAL(4u, collector.getRequests().size());
+  const std::string &body = collector.getRequests()[3].body;
+  CHECK_CONTAINS(body, ",\"e\":\"ue\",\"ue_pr\":\"{\\\"schema\\\":\\\"iglu:com.snowplowanalytics.snowplow/unstruct_event/jsonschema/1-0-0\\\",");
+  CHECK_CONTAINS(body, "\\\"data\\\":{\\\"tracked\\\":4,\\\"sent\\\":2,");
+  CHECK_EQUAL(body.size() - 8, body.rfind("}}}}\"}]}"));
+}
+
+/*
+ * Failures come back as ERROR_* values.
+ */
+static void testErrors() {
+  MockCollector collector;
+  SnowPlowTracker tracker(&Ethernet, kMac, "test-app");
+  tracker.initUrl("collector.test");
+
+  CHECK_EQUAL(SnowPlowTracker::ERROR_MISSING_ARGUMENT, tracker.trackStructEvent(NULL, "act"));
+
+  collector.queueResponse("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+  CHECK_EQUAL(SnowPlowTracker::ERROR_HTTP_STATUS, tracker.trackStructEvent("cat", "act"));
+
+  collector.queueResponse("garbage\r\n\r\n");
+  CHECK_EQUAL(SnowPlowTracker::ERROR_INVALID_RESPONSE, tracker.trackStructEvent("cat", "act"));
+
+  collector.setRefusing(true);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_CONNECTION_FAILED, tracker.trackStructEvent("cat", "act"));
+  collector.setRefusing(false);
+
+  collector.setSilent(true);
+  tracker.setResponseTimeout(500);
+  CHECK_EQUAL(SnowPlowTracker::ERROR_TIMED_OUT, tracker.trackStructEvent("cat", "act"));
+}
+
+int main() {
+  HostClock::useVirtualTime();
+  RUN_TEST(testBlockingGet);
+  RUN_TEST(testValues);
+  RUN_TEST(testUnusualValues);
+  RUN_TEST(testAsync);
+  RUN_TEST(testPriorityDefaults);
+  RUN_TEST(testBatchPost);
+  RUN_TEST(testMetrics);
+  RUN_TEST(testErrors);
+  return checkResult();
+}